@@ -0,0 +1,601 @@
+#include "AIStrategy.h"
+
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const int NumCells = 9;
+    const int NumPositions = 19683;  //3^9
+
+    //how often (in nodes/iterations) the searches look at the clock and the cancel token
+    const int ClockCheckInterval = 256;
+
+    //a few thousand positions is all a busy server ever sees, 64KB holds them with room to spare
+    const size_t PositionCacheSlots = 8192;
+
+    //every position this many moves in or fewer gets solved up front and pinned
+    const int BookPlies = 2;
+
+    //scores are from the point of view of the side to move, a quicker win is worth more
+    int terminalScore(const BoardSnapshot& board, uint8_t side)
+    {
+        uint8_t winner = board.winner();
+        if (winner == BoardSnapshot::Empty)
+            return 0;
+        int score = 10 - board.numMoves();
+        return winner == side ? score : -score;
+    }
+
+    struct NegamaxSearch
+    {
+        NegamaxSearch(const AISearchLimits& limits) : limits(limits), nodes(0), outOfTime(false) {}
+
+        int run(BoardSnapshot& board, uint8_t side, int depthLeft, int alpha, int beta)
+        {
+            if (board.isGameOver())
+                return terminalScore(board, side);
+
+            //not solved at this depth, call it even
+            if (depthLeft == 0)
+                return 0;
+
+            if ((++nodes % ClockCheckInterval) == 0 && limits.shouldStop())
+                outOfTime = true;
+            if (outOfTime)
+                return 0;
+
+            int best = -100;
+            for (int cell = 0; cell < NumCells; ++cell)
+            {
+                if (board.cells[cell] != BoardSnapshot::Empty)
+                    continue;
+
+                board.cells[cell] = side;
+                int score = -run(board, BoardSnapshot::opponent(side), depthLeft - 1, -beta, -alpha);
+                board.cells[cell] = BoardSnapshot::Empty;
+
+                if (score > best)
+                    best = score;
+                if (best > alpha)
+                    alpha = best;
+                if (alpha >= beta)
+                    break;
+            }
+            return best;
+        }
+
+        const AISearchLimits& limits;
+        uint64_t nodes;
+        bool outOfTime;
+    };
+
+    //iterative deepening over the root moves.  solved says the last complete depth went all the
+    //way to the end of the game, which makes the answer (and bestScore) exact and the same every time.
+    int searchRoot(const BoardSnapshot& board, const AISearchLimits& limits, int& bestScore, bool& solved)
+    {
+        BoardSnapshot scratch = board;
+        uint8_t side = board.sideToMove();
+        int emptyCells = NumCells - board.numMoves();
+
+        NegamaxSearch negamax(limits);
+        int bestCell = -1;
+        bestScore = 0;
+        solved = false;
+
+        for (int depth = 1; depth <= emptyCells; ++depth)
+        {
+            int depthBestCell = -1;
+            int depthBestScore = -100;
+            int alpha = -100;
+
+            //try last iteration's best move first, it makes the cutoffs work
+            int order[NumCells];
+            int numOrdered = 0;
+            if (bestCell >= 0)
+                order[numOrdered++] = bestCell;
+            for (int cell = 0; cell < NumCells; ++cell)
+                if (cell != bestCell && scratch.cells[cell] == BoardSnapshot::Empty)
+                    order[numOrdered++] = cell;
+
+            for (int i = 0; i < numOrdered; ++i)
+            {
+                int cell = order[i];
+                scratch.cells[cell] = side;
+                int score = -negamax.run(scratch, BoardSnapshot::opponent(side), depth - 1, -100, -alpha);
+                scratch.cells[cell] = BoardSnapshot::Empty;
+
+                if (score > depthBestScore)
+                {
+                    depthBestScore = score;
+                    depthBestCell = cell;
+                }
+                if (score > alpha)
+                    alpha = score;
+            }
+
+            //a half finished depth can't be trusted, keep the last complete answer
+            if (negamax.outOfTime)
+                break;
+
+            bestCell = depthBestCell;
+            bestScore = depthBestScore;
+            solved = depth == emptyCells;
+        }
+
+        return bestCell;
+    }
+
+    //the whole game fits in a table small enough to fill at startup.
+    //indexed by base 3 encoding of the cells, one half for each side to move.
+    class SolvedTable
+    {
+    public:
+        SolvedTable()
+        {
+            int power = 1;
+            for (int i = 0; i < NumCells; ++i)
+            {
+                m_powers[i] = power;
+                power *= 3;
+            }
+
+            m_entries.assign(NumPositions * 2, Entry());
+
+            BoardSnapshot board;
+            for (int code = 0; code < NumPositions; ++code)
+            {
+                int remaining = code;
+                for (int i = 0; i < NumCells; ++i)
+                {
+                    board.cells[i] = static_cast<uint8_t>(remaining % 3);
+                    remaining /= 3;
+                }
+                solve(board, code, BoardSnapshot::Player);
+                solve(board, code, BoardSnapshot::AI);
+            }
+        }
+
+        int bestMove(const BoardSnapshot& board, uint8_t side) const
+        {
+            return m_entries[entryIndex(encode(board), side)].bestMove;
+        }
+
+    protected:
+        struct Entry
+        {
+            Entry() : solved(false), score(0), bestMove(-1) {}
+            bool solved;
+            int8_t score;
+            int8_t bestMove;
+        };
+
+        int encode(const BoardSnapshot& board) const
+        {
+            int code = 0;
+            for (int i = 0; i < NumCells; ++i)
+                code += board.cells[i] * m_powers[i];
+            return code;
+        }
+
+        static int entryIndex(int code, uint8_t side)
+        {
+            return (side == BoardSnapshot::Player ? 0 : NumPositions) + code;
+        }
+
+        int solve(BoardSnapshot& board, int code, uint8_t side)
+        {
+            Entry& entry = m_entries[entryIndex(code, side)];
+            if (entry.solved)
+                return entry.score;
+
+            entry.solved = true;
+            if (board.isGameOver())
+            {
+                entry.score = static_cast<int8_t>(terminalScore(board, side));
+                return entry.score;
+            }
+
+            int best = -100;
+            for (int cell = 0; cell < NumCells; ++cell)
+            {
+                if (board.cells[cell] != BoardSnapshot::Empty)
+                    continue;
+
+                board.cells[cell] = side;
+                int score = -solve(board, code + (side * m_powers[cell]), BoardSnapshot::opponent(side));
+                board.cells[cell] = BoardSnapshot::Empty;
+
+                if (score > best)
+                {
+                    best = score;
+                    entry.bestMove = static_cast<int8_t>(cell);
+                }
+            }
+            entry.score = static_cast<int8_t>(best);
+            return best;
+        }
+
+        int m_powers[NumCells];
+        std::vector<Entry> m_entries;
+    };
+
+    struct MonteCarloNode
+    {
+        int parent;
+        int firstChild;
+        int numChildren;  //-1 until expanded
+        int move;
+        uint8_t justMoved;
+        uint32_t visits;
+        double reward;  //from justMoved's point of view
+    };
+}
+
+std::shared_ptr<AIStrategy> AIStrategy::create(Type type)
+{
+    switch (type)
+    {
+    case Random:
+        return std::make_shared<RandomStrategy>();
+    case PerfectTable:
+        return std::make_shared<PerfectTableStrategy>();
+    case Minimax:
+        return std::make_shared<MinimaxStrategy>();
+    case MonteCarlo:
+        return std::make_shared<MonteCarloStrategy>();
+    case FirstFree:
+    default:
+        return std::make_shared<FirstFreeStrategy>();
+    }
+}
+
+const char* AIStrategy::getTypeName(Type type)
+{
+    switch (type)
+    {
+    case FirstFree:
+        return "First Free";
+    case Random:
+        return "Random";
+    case PerfectTable:
+        return "Perfect Table";
+    case Minimax:
+        return "Minimax";
+    case MonteCarlo:
+        return "Monte Carlo";
+    default:
+        return "Unknown";
+    }
+}
+
+bool AIStrategy::parseType(const std::string& name, Type& type)
+{
+    static const char* shortNames[NumTypes] = { "first", "random", "perfect", "minimax", "mcts" };
+    for (int i = 0; i < NumTypes; ++i)
+    {
+        if (name == shortNames[i])
+        {
+            type = static_cast<Type>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+AIStrategy::AIStrategy(Type type, std::chrono::milliseconds deadline) : m_type(type), m_deadlineMs(deadline.count()), m_cancelledCount(0), m_rng(std::random_device()())
+{
+}
+
+AIStrategy::~AIStrategy()
+{
+}
+
+void AIStrategy::setDeadline(std::chrono::milliseconds deadline)
+{
+    m_deadlineMs = deadline.count();
+}
+
+std::chrono::milliseconds AIStrategy::getDeadline() const
+{
+    return std::chrono::milliseconds(m_deadlineMs.load());
+}
+
+uint32_t AIStrategy::nextSeed()
+{
+    std::lock_guard<std::mutex> lock(m_rngMutex);
+    return m_rng();
+}
+
+int AIStrategy::decideMove(const BoardSnapshot& board, const AICancelToken& cancel)
+{
+    AISearchLimits limits;
+    limits.deadline = Clock::now() + getDeadline();
+    limits.cancel = cancel;
+    limits.seed = nextSeed();
+    return decideMove(board, limits);
+}
+
+int AIStrategy::decideMove(const BoardSnapshot& board, uint32_t seed)
+{
+    AISearchLimits limits;
+    limits.deadline = Clock::time_point::max();
+    limits.seed = seed;
+    return decideMove(board, limits);
+}
+
+int AIStrategy::decideMove(const BoardSnapshot& board, const AISearchLimits& limits)
+{
+    if (board.isGameOver())
+        return -1;
+
+    auto start = Clock::now();
+
+    int cell = search(board, limits);
+
+    //nobody wants this answer anymore, don't let it skew the histogram either
+    if (limits.cancel.isCancelled())
+    {
+        ++m_cancelledCount;
+        return -1;
+    }
+
+    //a strategy that ran out of time or got confused still has to move
+    if (cell < 0 || cell >= NumCells || board.cells[cell] != BoardSnapshot::Empty)
+        cell = FirstFreeStrategy::firstFreeCell(board);
+
+    m_latency.record(Clock::now() - start);
+    return cell;
+}
+
+int FirstFreeStrategy::firstFreeCell(const BoardSnapshot& board)
+{
+    //column by column, same order the old "AI" walked the board
+    for (int x = 0; x <= 2; ++x)
+        for (int y = 0; y <= 2; ++y)
+            if (board.at(x, y) == BoardSnapshot::Empty)
+                return BoardSnapshot::index(x, y);
+    return -1;
+}
+
+int FirstFreeStrategy::search(const BoardSnapshot& board, const AISearchLimits&)
+{
+    return firstFreeCell(board);
+}
+
+int RandomStrategy::search(const BoardSnapshot& board, const AISearchLimits& limits)
+{
+    int freeCells[NumCells];
+    int numFree = 0;
+    for (int cell = 0; cell < NumCells; ++cell)
+        if (board.cells[cell] == BoardSnapshot::Empty)
+            freeCells[numFree++] = cell;
+
+    if (!numFree)
+        return -1;
+
+    std::minstd_rand rng(limits.seed);
+    return freeCells[std::uniform_int_distribution<int>(0, numFree - 1)(rng)];
+}
+
+namespace
+{
+    const SolvedTable& getSolvedTable()
+    {
+        //magic statics are thread safe, whoever asks first pays for the build
+        static const SolvedTable table;
+        return table;
+    }
+
+    //the same search minimax does with no deadline, so a book answer is exactly what it would have found
+    void addBookPositions(PositionCache& cache, BoardSnapshot& board, int pliesLeft)
+    {
+        if (board.isGameOver())
+            return;
+
+        AISearchLimits limits;
+        limits.deadline = Clock::time_point::max();
+        limits.seed = 0;
+
+        int bestScore;
+        bool solved;
+        int bestCell = searchRoot(board, limits, bestScore, solved);
+        cache.store(PositionCache::makeKey(board, board.sideToMove()), bestCell, bestScore, true);
+
+        if (pliesLeft == 0)
+            return;
+
+        uint8_t side = board.sideToMove();
+        for (int cell = 0; cell < NumCells; ++cell)
+        {
+            if (board.cells[cell] != BoardSnapshot::Empty)
+                continue;
+
+            board.cells[cell] = side;
+            board.usersTurn = !board.usersTurn;
+            addBookPositions(cache, board, pliesLeft - 1);
+            board.usersTurn = !board.usersTurn;
+            board.cells[cell] = BoardSnapshot::Empty;
+        }
+    }
+
+    PositionCache& buildPositionCache()
+    {
+        static PositionCache cache(PositionCacheSlots);
+
+        //either side can go first, so both get a book
+        BoardSnapshot board;
+        board.usersTurn = true;
+        addBookPositions(cache, board, BookPlies);
+        board.usersTurn = false;
+        addBookPositions(cache, board, BookPlies);
+        return cache;
+    }
+}
+
+void AIStrategy::prepareTables()
+{
+    getSolvedTable();
+    getPositionCache();
+}
+
+PositionCache& AIStrategy::getPositionCache()
+{
+    static PositionCache& cache = buildPositionCache();
+    return cache;
+}
+
+int PerfectTableStrategy::search(const BoardSnapshot& board, const AISearchLimits&)
+{
+    return getSolvedTable().bestMove(board, board.sideToMove());
+}
+
+int MinimaxStrategy::search(const BoardSnapshot& board, const AISearchLimits& limits)
+{
+    uint32_t key = PositionCache::makeKey(board, board.sideToMove());
+
+    //somebody (maybe us, maybe the book) already solved this one
+    PositionCache& cache = getPositionCache();
+    PositionCache::Entry entry;
+    if (cache.lookup(key, entry) && entry.bestMove >= 0)
+        return entry.bestMove;
+
+    int bestScore;
+    bool solved;
+    int bestCell = searchRoot(board, limits, bestScore, solved);
+
+    //only a search that got all the way to the end is the same answer for everybody
+    if (solved && bestCell >= 0)
+        cache.store(key, bestCell, bestScore);
+
+    return bestCell;
+}
+
+int MonteCarloStrategy::search(const BoardSnapshot& board, const AISearchLimits& limits)
+{
+    const double exploration = 1.41;
+    const size_t maxNodes = 200000;
+
+    std::minstd_rand rng(limits.seed);
+
+    std::vector<MonteCarloNode> nodes;
+    nodes.reserve(4096);
+
+    MonteCarloNode root;
+    root.parent = -1;
+    root.firstChild = 0;
+    root.numChildren = -1;
+    root.move = -1;
+    root.justMoved = BoardSnapshot::opponent(board.sideToMove());
+    root.visits = 0;
+    root.reward = 0.0;
+    nodes.push_back(root);
+
+    for (int iteration = 0; iteration < MaxIterations; ++iteration)
+    {
+        if ((iteration % ClockCheckInterval) == 0 && iteration && limits.shouldStop())
+            break;
+
+        BoardSnapshot scratch = board;
+        int nodeIndex = 0;
+
+        //selection
+        while (nodes[nodeIndex].numChildren > 0 && !scratch.isGameOver())
+        {
+            const MonteCarloNode& parent = nodes[nodeIndex];
+            double logVisits = std::log(static_cast<double>(parent.visits + 1));
+            int bestChild = -1;
+            double bestValue = -1.0;
+            for (int i = 0; i < parent.numChildren; ++i)
+            {
+                const MonteCarloNode& child = nodes[parent.firstChild + i];
+                if (!child.visits)
+                {
+                    bestChild = parent.firstChild + i;
+                    break;
+                }
+                double value = (child.reward / child.visits) + exploration * std::sqrt(logVisits / child.visits);
+                if (value > bestValue)
+                {
+                    bestValue = value;
+                    bestChild = parent.firstChild + i;
+                }
+            }
+            nodeIndex = bestChild;
+            scratch.cells[nodes[nodeIndex].move] = nodes[nodeIndex].justMoved;
+        }
+
+        //expansion
+        if (nodes[nodeIndex].numChildren < 0 && !scratch.isGameOver() && nodes.size() + NumCells < maxNodes)
+        {
+            uint8_t side = BoardSnapshot::opponent(nodes[nodeIndex].justMoved);
+            int firstChild = static_cast<int>(nodes.size());
+            int numChildren = 0;
+            for (int cell = 0; cell < NumCells; ++cell)
+            {
+                if (scratch.cells[cell] != BoardSnapshot::Empty)
+                    continue;
+
+                MonteCarloNode child;
+                child.parent = nodeIndex;
+                child.firstChild = 0;
+                child.numChildren = -1;
+                child.move = cell;
+                child.justMoved = side;
+                child.visits = 0;
+                child.reward = 0.0;
+                nodes.push_back(child);
+                ++numChildren;
+            }
+            nodes[nodeIndex].firstChild = firstChild;
+            nodes[nodeIndex].numChildren = numChildren;
+
+            nodeIndex = firstChild;
+            scratch.cells[nodes[nodeIndex].move] = nodes[nodeIndex].justMoved;
+        }
+
+        //random playout
+        uint8_t side = BoardSnapshot::opponent(nodes[nodeIndex].justMoved);
+        while (!scratch.isGameOver())
+        {
+            int freeCells[NumCells];
+            int numFree = 0;
+            for (int cell = 0; cell < NumCells; ++cell)
+                if (scratch.cells[cell] == BoardSnapshot::Empty)
+                    freeCells[numFree++] = cell;
+
+            scratch.cells[freeCells[rng() % numFree]] = side;
+            side = BoardSnapshot::opponent(side);
+        }
+
+        //backpropagate
+        uint8_t winner = scratch.winner();
+        while (nodeIndex >= 0)
+        {
+            MonteCarloNode& node = nodes[nodeIndex];
+            ++node.visits;
+            if (winner == BoardSnapshot::Empty)
+                node.reward += 0.5;
+            else if (winner == node.justMoved)
+                node.reward += 1.0;
+            nodeIndex = node.parent;
+        }
+    }
+
+    //most visited child is the most robust pick
+    const MonteCarloNode& rootNode = nodes[0];
+    int bestCell = -1;
+    uint32_t bestVisits = 0;
+    for (int i = 0; i < rootNode.numChildren; ++i)
+    {
+        const MonteCarloNode& child = nodes[rootNode.firstChild + i];
+        if (child.visits > bestVisits)
+        {
+            bestVisits = child.visits;
+            bestCell = child.move;
+        }
+    }
+    return bestCell;
+}
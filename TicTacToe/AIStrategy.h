@@ -0,0 +1,179 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+#include "LatencyHistogram.h"
+#include "PositionCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+
+//lets whoever asked for a move call it off.  GameMoveManager hands out one of these
+//stamped with the board generation; once the board moves on, the search is wasted work.
+class AICancelToken
+{
+public:
+    AICancelToken() : m_generation(nullptr), m_expectedGeneration(0) {}
+    AICancelToken(const std::atomic<uint64_t>* generation, uint64_t expectedGeneration) : m_generation(generation), m_expectedGeneration(expectedGeneration) {}
+
+    bool isCancelled() const
+    {
+        return m_generation && m_generation->load(std::memory_order_relaxed) != m_expectedGeneration;
+    }
+
+protected:
+    const std::atomic<uint64_t>* m_generation;
+    uint64_t m_expectedGeneration;
+};
+
+//what a search has to keep an eye on while it thinks
+struct AISearchLimits
+{
+    std::chrono::steady_clock::time_point deadline;
+    AICancelToken cancel;
+
+    //strategies seed their own local generators from this, never from anything else
+    uint32_t seed;
+
+    bool shouldStop() const { return cancel.isCancelled() || std::chrono::steady_clock::now() > deadline; }
+};
+
+//base class for anything that can pick the computer's next move.
+//strategies only ever see a BoardSnapshot, never the GameMoveManager, so
+//they can run without holding any game locks.  Each one has a deadline; long
+//searches are expected to check it and hand back their best move so far.
+class AIStrategy
+{
+public:
+    enum Type
+    {
+        FirstFree,
+        Random,
+        PerfectTable,
+        Minimax,
+        MonteCarlo,
+        NumTypes
+    };
+
+    //new instance per call, so every game gets its own histogram
+    static std::shared_ptr<AIStrategy> create(Type type);
+    static const char* getTypeName(Type type);
+
+    //for command lines: "first", "random", "perfect", "minimax" or "mcts".  Leaves type alone if it doesn't match.
+    static bool parseType(const std::string& name, Type& type);
+
+    //the ones that think until their deadline.  The rest answer from a rule or a table right away.
+    static bool isSearch(Type type) { return type == Minimax || type == MonteCarlo; }
+
+    //builds the lookup tables the strategies share, so the first move that needs one doesn't
+    //stall on it.  Safe from any thread, only the first call does any work.
+    static void prepareTables();
+
+    //solved positions every game in the process shares, opening book included.  Built on first use.
+    static PositionCache& getPositionCache();
+
+    AIStrategy(Type type, std::chrono::milliseconds deadline);
+    virtual ~AIStrategy();
+
+    Type getType() const { return m_type; }
+    const char* getName() const { return getTypeName(m_type); }
+
+    //picks a cell (BoardSnapshot::index) for whoever's turn it is.
+    //returns -1 if the game is already over or the token was cancelled.
+    //finished decisions are timed and recorded in the histogram.
+    int decideMove(const BoardSnapshot& board, const AICancelToken& cancel = AICancelToken());
+
+    //reproducible version: no deadline, nothing to cancel, and any randomness comes from seed.
+    //the same board and seed get the same move every time, on any thread.  Still recorded in the histogram.
+    int decideMove(const BoardSnapshot& board, uint32_t seed);
+
+    //everything spelled out: a deadline and a token like the first one, and the seed the caller
+    //picked (GameEngine::getAISeed), so the move is the one the game's state says it should be
+    int decideMove(const BoardSnapshot& board, const AISearchLimits& limits);
+
+    void setDeadline(std::chrono::milliseconds deadline);
+    std::chrono::milliseconds getDeadline() const;
+
+    const LatencyHistogram& getLatencyHistogram() const { return m_latency; }
+
+    //decisions thrown away because the board changed while we were thinking
+    uint64_t getCancelledCount() const { return m_cancelledCount.load(); }
+
+    //what one of us takes, for servers counting what a game costs.  Mostly the generator.
+    //strategies with state of their own add it on.
+    virtual size_t getMemoryUsage() const { return sizeof(AIStrategy); }
+
+protected:
+    //the actual thinking.  Returning -1 or a taken cell falls back to the first free square.
+    virtual int search(const BoardSnapshot& board, const AISearchLimits& limits) = 0;
+
+    //thread safe, where the seed comes from when the caller doesn't pick one
+    uint32_t nextSeed();
+
+    Type m_type;
+
+    std::atomic<int64_t> m_deadlineMs;
+
+    LatencyHistogram m_latency;
+    std::atomic<uint64_t> m_cancelledCount;
+
+    std::mutex m_rngMutex;
+    std::mt19937 m_rng;
+};
+
+//the original "AI", takes the next open square
+class FirstFreeStrategy : public AIStrategy
+{
+public:
+    FirstFreeStrategy() : AIStrategy(FirstFree, std::chrono::milliseconds(5)) {}
+
+    static int firstFreeCell(const BoardSnapshot& board);
+
+protected:
+    virtual int search(const BoardSnapshot& board, const AISearchLimits& limits);
+};
+
+class RandomStrategy : public AIStrategy
+{
+public:
+    RandomStrategy() : AIStrategy(Random, std::chrono::milliseconds(5)) {}
+
+protected:
+    virtual int search(const BoardSnapshot& board, const AISearchLimits& limits);
+};
+
+//every position solved once up front (3^9 boards x 2 sides), then it's a lookup
+class PerfectTableStrategy : public AIStrategy
+{
+public:
+    PerfectTableStrategy() : AIStrategy(PerfectTable, std::chrono::milliseconds(5)) {}
+
+protected:
+    virtual int search(const BoardSnapshot& board, const AISearchLimits& limits);
+};
+
+//alpha-beta with iterative deepening, so there's always an answer when the deadline hits.
+//checks the shared position cache first, and anything it solves all the way down goes back in it
+class MinimaxStrategy : public AIStrategy
+{
+public:
+    MinimaxStrategy() : AIStrategy(Minimax, std::chrono::milliseconds(100)) {}
+
+protected:
+    virtual int search(const BoardSnapshot& board, const AISearchLimits& limits);
+};
+
+//UCT monte carlo tree search, runs playouts until the deadline or the iteration cap
+class MonteCarloStrategy : public AIStrategy
+{
+public:
+    static const int MaxIterations = 50000;
+
+    MonteCarloStrategy() : AIStrategy(MonteCarlo, std::chrono::milliseconds(50)) {}
+
+protected:
+    virtual int search(const BoardSnapshot& board, const AISearchLimits& limits);
+};
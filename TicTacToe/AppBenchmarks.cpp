@@ -0,0 +1,145 @@
+#include "AppBenchmarks.h"
+
+#include "BoardThumbnailAtlas.h"
+#include "GameBenchmarks.h"
+#include "GameEngine.h"
+#include "GameMoveManager.h"
+#include "GraphicsThread.h"
+#include "TApp.h"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+AppBenchmarks::AppBenchmarks(const MicroBenchmark::Options& options, const std::string& executable) : m_options(options), m_executable(executable)
+{
+}
+
+void AppBenchmarks::run()
+{
+    //table builds would land in whichever benchmark got there first
+    AIStrategy::prepareTables();
+
+    MicroBenchmark suite;
+    GameBenchmarks::add(suite);
+
+    //the game manager's benchmarks use this one.  It never runs its own thread, so nothing
+    //ticks it: the AI only moves when a benchmark asks it to.  The score stays in memory, the
+    //app may have the real one open.
+    GameMoveManager gameManager(nullptr, false);
+    MoveStruct center(1, 1, true);
+    MoveStruct corner(0, 0, true);
+
+    suite.add("GameMoveManager/storeUserMadeMove", [&gameManager, center](MicroBenchmark::State& state) {
+        std::string error;
+        while (state.keepRunning())
+        {
+            gameManager.storeUserMadeMove(center, error);
+
+            state.pauseTiming();
+            gameManager.undoLastMove();
+            state.resumeTiming();
+        }
+    });
+
+    for (int type = 0; type < AIStrategy::NumTypes; ++type)
+    {
+        suite.add(std::string("GameMoveManager/makeNextAIMove/") + GameBenchmarks::StrategyNames[type], [&gameManager, corner, type](MicroBenchmark::State& state) {
+            gameManager.setAIStrategy(AIStrategy::create(static_cast<AIStrategy::Type>(type)));
+            PositionCache::Stats cacheBefore = AIStrategy::getPositionCache().getStats();
+
+            std::string error;
+            while (state.keepRunning())
+            {
+                state.pauseTiming();
+                gameManager.storeUserMadeMove(corner, error);
+                state.resumeTiming();
+
+                gameManager.makeNextAIMove();
+
+                state.pauseTiming();
+                gameManager.clearGame();
+                state.resumeTiming();
+            }
+
+            //the strategy's own clock, the search alone without the locking around it
+            std::shared_ptr<AIStrategy> strategy = gameManager.getAIStrategy();
+            const LatencyHistogram& latency = strategy->getLatencyHistogram();
+            state.setCounter("decide_p50_us", double(latency.getPercentileMicros(0.5)));
+            state.setCounter("decide_p99_us", double(latency.getPercentileMicros(0.99)));
+            state.setCounter("cancelled", double(strategy->getCancelledCount()));
+
+            //the cache is shared, only this run's share of it
+            PositionCache::Stats cacheAfter = AIStrategy::getPositionCache().getStats();
+            uint64_t lookups = cacheAfter.lookups - cacheBefore.lookups;
+            if (lookups)
+                state.setCounter("cache_hit_pct", 100.0 * double(cacheAfter.hits - cacheBefore.hits) / lookups);
+        });
+    }
+
+    //readers against this many threads storing and taking back moves as fast as they can
+    suite.add("GameMoveManager/getAllCurrentMoves/writers", [&gameManager, center](MicroBenchmark::State& state) {
+        std::atomic<bool> stop(false);
+        std::vector<std::thread> writers;
+        for (int i = 0; i < state.getArg(); ++i)
+        {
+            writers.emplace_back([&gameManager, &stop, center]() {
+                std::string error;
+                while (!stop)
+                {
+                    gameManager.storeUserMadeMove(center, error);
+                    gameManager.undoLastMove();
+                }
+            });
+        }
+
+        size_t moves = 0;
+        while (state.keepRunning())
+            moves += gameManager.getAllCurrentMoves().size();
+
+        stop = true;
+        for (auto&& writer : writers)
+            writer.join();
+        state.setItemsProcessed(state.getIterations());
+        state.setCounter("moves_seen", double(moves) / state.getIterations());
+    }, { 0, 1, 3 });
+
+    gameManager.clearGame();
+
+    //a lobby's worth of boards.  The arg is how many of them change between renders, the rest
+    //should cost next to nothing.
+    suite.add("BoardThumbnailAtlas/render/changed", [](MicroBenchmark::State& state) {
+        const int numBoards = 1000;
+        BoardThumbnailAtlas atlas(BoardThumbnailAtlas::loadIcon(BoardSnapshot::Player), BoardThumbnailAtlas::loadIcon(BoardSnapshot::AI));
+        std::vector<BoardSnapshot> boards(numBoards);
+        atlas.render(boards.data(), numBoards);
+
+        uint64_t rng = 1;
+        int changed = static_cast<int>(state.getArg());
+        while (state.keepRunning())
+        {
+            for (int i = 0; i < changed; ++i)
+            {
+                uint64_t random = GameEngine::nextRandom(rng);
+                boards[random % numBoards].cells[(random >> 32) % 9] = static_cast<uint8_t>((random >> 40) % 3);
+            }
+            atlas.render(boards.data(), numBoards);
+        }
+        state.setItemsProcessed(state.getIterations() * numBoards);
+    }, { 0, 10, 1000 });
+
+    tApp->getGraphicsThread()->addBenchmarks(suite);
+
+    std::vector<MicroBenchmark::Result> results = suite.run(m_options);
+    if (!m_options.jsonPath.empty())
+    {
+        if (MicroBenchmark::writeJson(m_options.jsonPath, results, m_executable))
+            printf("results written to %s\n", m_options.jsonPath.c_str());
+        else
+            fprintf(stderr, "couldn't write %s\n", m_options.jsonPath.c_str());
+    }
+    fflush(stdout);
+
+    QMetaObject::invokeMethod(tApp, "quit", Qt::QueuedConnection);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "MicroBenchmark.h"
+
+#include <string>
+
+#include <QThread>
+
+//the microbenchmarks: GameBenchmarks, the game logic and the AI through GameMoveManager, the
+//thumbnail atlas, and GraphicsThread's task queue and per frame updates (it registers those
+//itself, they need its insides).  Runs on its own thread once the first frame is up, so
+//the graphics thread is going and the UI thread is free to deliver signals, then quits the app.
+//the game manager benchmarks get a GameMoveManager of their own, the one you play on is left alone.
+class AppBenchmarks : public QThread
+{
+public:
+    AppBenchmarks(const MicroBenchmark::Options& options, const std::string& executable);
+
+protected:
+    virtual void run();
+
+    MicroBenchmark::Options m_options;
+    std::string m_executable;
+};
@@ -0,0 +1,32 @@
+#include "AIStrategy.h"
+#include "GameBenchmarks.h"
+#include "MicroBenchmark.h"
+
+#include <cstdio>
+#include <vector>
+
+//the game benchmarks without the app around them, for platforms (and machines) with no Qt, OSG
+//or display.  CMakeLists.txt builds it as TicTacToeBench; the app's --bench runs these and more.
+//TicTacToeBench [--filter regex] [--json path] [--min-time seconds]
+int main(int argc, char* argv[])
+{
+    MicroBenchmark::Options options = MicroBenchmark::parseCommandLine(argc, argv, 1);
+
+    //table builds would land in whichever benchmark got there first
+    AIStrategy::prepareTables();
+
+    MicroBenchmark suite;
+    GameBenchmarks::add(suite);
+
+    std::vector<MicroBenchmark::Result> results = suite.run(options);
+    if (!options.jsonPath.empty())
+    {
+        if (!MicroBenchmark::writeJson(options.jsonPath, results, argv[0]))
+        {
+            fprintf(stderr, "couldn't write %s\n", options.jsonPath.c_str());
+            return 1;
+        }
+        printf("results written to %s\n", options.jsonPath.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "BoardLayout.h"
+
+#include <cmath>
+
+BoardLayout::BoardLayout(int size, double margin, double lineWidth, double piecePadding) : m_size(size < 1 ? 1 : size),
+    m_margin(margin),
+    m_lineWidth(lineWidth),
+    m_piecePadding(piecePadding),
+    m_width(0.0),
+    m_height(0.0),
+    m_cellWidth(0.0),
+    m_cellHeight(0.0),
+    m_cellsPerPixelX(0.0),
+    m_cellsPerPixelY(0.0)
+{
+}
+
+void BoardLayout::setViewport(double width, double height)
+{
+    if (width == m_width && height == m_height)
+        return;
+
+    m_width = width;
+    m_height = height;
+
+    //the board is whatever's left inside the margins, split evenly
+    double boardWidth = width - (m_margin * 2.0);
+    double boardHeight = height - (m_margin * 2.0);
+    m_cellWidth = boardWidth > 0.0 ? boardWidth / m_size : 0.0;
+    m_cellHeight = boardHeight > 0.0 ? boardHeight / m_size : 0.0;
+    m_cellsPerPixelX = m_cellWidth > 0.0 ? 1.0 / m_cellWidth : 0.0;
+    m_cellsPerPixelY = m_cellHeight > 0.0 ? 1.0 / m_cellHeight : 0.0;
+}
+
+bool BoardLayout::cellAt(double px, double py, int& x, int& y) const
+{
+    //no viewport yet, nothing to hit
+    if (m_cellWidth <= 0.0 || m_cellHeight <= 0.0)
+        return false;
+
+    double col = std::floor((px - m_margin) * m_cellsPerPixelX);
+    double rowFromBottom = std::floor((py - m_margin) * m_cellsPerPixelY);
+    if (col < 0.0 || col >= m_size || rowFromBottom < 0.0 || rowFromBottom >= m_size)
+        return false;
+
+    x = static_cast<int>(col);
+    y = m_size - 1 - static_cast<int>(rowFromBottom);
+    return true;
+}
+
+int BoardLayout::cellAt(double px, double py) const
+{
+    int x, y;
+    if (!cellAt(px, py, x, y))
+        return -1;
+    return (y * m_size) + x;
+}
+
+BoardLayout::Rect BoardLayout::getCellRect(int x, int y) const
+{
+    Rect rect;
+    rect.xMin = m_margin + (x * m_cellWidth);
+    rect.xMax = rect.xMin + m_cellWidth;
+    rect.yMax = m_height - m_margin - (y * m_cellHeight);
+    rect.yMin = rect.yMax - m_cellHeight;
+    return rect;
+}
+
+BoardLayout::Rect BoardLayout::getPieceRect(int x, int y) const
+{
+    Rect rect = getCellRect(x, y);
+    rect.xMin += m_piecePadding;
+    rect.xMax -= m_piecePadding;
+    rect.yMin += m_piecePadding;
+    rect.yMax -= m_piecePadding;
+    return rect;
+}
+
+BoardLayout::Rect BoardLayout::getLineRect(int line) const
+{
+    //lines sit centered on the boundaries between cells and run the length of the board
+    double halfWidth = m_lineWidth / 2.0;
+    Rect rect;
+    if (line < m_size - 1)
+    {
+        double y = m_height - m_margin - ((line + 1) * m_cellHeight);
+        rect.xMin = m_margin;
+        rect.xMax = m_width - m_margin;
+        rect.yMin = y - halfWidth;
+        rect.yMax = y + halfWidth;
+    }
+    else
+    {
+        double x = m_margin + ((line - (m_size - 1) + 1) * m_cellWidth);
+        rect.xMin = x - halfWidth;
+        rect.xMax = x + halfWidth;
+        rect.yMin = m_margin;
+        rect.yMax = m_height - m_margin;
+    }
+    return rect;
+}
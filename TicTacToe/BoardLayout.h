@@ -0,0 +1,55 @@
+#pragma once
+
+//where everything on an N x N board sits on screen, in viewport pixels with the origin at the
+//bottom left (same as our ortho camera).  Row 0 is the top row, same as MoveStruct.
+//GraphicsThread owns one and updates it from the viewport every frame; the board lines, the
+//pieces and click hit testing all come from here so they can't disagree.
+class BoardLayout
+{
+public:
+    struct Rect
+    {
+        double xMin;
+        double yMin;
+        double xMax;
+        double yMax;
+    };
+
+    BoardLayout(int size = 3, double margin = 20.0, double lineWidth = 10.0, double piecePadding = 10.0);
+
+    //cheap, call it whenever the viewport might have changed
+    void setViewport(double width, double height);
+
+    int getSize() const { return m_size; }
+    int getNumCells() const { return m_size * m_size; }
+    double getViewportWidth() const { return m_width; }
+    double getViewportHeight() const { return m_height; }
+
+    //which cell a pixel lands in, -1 if it's in the margin.  No searching, just a scale per axis.
+    int cellAt(double px, double py) const;
+    bool cellAt(double px, double py, int& x, int& y) const;
+
+    Rect getCellRect(int x, int y) const;
+
+    //cell rect pulled in by the padding, where the X or O goes
+    Rect getPieceRect(int x, int y) const;
+
+    //the grid lines: first the size - 1 horizontal ones top to bottom, then the vertical ones left to right
+    int getNumLines() const { return (m_size - 1) * 2; }
+    Rect getLineRect(int line) const;
+
+protected:
+    int m_size;
+    double m_margin;
+    double m_lineWidth;
+    double m_piecePadding;
+
+    double m_width;
+    double m_height;
+
+    //cached on setViewport so the lookups are a multiply instead of a divide
+    double m_cellWidth;
+    double m_cellHeight;
+    double m_cellsPerPixelX;
+    double m_cellsPerPixelY;
+};
@@ -0,0 +1,213 @@
+//network headers pull in winsock2.h, which has to beat windows.h in
+#include "NetPoller.h"
+#include "WireProtocol.h"
+
+#include "BoardMonitor.h"
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const size_t ReceiveBufferSize = 16 * 1024;
+    const int PollTimeoutMs = 50;
+    const int ReconnectMs = 1000;
+}
+
+BoardMonitor::BoardMonitor(const Options& options) : m_options(options),
+    m_boardStates(new std::atomic<uint64_t>[options.numGames > 0 ? options.numGames : 0]),
+    m_stop(false),
+    m_connected(false)
+{
+    if (m_options.numGames < 0)
+        m_options.numGames = 0;
+
+    uint64_t empty = packBoardState(BoardSnapshot());
+    for (int i = 0; i < m_options.numGames; ++i)
+        m_boardStates[i].store(empty, std::memory_order_relaxed);
+}
+
+BoardMonitor::~BoardMonitor()
+{
+    stop();
+}
+
+void BoardMonitor::start()
+{
+    if (m_thread.joinable())
+        return;
+
+    NetPoller::startup();
+
+    m_stop = false;
+    m_thread = std::thread([this]() {
+        run();
+    });
+}
+
+void BoardMonitor::stop()
+{
+    m_stop = true;
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+uint64_t BoardMonitor::packBoardState(const BoardSnapshot& board)
+{
+    uint64_t state = 0;
+    for (int cell = 0; cell < 9; ++cell)
+        state |= uint64_t(board.cells[cell] & 0x3) << (cell * 2);
+    if (board.usersTurn)
+        state |= uint64_t(1) << 18;
+    state |= (board.generation & 0xffffffff) << 32;
+    return state;
+}
+
+BoardSnapshot BoardMonitor::unpackBoardState(uint64_t state)
+{
+    BoardSnapshot board;
+    for (int cell = 0; cell < 9; ++cell)
+        board.cells[cell] = static_cast<uint8_t>((state >> (cell * 2)) & 0x3);
+    board.usersTurn = ((state >> 18) & 1) != 0;
+    board.generation = state >> 32;
+    return board;
+}
+
+void BoardMonitor::run()
+{
+    //our own copies, only this thread touches them.  What the render thread sees is the packed atomics.
+    std::vector<BoardSnapshot> boards(m_options.numGames);
+    std::vector<uint8_t> inBuffer(ReceiveBufferSize);
+
+    //in slices, so stop() doesn't have to sit through the whole thing
+    auto waitToReconnect = [this]() {
+        for (int waited = 0; waited < ReconnectMs && !m_stop; waited += PollTimeoutMs)
+            std::this_thread::sleep_for(std::chrono::milliseconds(PollTimeoutMs));
+    };
+
+    while (!m_stop)
+    {
+        NetSocket socket = NetPoller::connectTcp(m_options.host.c_str(), m_options.port);
+        if (socket == InvalidNetSocket)
+        {
+            waitToReconnect();
+            continue;
+        }
+
+        NetPoller poller;
+        poller.add(socket, nullptr);
+        poller.setWantWrite(socket, nullptr, true);
+
+        //sign up for everything at once, goes out as soon as the connect finishes
+        std::vector<uint8_t> out;
+        for (int i = 0; i < m_options.numGames; ++i)
+            writeJoinGame(out, getGameId(i), WireSeatSpectator);
+        size_t outSent = 0;
+        size_t inUsed = 0;
+        bool alive = true;
+
+        while (alive && !m_stop)
+        {
+            NetPoller::Event events[4];
+            int numEvents = poller.wait(events, 4, PollTimeoutMs);
+            for (int e = 0; e < numEvents && alive; ++e)
+            {
+                if (events[e].writable && outSent < out.size())
+                {
+                    NetBuffer buffer;
+                    buffer.data = out.data() + outSent;
+                    buffer.size = out.size() - outSent;
+
+                    int64_t sent = NetPoller::sendGather(socket, &buffer, 1);
+                    if (sent < 0)
+                    {
+                        alive = false;
+                        break;
+                    }
+                    outSent += static_cast<size_t>(sent);
+                    if (outSent == out.size())
+                    {
+                        poller.setWantWrite(socket, nullptr, false);
+                        m_connected = true;
+                    }
+                }
+
+                if (!events[e].readable && !events[e].closed)
+                    continue;
+
+                //read until it would block, parse in place
+                while (alive)
+                {
+                    int received = NetPoller::recvSome(socket, inBuffer.data() + inUsed, inBuffer.size() - inUsed);
+                    if (received < 0)
+                    {
+                        alive = false;
+                        break;
+                    }
+                    if (received == 0)
+                        break;
+                    inUsed += received;
+
+                    size_t offset = 0;
+                    WireMessage msg = WireMessage();
+                    while (offset < inUsed)
+                    {
+                        int used = readWireMessage(inBuffer.data() + offset, inUsed - offset, msg);
+                        if (used < 0)
+                        {
+                            alive = false;
+                            break;
+                        }
+                        if (used == 0)
+                            break;
+                        offset += used;
+
+                        uint32_t index = msg.gameId - m_options.firstGameId;
+                        if (index >= boards.size())
+                            continue;
+
+                        BoardSnapshot& board = boards[index];
+
+                        //anything older than what we've already got is from before a snapshot
+                        bool stale = (msg.type == WireMoveDelta || msg.type == WireGameOver) && msg.generation <= board.generation;
+                        if (stale)
+                            continue;
+
+                        switch (msg.type)
+                        {
+                        case WireSnapshot:
+                            for (int cell = 0; cell < 9; ++cell)
+                                board.cells[cell] = msg.cells[cell];
+                            board.usersTurn = msg.usersTurn;
+                            board.generation = msg.generation;
+                            break;
+                        case WireMoveDelta:
+                            board.cells[msg.cell] = msg.owner;
+                            board.usersTurn = msg.owner == BoardSnapshot::AI;
+                            board.generation = msg.generation;
+                            break;
+                        case WireGameOver:
+                            board = BoardSnapshot();
+                            board.generation = msg.generation;
+                            break;
+                        default:
+                            continue;
+                        }
+
+                        m_boardStates[index].store(packBoardState(board), std::memory_order_release);
+                    }
+
+                    memmove(inBuffer.data(), inBuffer.data() + offset, inUsed - offset);
+                    inUsed -= offset;
+                }
+            }
+        }
+
+        m_connected = false;
+        poller.remove(socket);
+        NetPoller::closeSocket(socket);
+
+        waitToReconnect();
+    }
+}
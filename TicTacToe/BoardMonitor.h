@@ -0,0 +1,57 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <thread>
+
+//watches a range of games on a GameServer as a spectator, for the tiled monitor view.
+//the network runs on its own thread; each board's latest state sits in a single atomic,
+//so the render thread can check all of them every frame without locking anything and
+//only redraw the ones whose generation moved.
+//(the socket stuff stays in the .cpp so this header doesn't drag winsock in after windows.h)
+class BoardMonitor
+{
+public:
+    struct Options
+    {
+        Options() : host("127.0.0.1"), port(7777), firstGameId(1), numGames(100) {}
+
+        std::string host;
+        uint16_t port;
+        uint32_t firstGameId;
+        int numGames;
+    };
+
+    BoardMonitor(const Options& options = Options());
+    ~BoardMonitor();
+
+    //starts the network thread, which connects (and reconnects) on its own
+    void start();
+    void stop();
+
+    int getNumGames() const { return m_options.numGames; }
+    uint32_t getGameId(int index) const { return m_options.firstGameId + index; }
+    bool isConnected() const { return m_connected; }
+
+    //safe from any thread.  Packed, see unpackBoardState.  Compare them to see if a board changed.
+    uint64_t getBoardState(int index) const { return m_boardStates[index].load(std::memory_order_acquire); }
+
+    //cells 2 bits each in the low 18, usersTurn at bit 18, generation in the top 32
+    static uint64_t packBoardState(const BoardSnapshot& board);
+    static BoardSnapshot unpackBoardState(uint64_t state);
+
+protected:
+    void run();
+
+    Options m_options;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> m_boardStates;
+
+    std::thread m_thread;
+    std::atomic<bool> m_stop;
+    std::atomic<bool> m_connected;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cinttypes>
+
+//a plain, read-only copy of the board.  The AI gets one of these so it can
+//think as long as it wants without holding the GameMoveManager lock.
+struct BoardSnapshot
+{
+    enum Cell : uint8_t
+    {
+        Empty = 0,
+        Player = 1,
+        AI = 2
+    };
+
+    BoardSnapshot() : usersTurn(true), generation(0), hash(0) { cells.fill(Empty); }
+
+    //cells go left to right, top to bottom, same order as MoveStruct sorting
+    static constexpr int index(int x, int y) { return (y * 3) + x; }
+
+    uint8_t at(int x, int y) const { return cells[index(x, y)]; }
+
+    uint8_t sideToMove() const { return usersTurn ? Player : AI; }
+
+    static uint8_t opponent(uint8_t side) { return side == Player ? AI : Player; }
+
+    int numMoves() const
+    {
+        int count = 0;
+        for (auto&& cell : cells)
+            if (cell != Empty)
+                ++count;
+        return count;
+    }
+
+    bool isFull() const { return numMoves() == 9; }
+
+    //returns Empty if nobody has three in a row (yet)
+    uint8_t winner() const
+    {
+        static const int lines[8][3] = {
+            { 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 },  //rows
+            { 0, 3, 6 }, { 1, 4, 7 }, { 2, 5, 8 },  //columns
+            { 0, 4, 8 }, { 2, 4, 6 }                //diagonals
+        };
+
+        for (auto&& line : lines)
+        {
+            uint8_t owner = cells[line[0]];
+            if (owner != Empty && owner == cells[line[1]] && owner == cells[line[2]])
+                return owner;
+        }
+        return Empty;
+    }
+
+    bool isGameOver() const { return winner() != Empty || isFull(); }
+
+    std::array<uint8_t, 9> cells;
+
+    bool usersTurn;
+
+    //bumped by GameMoveManager every time the board changes, so a decision
+    //made on an old snapshot can be thrown away
+    uint64_t generation;
+
+    //zobrist hash of cells (ZobristHash::standard()), as GameMoveManager and the change feed
+    //keep it.  Code that sets cells itself, like the AI's search, doesn't keep it up to date.
+    uint64_t hash;
+};
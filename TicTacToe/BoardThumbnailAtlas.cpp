@@ -0,0 +1,209 @@
+#include "BoardThumbnailAtlas.h"
+#include "ZobristHash.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QPainter>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    //the atlas is always this, so copying a row is a memcpy
+    const QImage::Format AtlasFormat = QImage::Format_ARGB32_Premultiplied;
+
+    //below this the pieces are a pixel or two and nobody can tell them apart
+    const int MinCellSize = 4;
+
+    void copyPixels(const QImage& from, int fromX, int fromY, QImage& to, int toX, int toY, int width, int height)
+    {
+        size_t rowBytes = width * sizeof(uint32_t);
+        for (int row = 0; row < height; ++row)
+        {
+            const uint32_t* source = reinterpret_cast<const uint32_t*>(from.constScanLine(fromY + row)) + fromX;
+            uint32_t* target = reinterpret_cast<uint32_t*>(to.scanLine(toY + row)) + toX;
+            memcpy(target, source, rowBytes);
+        }
+    }
+}
+
+BoardThumbnailAtlas::BoardThumbnailAtlas(const QImage& playerIcon, const QImage& aiIcon, int tileSize, int columns) :
+    m_cellSize(std::max(tileSize / 3, MinCellSize)),
+    m_columns(std::max(columns, 1)),
+    m_rows(0),
+    m_pieces(2 * 9),
+    m_numDrawn(0),
+    m_numCopied(0)
+{
+    prepareBlank();
+    preparePieces(playerIcon, BoardSnapshot::Player);
+    preparePieces(aiIcon, BoardSnapshot::AI);
+}
+
+QImage BoardThumbnailAtlas::loadIcon(uint8_t side)
+{
+    QString name = side == BoardSnapshot::Player ? "O_Icon.png" : "X_Icon.png";
+    QString path = QDir::cleanPath(QCoreApplication::applicationDirPath() + QDir::separator() + ".." + QDir::separator() + ".." + QDir::separator() +
+        "TicTacToe" + QDir::separator() + "Resources" + QDir::separator() + name);
+
+    QImage icon(path);
+    if (icon.isNull())
+        qWarning() << "No thumbnail icon at" << path;
+    return icon;
+}
+
+void BoardThumbnailAtlas::prepareBlank()
+{
+    int tileSize = getTileSize();
+    int line = std::max(1, tileSize / 32);
+
+    m_blank = QImage(tileSize, tileSize, AtlasFormat);
+    m_blank.fill(Qt::white);
+
+    //the grid, and a border so the tiles don't run together in the atlas
+    QPainter painter(&m_blank);
+    QColor gridColor(Qt::black);
+    QColor borderColor(Qt::lightGray);
+    for (int i = 1; i < 3; ++i)
+    {
+        painter.fillRect(QRect((i * m_cellSize) - (line / 2), 0, line, tileSize), gridColor);
+        painter.fillRect(QRect(0, (i * m_cellSize) - (line / 2), tileSize, line), gridColor);
+    }
+    painter.fillRect(QRect(0, 0, tileSize, 1), borderColor);
+    painter.fillRect(QRect(0, tileSize - 1, tileSize, 1), borderColor);
+    painter.fillRect(QRect(0, 0, 1, tileSize), borderColor);
+    painter.fillRect(QRect(tileSize - 1, 0, 1, tileSize), borderColor);
+}
+
+void BoardThumbnailAtlas::preparePieces(const QImage& icon, uint8_t side)
+{
+    int margin = std::max(1, m_cellSize / 8);
+    QRect target(margin, margin, m_cellSize - (2 * margin), m_cellSize - (2 * margin));
+
+    //scaled once, not once a square
+    QImage scaled;
+    if (!icon.isNull())
+        scaled = icon.scaled(target.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation).convertToFormat(AtlasFormat);
+
+    for (int cell = 0; cell < 9; ++cell)
+    {
+        //each square sees a different bit of the grid, so each gets its own copy of the blank under it
+        QImage& piece = m_pieces[((side - 1) * 9) + cell];
+        piece = QImage(m_cellSize, m_cellSize, AtlasFormat);
+        copyPixels(m_blank, (cell % 3) * m_cellSize, (cell / 3) * m_cellSize, piece, 0, 0, m_cellSize, m_cellSize);
+
+        QPainter painter(&piece);
+        if (!scaled.isNull())
+        {
+            painter.drawImage(target.topLeft(), scaled);
+            continue;
+        }
+
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(QPen(side == BoardSnapshot::Player ? Qt::blue : Qt::red, std::max(1, m_cellSize / 10)));
+        if (side == BoardSnapshot::Player)
+        {
+            painter.drawEllipse(target);
+        }
+        else
+        {
+            painter.drawLine(target.topLeft(), target.bottomRight());
+            painter.drawLine(target.topRight(), target.bottomLeft());
+        }
+    }
+}
+
+QRect BoardThumbnailAtlas::getTileRect(int index) const
+{
+    int tileSize = getTileSize();
+    return QRect((index % m_columns) * tileSize, (index / m_columns) * tileSize, tileSize, tileSize);
+}
+
+void BoardThumbnailAtlas::resize(int rows)
+{
+    int tileSize = getTileSize();
+    m_rows = rows;
+    m_atlas = QImage(m_columns * tileSize, std::max(rows, 1) * tileSize, AtlasFormat);
+    m_atlas.fill(Qt::transparent);
+
+    m_tiles.assign(m_rows * m_columns, Tile());
+    m_drawnAt.clear();
+}
+
+void BoardThumbnailAtlas::drawTile(int index, const BoardSnapshot& board)
+{
+    QRect rect = getTileRect(index);
+    copyPixels(m_blank, 0, 0, m_atlas, rect.x(), rect.y(), rect.width(), rect.height());
+
+    for (int cell = 0; cell < 9; ++cell)
+    {
+        uint8_t side = board.cells[cell];
+        if (side == BoardSnapshot::Empty)
+            continue;
+
+        const QImage& piece = m_pieces[((side - 1) * 9) + cell];
+        copyPixels(piece, 0, 0, m_atlas, rect.x() + ((cell % 3) * m_cellSize), rect.y() + ((cell / 3) * m_cellSize), m_cellSize, m_cellSize);
+    }
+}
+
+void BoardThumbnailAtlas::clearTile(int index)
+{
+    QRect rect = getTileRect(index);
+    for (int row = rect.top(); row <= rect.bottom(); ++row)
+        memset(reinterpret_cast<uint32_t*>(m_atlas.scanLine(row)) + rect.x(), 0, rect.width() * sizeof(uint32_t));
+    m_tiles[index] = Tile();
+}
+
+bool BoardThumbnailAtlas::showsPosition(int index, uint64_t hash) const
+{
+    return m_tiles[index].drawn && m_tiles[index].hash == hash;
+}
+
+const QImage& BoardThumbnailAtlas::render(const BoardSnapshot* boards, int numBoards)
+{
+    m_numDrawn = 0;
+    m_numCopied = 0;
+
+    int rows = (numBoards + m_columns - 1) / m_columns;
+    if (rows != m_rows || m_atlas.isNull())
+        resize(rows);
+
+    //the hash a snapshot carries isn't always kept up to date (see BoardSnapshot), and this is 9 lookups
+    const ZobristHash& zobrist = ZobristHash::standard();
+    for (int i = 0; i < numBoards; ++i)
+    {
+        uint64_t hash = zobrist.hashBoard(boards[i].cells.data());
+        if (showsPosition(i, hash))
+            continue;
+
+        //lots of lobby boards are empty or a move or two in, so most new positions are already up somewhere
+        auto found = m_drawnAt.find(hash);
+        if (found != m_drawnAt.end() && showsPosition(found->second, hash))
+        {
+            QRect from = getTileRect(found->second);
+            QRect to = getTileRect(i);
+            copyPixels(m_atlas, from.x(), from.y(), m_atlas, to.x(), to.y(), to.width(), to.height());
+            ++m_numCopied;
+        }
+        else
+        {
+            drawTile(i, boards[i]);
+            m_drawnAt[hash] = i;
+            ++m_numDrawn;
+        }
+
+        m_tiles[i].hash = hash;
+        m_tiles[i].drawn = true;
+    }
+
+    //whatever's left of the last row, when there are fewer boards than before
+    for (int i = numBoards; i < static_cast<int>(m_tiles.size()); ++i)
+    {
+        if (m_tiles[i].drawn)
+            clearTile(i);
+    }
+
+    return m_atlas;
+}
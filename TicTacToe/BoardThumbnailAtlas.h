@@ -0,0 +1,75 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+
+#include <QImage>
+#include <QRect>
+#include <QString>
+
+#include <cinttypes>
+#include <unordered_map>
+#include <vector>
+
+//small pictures of a lot of boards at once, all packed into one atlas image, for lobby and
+//spectator lists.  It's all on the CPU and needs no GL context or viewer: the empty board and
+//every piece in every square are drawn once up front, so a thumbnail is just a handful of row
+//copies out of those.  A tile is only touched when its board's position changes, and a position
+//some other tile already shows is copied from there instead of being put together again.
+//one thread at a time, QImage is fine off the GUI thread.
+class BoardThumbnailAtlas
+{
+public:
+    //the icons can be any size, they're scaled to a square once here.  A null one gets a plain
+    //drawn X or O instead.  tileSize is in pixels and goes down to a multiple of 3.
+    BoardThumbnailAtlas(const QImage& playerIcon, const QImage& aiIcon, int tileSize = 48, int columns = 16);
+
+    //board i goes in tile i, left to right then top to bottom.  When the boards need a different
+    //number of rows the atlas is made again and every tile redrawn.
+    const QImage& render(const BoardSnapshot* boards, int numBoards);
+
+    const QImage& getAtlas() const { return m_atlas; }
+    QRect getTileRect(int index) const;
+    int getTileSize() const { return m_cellSize * 3; }
+
+    //from the last render
+    int getTilesDrawn() const { return m_numDrawn; }
+    int getTilesCopied() const { return m_numCopied; }
+
+    //O_Icon.png for the player and X_Icon.png for the AI, out of Resources, same as the main board
+    static QImage loadIcon(uint8_t side);
+
+protected:
+    struct Tile
+    {
+        Tile() : hash(0), drawn(false) {}
+
+        uint64_t hash;      //of the position it shows, if it's drawn
+        bool drawn;
+    };
+
+    void prepareBlank();
+    void preparePieces(const QImage& icon, uint8_t side);
+
+    void resize(int rows);
+    void drawTile(int index, const BoardSnapshot& board);
+    void clearTile(int index);
+
+    //false if whatever we remembered there has been drawn over since
+    bool showsPosition(int index, uint64_t hash) const;
+
+    int m_cellSize;
+    int m_columns;
+    int m_rows;
+
+    QImage m_blank;
+    std::vector<QImage> m_pieces;   //(side - 1) * 9 + cell, already on top of the blank board
+
+    QImage m_atlas;
+    std::vector<Tile> m_tiles;
+
+    //a tile that has each position on it, or had it.  Never bigger than the positions there are.
+    std::unordered_map<uint64_t, int> m_drawnAt;
+
+    int m_numDrawn;
+    int m_numCopied;
+};
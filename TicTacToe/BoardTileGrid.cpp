@@ -0,0 +1,261 @@
+#include "BoardTileGrid.h"
+#include "BoardMonitor.h"
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/Switch>
+#include <osg/Image>
+#include <osg/Texture2D>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    //below this the pieces stop being readable, so we scroll instead of shrinking further
+    const double MinTileSize = 96.0;
+
+    const int NumSquares = 9;
+
+    //never a real packed state, so a new tile always gets drawn the first time it's seen
+    const uint64_t NeverDrawn = ~uint64_t(0);
+
+    osg::Geometry* createQuads(int numQuads, const osg::Vec4f& color)
+    {
+        osg::Geometry* geometry = new osg::Geometry;
+
+        //these get rewritten when the tiles resize
+        geometry->setDataVariance(osg::Object::DYNAMIC);
+        geometry->setUseDisplayList(false);
+        geometry->setUseVertexBufferObjects(true);
+
+        geometry->setVertexArray(new osg::Vec3Array(numQuads * 4));
+
+        osg::Vec4Array* colors = new osg::Vec4Array;
+        colors->push_back(color);
+        geometry->setColorArray(colors, osg::Array::BIND_OVERALL);
+
+        geometry->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, numQuads * 4));
+        return geometry;
+    }
+
+    void setQuad(osg::Vec3Array* vertices, int quad, const BoardLayout::Rect& rect, double z)
+    {
+        //clockwise, starting at top left, same as the main board
+        (*vertices)[quad * 4 + 0].set(rect.xMin, rect.yMax, z);
+        (*vertices)[quad * 4 + 1].set(rect.xMax, rect.yMax, z);
+        (*vertices)[quad * 4 + 2].set(rect.xMax, rect.yMin, z);
+        (*vertices)[quad * 4 + 3].set(rect.xMin, rect.yMin, z);
+    }
+
+    osg::StateSet* createPieceState(osg::Image* image)
+    {
+        osg::Texture2D* texture = new osg::Texture2D;
+        texture->setImage(image);
+
+        osg::StateSet* stateset = new osg::StateSet;
+        stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+        stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+        stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+        return stateset;
+    }
+}
+
+BoardTileGrid::BoardTileGrid(osg::Image* xImage, osg::Image* oImage) : m_tileSize(0.0),
+    m_columns(1),
+    m_scroll(0.0),
+    m_placedWidth(-1.0),
+    m_placedHeight(-1.0),
+    m_placedScroll(-1.0),
+    m_numVisible(0),
+    m_numUpdated(0)
+{
+    m_root = new osg::Group;
+
+    //one grid for everybody
+    osg::Geometry* lines = createQuads(m_layout.getNumLines(), osg::Vec4f(1.0f, 0.0f, 0.0f, 0.8f));
+    osg::StateSet* lineState = lines->getOrCreateStateSet();
+    lineState->setMode(GL_BLEND, osg::StateAttribute::ON);
+    lineState->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+
+    m_grid = new osg::Geode;
+    m_grid->addDrawable(lines);
+
+    //one X and one O look, shared by every piece on every tile
+    m_xState = createPieceState(xImage);
+    m_oState = createPieceState(oImage);
+
+    //one quad per square.  The X and the O for a square are two geodes over the same quad.
+    for (int square = 0; square < NumSquares; ++square)
+    {
+        osg::Geometry* quad = createQuads(1, osg::Vec4f(1.0f, 1.0f, 1.0f, 1.0f));
+
+        osg::Vec2Array* texcoords = new osg::Vec2Array;
+        texcoords->push_back(osg::Vec2f(0.0f, 1.0f));
+        texcoords->push_back(osg::Vec2f(0.0f, 0.0f));
+        texcoords->push_back(osg::Vec2f(1.0f, 0.0f));
+        texcoords->push_back(osg::Vec2f(1.0f, 1.0f));
+        quad->setTexCoordArray(0, texcoords);
+
+        m_squares.push_back(quad);
+
+        osg::Geode* x = new osg::Geode;
+        x->addDrawable(quad);
+        x->setStateSet(m_xState);
+        m_pieces.push_back(x);
+
+        osg::Geode* o = new osg::Geode;
+        o->addDrawable(quad);
+        o->setStateSet(m_oState);
+        m_pieces.push_back(o);
+    }
+}
+
+BoardTileGrid::~BoardTileGrid()
+{
+}
+
+osg::Group* BoardTileGrid::getNode() const
+{
+    return m_root.get();
+}
+
+void BoardTileGrid::scroll(double tiles)
+{
+    //clamped when the tiles get placed, we don't know how far we can go until then
+    m_scroll += tiles * m_tileSize;
+}
+
+void BoardTileGrid::setNumTiles(int numTiles)
+{
+    m_root->removeChildren(0, m_root->getNumChildren());
+    m_tiles.clear();
+    m_tiles.reserve(numTiles);
+
+    for (int i = 0; i < numTiles; ++i)
+    {
+        Tile tile;
+        tile.transform = new osg::MatrixTransform;
+        tile.transform->addChild(m_grid);
+
+        tile.pieces = new osg::Switch;
+        for (auto&& piece : m_pieces)
+            tile.pieces->addChild(piece, false);
+        tile.transform->addChild(tile.pieces);
+
+        tile.drawnState = NeverDrawn;
+        tile.visible = false;
+        tile.transform->setNodeMask(0);
+
+        m_root->addChild(tile.transform);
+        m_tiles.push_back(tile);
+    }
+
+    //everything needs placing again
+    m_placedWidth = -1.0;
+}
+
+void BoardTileGrid::resizeShared(double tileSize)
+{
+    m_tileSize = tileSize;
+
+    //the margin doubles as the gap between tiles
+    m_layout = BoardLayout(3, tileSize * 0.06, std::max(1.0, tileSize * 0.03), tileSize * 0.06);
+    m_layout.setViewport(tileSize, tileSize);
+
+    osg::Geometry* lines = m_grid->getDrawable(0)->asGeometry();
+    osg::Vec3Array* lineVertices = static_cast<osg::Vec3Array*>(lines->getVertexArray());
+    for (int line = 0; line < m_layout.getNumLines(); ++line)
+        setQuad(lineVertices, line, m_layout.getLineRect(line), -0.1);
+    lineVertices->dirty();
+    lines->dirtyBound();
+
+    for (int square = 0; square < NumSquares; ++square)
+    {
+        osg::Vec3Array* vertices = static_cast<osg::Vec3Array*>(m_squares[square]->getVertexArray());
+        setQuad(vertices, 0, m_layout.getPieceRect(square % 3, square / 3), 0.0);
+        vertices->dirty();
+        m_squares[square]->dirtyBound();
+    }
+}
+
+void BoardTileGrid::placeTiles(double width, double height)
+{
+    int numTiles = static_cast<int>(m_tiles.size());
+    if (!numTiles || width <= 0.0 || height <= 0.0)
+        return;
+
+    //as big as they can be and still all fit, until that gets too small to read
+    int columns = std::max(1, static_cast<int>(std::ceil(std::sqrt(numTiles * width / height))));
+    int rows = (numTiles + columns - 1) / columns;
+    double tileSize = std::min(width / columns, height / rows);
+    if (tileSize < MinTileSize)
+    {
+        tileSize = MinTileSize;
+        columns = std::max(1, static_cast<int>(width / tileSize));
+        rows = (numTiles + columns - 1) / columns;
+    }
+
+    double maxScroll = std::max(0.0, (rows * tileSize) - height);
+    m_scroll = std::min(std::max(m_scroll, 0.0), maxScroll);
+
+    if (tileSize != m_tileSize)
+        resizeShared(tileSize);
+    else if (width == m_placedWidth && height == m_placedHeight && m_scroll == m_placedScroll && columns == m_columns)
+        return;
+
+    m_columns = columns;
+    m_placedWidth = width;
+    m_placedHeight = height;
+    m_placedScroll = m_scroll;
+    m_numVisible = 0;
+
+    for (int i = 0; i < numTiles; ++i)
+    {
+        Tile& tile = m_tiles[i];
+        double x = (i % columns) * tileSize;
+        double y = height - (((i / columns) + 1) * tileSize) + m_scroll;
+
+        //anything off screen is masked, the cull traversal skips it entirely
+        tile.visible = y + tileSize > 0.0 && y < height;
+        tile.transform->setNodeMask(tile.visible ? ~0u : 0u);
+        if (!tile.visible)
+            continue;
+
+        tile.transform->setMatrix(osg::Matrix::translate(x, y, 0.0));
+        ++m_numVisible;
+    }
+}
+
+void BoardTileGrid::update(const BoardMonitor& monitor, double width, double height)
+{
+    if (static_cast<int>(m_tiles.size()) != monitor.getNumGames())
+        setNumTiles(monitor.getNumGames());
+
+    placeTiles(width, height);
+
+    //only the boards that moved since we last drew them
+    m_numUpdated = 0;
+    for (int i = 0; i < static_cast<int>(m_tiles.size()); ++i)
+    {
+        Tile& tile = m_tiles[i];
+        if (!tile.visible)
+            continue;
+
+        uint64_t state = monitor.getBoardState(i);
+        if (state == tile.drawnState)
+            continue;
+        tile.drawnState = state;
+        ++m_numUpdated;
+
+        //user (Player) moves are O's, same as the main board
+        BoardSnapshot board = BoardMonitor::unpackBoardState(state);
+        tile.pieces->setAllChildrenOff();
+        for (int square = 0; square < NumSquares; ++square)
+        {
+            if (board.cells[square] != BoardSnapshot::Empty)
+                tile.pieces->setValue((square * 2) + (board.cells[square] == BoardSnapshot::Player ? 1 : 0), true);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "BoardLayout.h"
+
+#include <osg/ref_ptr>
+
+#include <cinttypes>
+#include <vector>
+
+class BoardMonitor;
+
+namespace osg
+{
+    class Geode;
+    class Geometry;
+    class Group;
+    class Image;
+    class MatrixTransform;
+    class StateSet;
+    class Switch;
+}
+
+//draws a pile of boards as tiles under one camera, for watching a lot of games at once.
+//everything that looks the same is shared: one grid, one quad per square, one X and one O
+//state set (and texture).  A tile is just a transform to move it into place and a switch to
+//pick which pieces show, so it costs a couple of nodes no matter how many boards there are.
+//tiles that are scrolled out of view are masked off so the cull doesn't even visit them, and a
+//tile is only touched when its board's state actually changes.
+//we use one camera rather than one osgViewer::View per board: a view each would mean a
+//cull and draw pass each, which is what doesn't scale.
+class BoardTileGrid
+{
+public:
+    //the images are the ones the main board already decoded, they're shared, not copied
+    BoardTileGrid(osg::Image* xImage, osg::Image* oImage);
+    ~BoardTileGrid();
+
+    osg::Group* getNode() const;
+
+    //lays the tiles out for the viewport and brings any visible board that changed up to date
+    void update(const BoardMonitor& monitor, double width, double height);
+
+    //positive scrolls down the list, in tiles
+    void scroll(double tiles);
+
+    int getNumVisibleTiles() const { return m_numVisible; }
+    int getTilesUpdatedLastFrame() const { return m_numUpdated; }
+
+protected:
+    struct Tile
+    {
+        osg::ref_ptr<osg::MatrixTransform> transform;
+        osg::ref_ptr<osg::Switch> pieces;
+        uint64_t drawnState;
+        bool visible;
+    };
+
+    void setNumTiles(int numTiles);
+
+    //the shared grid and squares, whenever the tile size changes
+    void resizeShared(double tileSize);
+
+    void placeTiles(double width, double height);
+
+    osg::ref_ptr<osg::Group> m_root;
+
+    osg::ref_ptr<osg::Geode> m_grid;
+    std::vector<osg::ref_ptr<osg::Geometry>> m_squares;
+    std::vector<osg::ref_ptr<osg::Geode>> m_pieces;     //square * 2 + side, X then O
+    osg::ref_ptr<osg::StateSet> m_xState;
+    osg::ref_ptr<osg::StateSet> m_oState;
+
+    std::vector<Tile> m_tiles;
+
+    BoardLayout m_layout;
+    double m_tileSize;
+    int m_columns;
+    double m_scroll;
+
+    //what the tiles were last placed for, so we only move them when something changes
+    double m_placedWidth;
+    double m_placedHeight;
+    double m_placedScroll;
+
+    int m_numVisible;
+    int m_numUpdated;
+};
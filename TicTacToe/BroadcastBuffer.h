@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cinttypes>
+#include <memory>
+#include <vector>
+
+//encoded messages written once and sent to any number of connections.
+//a connection that can't send all of it right away keeps a reference to the rest instead of
+//copying the bytes, so a buffer stays alive until the slowest of them is done with it.
+//the writer only reuses it when nobody else is holding on, see recycle().
+class BroadcastBuffer : public std::enable_shared_from_this<BroadcastBuffer>
+{
+public:
+    typedef std::shared_ptr<BroadcastBuffer> Ptr;
+
+    static Ptr create(size_t reserveBytes = 256)
+    {
+        Ptr buffer = std::make_shared<BroadcastBuffer>();
+        buffer->m_bytes.reserve(reserveBytes);
+        return buffer;
+    }
+
+    //call once everything that was sent out of it has been handed off.  Empties the buffer for
+    //another round of writing if we were the last ones using it, otherwise leaves it to
+    //whoever still is and starts a new one.
+    static void recycle(Ptr& buffer)
+    {
+        if (buffer.use_count() == 1)
+            buffer->m_bytes.clear();
+        else
+            buffer = create(buffer->m_bytes.capacity());
+    }
+
+    //only the writer touches this, and only between recycles
+    std::vector<uint8_t>& getBytes() { return m_bytes; }
+
+    const uint8_t* data() const { return m_bytes.data(); }
+    size_t size() const { return m_bytes.size(); }
+    bool empty() const { return m_bytes.empty(); }
+    size_t capacity() const { return m_bytes.capacity(); }
+
+protected:
+    std::vector<uint8_t> m_bytes;
+};
+
+//the part of a shared buffer one connection still has to send
+struct BroadcastSlice
+{
+    BroadcastSlice(BroadcastBuffer::Ptr buffer, size_t offset) : buffer(std::move(buffer)), offset(offset) {}
+
+    const uint8_t* data() const { return buffer->data() + offset; }
+    size_t size() const { return buffer->size() - offset; }
+
+    BroadcastBuffer::Ptr buffer;
+    size_t offset;
+};
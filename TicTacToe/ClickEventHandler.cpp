@@ -1,11 +1,24 @@
 #include "ClickEventHandler.h"
+#include "BoardLayout.h"
 #include "GameMoveManager.h"
 #include "GraphicsThread.h"
+#include "QubicBoardView.h"
 #include "TApp.h"
 
 #include <QDebug>
 
-ClickEventHandler::ClickEventHandler()
+#include <cmath>
+
+namespace
+{
+    //the button can wander this far, in pixels, and still be a click
+    const double ClickSlop = 4.0;
+}
+
+ClickEventHandler::ClickEventHandler(const BoardLayout* layout, const BoardLayout* ultimateLayout) : m_layout(layout),
+    m_ultimateLayout(ultimateLayout),
+    m_pushX(0.0),
+    m_pushY(0.0)
 {
 
 }
@@ -15,52 +28,121 @@ ClickEventHandler::~ClickEventHandler()
 
 }
 
+ClickEventHandler::Click ClickEventHandler::getPosition(const osgGA::GUIEventAdapter& ea)
+{
+    //the layout works from the bottom left of the viewport, same as the camera
+    Click click;
+    click.x = ea.getX() - ea.getXmin();
+    click.y = ea.getMouseYOrientation() == osgGA::GUIEventAdapter::Y_INCREASING_UPWARDS ? ea.getY() - ea.getYmin() : ea.getYmax() - ea.getY();
+    return click;
+}
+
 bool ClickEventHandler::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa)
 {
     if (ea.getHandled()) 
         return false;
 
+    //the cube turns on drags and zooms on the wheel, it gets a look at everything first
+    QubicBoardView* qubicView = tApp->getGraphicsThread()->getQubicView();
+    bool turning = false;
+    if (qubicView && !tApp->getGraphicsThread()->isMonitoring() && tApp->getGameManager()->getVariant() == GameMoveManager::Qubic)
+        turning = qubicView->handle(ea, aa);
+
     switch (ea.getEventType())
     {
+    case(osgGA::GUIEventAdapter::PUSH):
+    {
+        if (ea.getButton() == osgGA::GUIEventAdapter::LEFT_MOUSE_BUTTON)
+        {
+            Click push = getPosition(ea);
+            m_pushX = push.x;
+            m_pushY = push.y;
+        }
+    }
+    break;
     case(osgGA::GUIEventAdapter::RELEASE):
     {
         if (ea.getButton() == osgGA::GUIEventAdapter::LEFT_MOUSE_BUTTON)
         {
-            //we need to test which region the click was closest to...
-            int x = -1;
-            int y = -1;
-
-            if (ea.getX() < ea.getXmax() / 3)
-                x = 0;
-            else if (ea.getX() >= (ea.getXmax() / 3) && ea.getX() < ((ea.getXmax() / 3) * 2))
-                x = 1;
-            else
-                x = 2;
-
-            if (ea.getY() < ea.getYmax() / 3)
-                y = 2;
-            else if (ea.getY() >= (ea.getYmax() / 3) && ea.getY() < ((ea.getYmax() / 3) * 2))
-                y = 1;
-            else
-                y = 0;
-
-            MoveStruct move(x, y, true);
-
-            std::string errMsg;
-            
-            if (tApp->getGameManager()->storeUserMadeMove(move, errMsg))
-                 qWarning() << "Successful Move a position " << x << ", " << y;
-            else
-                qWarning() << QString::fromStdString(errMsg);
-
-            tApp->getGraphicsThread()->setUserMessage(errMsg);
+            Click click = getPosition(ea);
+            if (std::abs(click.x - m_pushX) <= ClickSlop && std::abs(click.y - m_pushY) <= ClickSlop)
+                m_pendingClicks.push_back(click);
+        }
+    }
+    break;
+    case(osgGA::GUIEventAdapter::SCROLL):
+    {
+        //the wheel only does something when there are tiles to scroll through
+        if (tApp->getGraphicsThread()->isMonitoring())
+        {
+            if (ea.getScrollingMotion() == osgGA::GUIEventAdapter::SCROLL_DOWN)
+                tApp->getGraphicsThread()->scrollMonitor(0.5);
+            else if (ea.getScrollingMotion() == osgGA::GUIEventAdapter::SCROLL_UP)
+                tApp->getGraphicsThread()->scrollMonitor(-0.5);
         }
     }
     break;
+    case(osgGA::GUIEventAdapter::FRAME):
+        processClicks();
+        break;
     default:
         break;
     }
 
-    return false;
+    return turning;
+
+}
+
+void ClickEventHandler::processClicks()
+{
+    if (m_pendingClicks.empty() || !m_layout)
+        return;
+
+    //our board isn't even showing while we watch other games
+    if (tApp->getGraphicsThread()->isMonitoring())
+    {
+        m_pendingClicks.clear();
+        return;
+    }
+
+    //whichever grid is on screen, the game manager takes x/y on either.  The cube picks its own cells.
+    GameMoveManager::Variant variant = tApp->getGameManager()->getVariant();
+    const BoardLayout* layout = m_layout;
+    if (m_ultimateLayout && variant == GameMoveManager::Ultimate)
+        layout = m_ultimateLayout;
+    QubicBoardView* qubicView = variant == GameMoveManager::Qubic ? tApp->getGraphicsThread()->getQubicView() : nullptr;
+
+    int lastCell = -1;
 
+    for (auto&& click : m_pendingClicks)
+    {
+        MoveStruct move;
+        int cell = -1;
+        if (variant == GameMoveManager::Qubic)
+        {
+            cell = qubicView ? qubicView->pick(click.x, click.y) : -1;
+            if (cell < 0)
+                continue;
+            move = QubicBoard::getMove(cell, true);
+        }
+        else
+        {
+            int x = -1;
+            int y = -1;
+            if (!layout->cellAt(click.x, click.y, x, y))
+                continue;
+            cell = (y * layout->getSize()) + x;
+            move = MoveStruct(x, y, true);
+        }
+
+        //double clicks and the like, no need to send the same square twice
+        if (cell == lastCell)
+            continue;
+        lastCell = cell;
+
+        //the answer comes back through GraphicsThread on a later frame
+        if (!tApp->getGameManager()->postUserMove(move))
+            qWarning() << "Dropped a click, game thread isn't keeping up";
+    }
+    m_pendingClicks.clear();
 }
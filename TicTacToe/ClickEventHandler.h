@@ -1,11 +1,41 @@
 #pragma once
 #include <osgGA/GUIEventHandler>
 
+#include <vector>
+
+class BoardLayout;
+
 struct ClickEventHandler : public osgGA::GUIEventHandler
 {
 public:
-    ClickEventHandler();
+    //the layouts belong to the GraphicsThread and have to outlive us.  The second is the 9x9
+    //one, used while the game manager is playing ultimate.
+    ClickEventHandler(const BoardLayout* layout, const BoardLayout* ultimateLayout = nullptr);
     ~ClickEventHandler();
 
     bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa);
+
+protected:
+    struct Click
+    {
+        double x;
+        double y;
+    };
+
+    //clicks are only collected as they come in and handled once per frame, so a burst
+    //of them costs one cell lookup each.  The moves go to the game thread's queue, we never
+    //wait on the game from in here.
+    void processClicks();
+
+    //the viewport position of an event, bottom left origin same as the layout
+    static Click getPosition(const osgGA::GUIEventAdapter& ea);
+
+    const BoardLayout* m_layout;
+    const BoardLayout* m_ultimateLayout;
+
+    //where the left button went down.  If it comes back up somewhere else that was a drag, not a click.
+    double m_pushX;
+    double m_pushY;
+
+    std::vector<Click> m_pendingClicks;
 };
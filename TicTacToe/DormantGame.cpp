@@ -0,0 +1,123 @@
+#include "DormantGame.h"
+#include "ZobristHash.h"
+
+namespace
+{
+    const int NumCells = 9;
+
+    const size_t InitialSlots = 1024;
+
+    //fibonacci hashing, the top bits of id * 2^64 / phi
+    const uint64_t HashMultiplier = 0x9e3779b97f4a7c15ull;
+}
+
+DormantGame DormantGame::encode(const BoardSnapshot& board, uint32_t playerWins, uint32_t aiWins, uint32_t catWins)
+{
+    DormantGame game;
+    game.generation = static_cast<uint32_t>(board.generation);
+    game.playerWins = playerWins;
+    game.aiWins = aiWins;
+    game.catWins = catWins;
+    game.usersTurn = board.usersTurn ? 1 : 0;
+
+    //cell 0 is the lowest digit
+    uint32_t cells = 0;
+    for (int cell = NumCells - 1; cell >= 0; --cell)
+        cells = (cells * 3) + board.cells[cell];
+    game.cells = static_cast<uint16_t>(cells);
+    return game;
+}
+
+BoardSnapshot DormantGame::decodeBoard() const
+{
+    BoardSnapshot board;
+    board.generation = generation;
+    board.usersTurn = usersTurn != 0;
+
+    uint32_t left = cells;
+    for (int cell = 0; cell < NumCells; ++cell)
+    {
+        board.cells[cell] = static_cast<uint8_t>(left % 3);
+        left /= 3;
+    }
+    board.hash = ZobristHash::standard().hashBoard(board.cells.data());
+    return board;
+}
+
+DormantGameTable::DormantGameTable() : m_slots(InitialSlots), m_size(0), m_shift(64 - 10)
+{
+}
+
+size_t DormantGameTable::getHome(uint32_t id) const
+{
+    return static_cast<size_t>((id * HashMultiplier) >> m_shift);
+}
+
+size_t DormantGameTable::findSlot(uint32_t id) const
+{
+    //there's always a free slot, so this stops
+    size_t mask = m_slots.size() - 1;
+    size_t slot = getHome(id);
+    while (m_slots[slot].game.cells != DormantGame::NoBoard && m_slots[slot].id != id)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+const DormantGame* DormantGameTable::find(uint32_t id) const
+{
+    const Slot& slot = m_slots[findSlot(id)];
+    return slot.game.cells != DormantGame::NoBoard ? &slot.game : nullptr;
+}
+
+void DormantGameTable::insert(uint32_t id, const DormantGame& game)
+{
+    if ((m_size + 1) * 4 > m_slots.size() * 3)
+        grow();
+
+    Slot& slot = m_slots[findSlot(id)];
+    if (slot.game.cells == DormantGame::NoBoard)
+        ++m_size;
+    slot.id = id;
+    slot.game = game;
+}
+
+bool DormantGameTable::take(uint32_t id, DormantGame& game)
+{
+    size_t mask = m_slots.size() - 1;
+    size_t hole = findSlot(id);
+    if (m_slots[hole].game.cells == DormantGame::NoBoard)
+        return false;
+
+    game = m_slots[hole].game;
+    --m_size;
+
+    //pull back anything later in the run that would be past the hole from its home
+    size_t next = (hole + 1) & mask;
+    while (m_slots[next].game.cells != DormantGame::NoBoard)
+    {
+        size_t home = getHome(m_slots[next].id);
+        bool canMove = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (canMove)
+        {
+            m_slots[hole] = m_slots[next];
+            hole = next;
+        }
+        next = (next + 1) & mask;
+    }
+    m_slots[hole].game.cells = DormantGame::NoBoard;
+    return true;
+}
+
+void DormantGameTable::grow()
+{
+    std::vector<Slot> old(m_slots.size() * 2);
+    old.swap(m_slots);
+    --m_shift;
+    m_size = 0;
+
+    for (auto&& slot : old)
+    {
+        if (slot.game.cells != DormantGame::NoBoard)
+            insert(slot.id, slot.game);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+//a game nobody is connected to, squeezed down to what it takes to pick it up again: the board
+//as a base 3 number (3^9 fits in 15 bits), whose turn it is, the generation and the score.
+//20 bytes, against a few KB for a live one (its AI alone has a generator and a histogram).
+//the AI, the broadcast buffer and the subscriber list all come back new when it's rehydrated.
+struct DormantGame
+{
+    //never a board, 3^9 - 1 is the biggest one.  Marks a free slot in DormantGameTable.
+    static const uint16_t NoBoard = 0xffff;
+
+    DormantGame() : generation(0), playerWins(0), aiWins(0), catWins(0), cells(NoBoard), usersTurn(1) {}
+
+    static DormantGame encode(const BoardSnapshot& board, uint32_t playerWins, uint32_t aiWins, uint32_t catWins);
+
+    //the hash is worked out again, it's only ever the cells' zobrist hash
+    BoardSnapshot decodeBoard() const;
+
+    uint32_t generation;    //the wire only carries 32 bits of it anyway
+    uint32_t playerWins;
+    uint32_t aiWins;
+    uint32_t catWins;
+    uint16_t cells;
+    uint16_t usersTurn;
+};
+
+//game id -> DormantGame for millions of parked games.  One flat array, open addressing with a
+//linear probe; a delete shifts the rest of its run back instead of leaving tombstones, so lookups
+//never slow down however much parking and rehydrating goes on.  A slot is 24 bytes and the table
+//doubles at 3/4 full, so a parked game costs 32 to 64 bytes all in, and no allocation of its own.
+class DormantGameTable
+{
+public:
+    DormantGameTable();
+
+    size_t size() const { return m_size; }
+
+    //what the table has allocated, for the accounting
+    size_t getMemoryUsage() const { return m_slots.capacity() * sizeof(Slot); }
+
+    //replaces whatever was parked under that id
+    void insert(uint32_t id, const DormantGame& game);
+
+    //false if there's nothing parked under id.  Otherwise it comes out of the table.
+    bool take(uint32_t id, DormantGame& game);
+
+    //nullptr if there isn't one
+    const DormantGame* find(uint32_t id) const;
+
+protected:
+    struct Slot
+    {
+        uint32_t id;
+        DormantGame game;   //cells == NoBoard for a free slot
+    };
+
+    size_t getHome(uint32_t id) const;
+    size_t findSlot(uint32_t id) const;
+    void grow();
+
+    std::vector<Slot> m_slots;
+    size_t m_size;
+    int m_shift;        //64 - log2(slots), for the multiplicative hash
+};
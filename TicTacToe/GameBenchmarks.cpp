@@ -0,0 +1,153 @@
+#include "GameBenchmarks.h"
+
+#include "GameEngine.h"
+#include "LineBoard.h"
+#include "QubicSearch.h"
+#include "ThreatSearch.h"
+#include "TimingWheel.h"
+#include "UltimateSearch.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+const char* GameBenchmarks::StrategyNames[AIStrategy::NumTypes] = { "first", "random", "perfect", "minimax", "mcts" };
+
+void GameBenchmarks::add(MicroBenchmark& suite)
+{
+    //a whole game's worth of inputs, the rules and nothing else
+    suite.add("GameEngine/step", [](MicroBenchmark::State& state) {
+        const int cells[] = { 4, 0, 8, 2, 6, 1, 7, 3, 5 };
+        GameState game = GameEngine::createState(1);
+        int next = 0;
+        uint64_t events = 0;
+        while (state.keepRunning())
+        {
+            GameInput input = GameInput::tick();
+            if (game.usersTurn)
+                input = GameInput::userMove(cells[next++ % 9]);
+            else if (!game.getSnapshot().isGameOver())
+                input = GameInput::aiMove(cells[next++ % 9], game.generation);
+
+            GameStep step = GameEngine::step(game, input);
+            game = step.state;
+            events += step.numEvents;
+        }
+        state.setItemsProcessed(state.getIterations());
+        state.setCounter("events", double(events) / state.getIterations());
+    });
+
+    //the strategies with no game manager around them, seeded so every run asks the same questions
+    for (int type = 0; type < AIStrategy::NumTypes; ++type)
+    {
+        suite.add(std::string("AIStrategy/decideMove/") + StrategyNames[type], [type](MicroBenchmark::State& state) {
+            std::shared_ptr<AIStrategy> strategy = AIStrategy::create(static_cast<AIStrategy::Type>(type));
+            BoardSnapshot board;
+            board.cells[0] = BoardSnapshot::Player;
+            board.usersTurn = false;
+
+            uint32_t seed = 1;
+            while (state.keepRunning())
+                strategy->decideMove(board, seed++);
+        });
+    }
+
+    //15x15 five in a row: a stone on and off again, which is all the evaluation costs
+    suite.add("LineBoard/makeUnmake/15x15", [](MicroBenchmark::State& state) {
+        LineBoard board(15, 15, 5);
+        int cell = 0;
+        while (state.keepRunning())
+        {
+            board.makeMove(cell, BoardSnapshot::Player);
+            board.unmakeMove(cell);
+            cell = (cell + 37) % board.getNumCells();
+        }
+        state.setItemsProcessed(state.getIterations());
+    });
+
+    //the same board a dozen moves into a game the search played against itself.  items are nodes.
+    suite.add("ThreatSearch/search/15x15/depth", [](MicroBenchmark::State& state) {
+        LineBoard board(15, 15, 5);
+        ThreatSearch opening;
+        uint8_t side = BoardSnapshot::Player;
+        for (int i = 0; i < 12 && board.winner() == BoardSnapshot::Empty; ++i)
+        {
+            board.makeMove(opening.search(board, side).cell, side);
+            side = BoardSnapshot::opponent(side);
+        }
+
+        ThreatSearch::Options options;
+        options.depth = static_cast<int>(state.getArg());
+        ThreatSearch search(options);
+
+        uint64_t nodes = 0;
+        while (state.keepRunning())
+            nodes += search.search(board, side).nodes;
+        state.setItemsProcessed(nodes);
+        state.setCounter("nodes", double(nodes) / state.getIterations());
+    }, { 4, 6 });
+
+    //random games to the end from an empty ultimate board, what the tree search spends its time on
+    suite.add("UltimateBoard/playout", [](MicroBenchmark::State& state) {
+        UltimateBoard empty;
+        uint64_t rng = 1;
+        uint64_t moves = 0;
+        while (state.keepRunning())
+        {
+            UltimateBoard board = empty;
+            board.playout(rng);
+            moves += board.numMoves;
+        }
+        state.setItemsProcessed(state.getIterations());
+        state.setCounter("moves", double(moves) / state.getIterations());
+    });
+
+    //a fixed number of playouts per move, so it's the search's overhead on top of them that shows
+    suite.add("UltimateSearch/decideMove/playouts", [](MicroBenchmark::State& state) {
+        UltimateSearch search(static_cast<int>(state.getArg()));
+        UltimateBoard board;
+        AISearchLimits limits;
+        limits.deadline = std::chrono::steady_clock::time_point::max();
+        uint64_t playouts = 0;
+        while (state.keepRunning())
+        {
+            limits.seed = static_cast<uint32_t>(state.getIterations());
+            playouts += search.decideMove(board, limits).playouts;
+        }
+        state.setItemsProcessed(playouts);
+    }, { 1000, 10000 });
+
+    //a few moves in, so there's something to block and something to build on
+    suite.add("QubicSearch/decideMove/depth", [](MicroBenchmark::State& state) {
+        QubicBoard board;
+        const int opening[] = { 0, 21, 63, 42, 3 };
+        for (int cell : opening)
+            board.play(cell);
+
+        QubicSearch search(static_cast<int>(state.getArg()));
+        AISearchLimits limits;
+        limits.deadline = std::chrono::steady_clock::time_point::max();
+        uint64_t nodes = 0;
+        while (state.keepRunning())
+            nodes += search.decideMove(board, limits).nodes;
+        state.setItemsProcessed(nodes);
+        state.setCounter("nodes", double(nodes) / state.getIterations());
+    }, { 3, 4 });
+
+    //a schedule and a cancel with the arg's worth of games already waiting, it should cost the
+    //same however many there are
+    suite.add("TimingWheel/scheduleCancel/pending", [](MicroBenchmark::State& state) {
+        auto start = TimingWheel::Clock::now();
+        TimingWheel wheel(std::chrono::milliseconds(1), start);
+        uint64_t rng = 1;
+        for (int64_t i = 0; i < state.getArg(); ++i)
+            wheel.schedule(start + std::chrono::milliseconds(GameEngine::nextRandom(rng) % 600000), []() {});
+
+        while (state.keepRunning())
+        {
+            TimingWheel::TimerId id = wheel.schedule(start + std::chrono::milliseconds(GameEngine::nextRandom(rng) % 600000), []() {});
+            wheel.cancel(id);
+        }
+        state.setItemsProcessed(state.getIterations());
+    }, { 1000, 1000000 });
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "AIStrategy.h"
+#include "MicroBenchmark.h"
+
+//the microbenchmarks that need nothing but the game code: the engine, each AI strategy on its
+//own, the bigger boards' searches and the timing wheel.  No Qt or OSG, so they build anywhere;
+//the app's --bench runs them along with its own, BenchmarkMain runs them on their own.
+class GameBenchmarks
+{
+public:
+    static void add(MicroBenchmark& suite);
+
+    //the AI strategies by their command line names, for benchmark names
+    static const char* StrategyNames[AIStrategy::NumTypes];
+};
@@ -0,0 +1,58 @@
+#include "GameChangeFeed.h"
+
+#include <assert.h>
+
+GameChangeFeed::GameChangeFeed() : m_latestGeneration(0)
+{
+    for (auto&& slot : m_slots)
+        slot.store(0, std::memory_order_relaxed);
+}
+
+void GameChangeFeed::publish(const GameDelta& delta)
+{
+    assert(delta.generation == m_latestGeneration.load(std::memory_order_relaxed) + 1);
+
+    m_slots[delta.generation % Capacity].store(delta.pack(), std::memory_order_release);
+    m_latestGeneration.store(delta.generation, std::memory_order_release);
+}
+
+GameChangeFeed::ReadResult GameChangeFeed::read(uint64_t afterGeneration, GameDelta* out, int maxDeltas, int& numRead) const
+{
+    numRead = 0;
+
+    uint64_t latest = getLatestGeneration();
+    if (latest <= afterGeneration)
+        return UpToDate;
+
+    //the slot we need has already been written over
+    if (latest - afterGeneration > Capacity)
+        return NeedsSnapshot;
+
+    for (uint64_t generation = afterGeneration + 1; generation <= latest && numRead < maxDeltas; ++generation)
+    {
+        GameDelta delta = GameDelta::unpack(m_slots[generation % Capacity].load(std::memory_order_acquire));
+
+        //the writer lapped us while we were reading
+        if (delta.generation != generation)
+            return NeedsSnapshot;
+
+        out[numRead++] = delta;
+    }
+    return Updated;
+}
+
+GameChangeFeed::ReadResult GameChangeFeed::catchUp(BoardSnapshot& board, int maxDeltas) const
+{
+    GameDelta deltas[Capacity];
+    if (maxDeltas > Capacity)
+        maxDeltas = Capacity;
+
+    int numRead = 0;
+    ReadResult result = read(board.generation, deltas, maxDeltas, numRead);
+    if (result != Updated)
+        return result;
+
+    for (int i = 0; i < numRead; ++i)
+        deltas[i].applyTo(board);
+    return Updated;
+}
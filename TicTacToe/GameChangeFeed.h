@@ -0,0 +1,98 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+#include "ZobristHash.h"
+
+#include <atomic>
+#include <cinttypes>
+
+//one change to the board.  Every change bumps the generation by exactly one,
+//so a reader can tell if it missed anything.
+struct GameDelta
+{
+    enum Type : uint8_t
+    {
+        CellSet = 0,        //cell now belongs to owner (Empty when a move is undone)
+        BoardCleared = 1
+    };
+
+    GameDelta() : generation(0), type(CellSet), cell(0), owner(BoardSnapshot::Empty), usersTurn(true) {}
+
+    //the whole thing fits in 64 bits so a ring slot is a single atomic
+    //generation:40 | type:8 | cell:8 | usersTurn:4 | owner:4
+    uint64_t pack() const
+    {
+        return (generation << 24) | (uint64_t(type) << 16) | (uint64_t(cell) << 8) | (uint64_t(usersTurn ? 1 : 0) << 4) | uint64_t(owner & 0xf);
+    }
+
+    static GameDelta unpack(uint64_t packed)
+    {
+        GameDelta delta;
+        delta.generation = packed >> 24;
+        delta.type = static_cast<Type>((packed >> 16) & 0xff);
+        delta.cell = static_cast<uint8_t>((packed >> 8) & 0xff);
+        delta.usersTurn = ((packed >> 4) & 0xf) != 0;
+        delta.owner = static_cast<uint8_t>(packed & 0xf);
+        return delta;
+    }
+
+    //brings a mirror of the board up to this delta
+    void applyTo(BoardSnapshot& board) const
+    {
+        if (type == BoardCleared)
+        {
+            board.cells.fill(BoardSnapshot::Empty);
+            board.hash = 0;
+        }
+        else
+        {
+            //out with whatever was there, in with the new owner
+            const ZobristHash& keys = ZobristHash::standard();
+            board.hash = keys.toggle(keys.toggle(board.hash, cell, board.cells[cell]), cell, owner);
+            board.cells[cell] = owner;
+        }
+        board.usersTurn = usersTurn;
+        board.generation = generation;
+    }
+
+    uint64_t generation;
+    Type type;
+    uint8_t cell;
+    uint8_t owner;
+    bool usersTurn;
+};
+
+//single writer, many reader ring of the most recent board changes.
+//GameMoveManager publishes while it holds its write lock; readers never lock anything.
+//each reader keeps its own cursor (the last generation it applied) and pulls whatever is
+//newer in batches.  If it falls more than Capacity changes behind, the old slots are gone
+//and it has to start over from a full snapshot.
+class GameChangeFeed
+{
+public:
+    static const int Capacity = 64;
+
+    enum ReadResult
+    {
+        UpToDate,       //nothing new
+        Updated,        //board caught up (maybe only partly if maxDeltas ran out, call again)
+        NeedsSnapshot   //too far behind, reload the whole board and keep going from its generation
+    };
+
+    GameChangeFeed();
+
+    //writer only.  delta.generation has to be exactly one past the last one published.
+    void publish(const GameDelta& delta);
+
+    uint64_t getLatestGeneration() const { return m_latestGeneration.load(std::memory_order_acquire); }
+
+    //copies up to maxDeltas changes newer than afterGeneration, oldest first
+    ReadResult read(uint64_t afterGeneration, GameDelta* out, int maxDeltas, int& numRead) const;
+
+    //read + apply, for readers that just want their mirror of the board up to date
+    ReadResult catchUp(BoardSnapshot& board, int maxDeltas = Capacity) const;
+
+protected:
+    std::atomic<uint64_t> m_slots[Capacity];
+    std::atomic<uint64_t> m_latestGeneration;
+};
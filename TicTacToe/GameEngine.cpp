@@ -0,0 +1,225 @@
+#include "GameEngine.h"
+#include "ZobristHash.h"
+
+#include <assert.h>
+
+namespace
+{
+    const int NumCells = 9;
+
+    GameEvent& addEvent(GameStep& step, GameEvent::Type type)
+    {
+        GameEvent& event = step.events[step.numEvents++];
+        event.type = type;
+        event.delta = GameDelta();
+        event.result = UserMoveAccepted;
+        event.winner = BoardSnapshot::Empty;
+        return event;
+    }
+
+    //set usersTurn first, the delta carries it
+    void changeBoard(GameStep& step, GameDelta::Type type, int cell, uint8_t owner)
+    {
+        GameDelta& delta = addEvent(step, GameEvent::BoardChanged).delta;
+        delta.generation = ++step.state.generation;
+        delta.type = type;
+        delta.cell = static_cast<uint8_t>(cell);
+        delta.owner = owner;
+        delta.usersTurn = step.state.usersTurn;
+    }
+
+    void tick(GameStep& step)
+    {
+        GameState& state = step.state;
+        ++state.clock;
+        if (state.usersTurn)
+            return;
+
+        BoardSnapshot board = state.getSnapshot();
+        if (!board.isGameOver())
+        {
+            addEvent(step, GameEvent::AIMoveDue);
+            return;
+        }
+
+        //the last move left the turn with the AI so the final board got a tick on screen, now score it
+        uint8_t winner = board.winner();
+        if (winner == BoardSnapshot::Player)
+            ++state.playerWins;
+        else if (winner == BoardSnapshot::AI)
+            ++state.aiWins;
+        else
+            ++state.catWins;
+        addEvent(step, GameEvent::GameOver).winner = winner;
+
+        state.moves.clear();
+        state.history.clear();
+        state.hash = 0;
+        state.usersTurn = true;
+        changeBoard(step, GameDelta::BoardCleared, 0, BoardSnapshot::Empty);
+    }
+
+    UserMoveResult userMove(GameStep& step, int cell)
+    {
+        GameState& state = step.state;
+        if (!state.usersTurn)
+            return UserMoveNotYourTurn;
+        if (cell >= NumCells)
+            return UserMoveInvalid;
+
+        PackedMove move(cell, BoardSnapshot::Player);
+        if (!state.moves.insertSorted(move))
+            return UserMoveSquareTaken;
+
+        state.history.push_back(move);
+        state.hash = ZobristHash::standard().toggle(state.hash, cell, BoardSnapshot::Player);
+        state.usersTurn = false;
+        changeBoard(step, GameDelta::CellSet, cell, BoardSnapshot::Player);
+        return UserMoveAccepted;
+    }
+
+    void aiMove(GameStep& step, int cell, uint64_t generation)
+    {
+        //thought about a board that isn't there anymore
+        GameState& state = step.state;
+        if (state.usersTurn || generation != state.generation || cell >= NumCells)
+            return;
+
+        BoardSnapshot board = state.getSnapshot();
+        if (board.isGameOver() || !state.moves.insertSorted(PackedMove(cell, BoardSnapshot::AI)))
+            return;
+
+        state.history.push_back(PackedMove(cell, BoardSnapshot::AI));
+        state.hash = ZobristHash::standard().toggle(state.hash, cell, BoardSnapshot::AI);
+        GameEngine::nextRandom(state.rng);
+
+        //if that ended it, leave the turn with us so the next tick scores it
+        board.cells[cell] = BoardSnapshot::AI;
+        state.usersTurn = !board.isGameOver();
+        changeBoard(step, GameDelta::CellSet, cell, BoardSnapshot::AI);
+    }
+
+    void undo(GameStep& step)
+    {
+        //pop back to (and including) the user's last move, that's whatever the AI
+        //has played since, which puts it back on the user
+        GameState& state = step.state;
+        bool hasUserMove = false;
+        for (auto move : state.history)
+            hasUserMove = hasUserMove || move.userMade();
+        if (!hasUserMove)
+            return;
+
+        state.usersTurn = true;
+
+        //one change per square, newest first
+        bool poppedUserMove = false;
+        while (!poppedUserMove)
+        {
+            PackedMove move = state.history.back();
+            state.history.pop_back();
+            state.hash = ZobristHash::standard().toggle(state.hash, move.cell(), move.owner());
+            poppedUserMove = move.userMade();
+            changeBoard(step, GameDelta::CellSet, move.cell(), BoardSnapshot::Empty);
+        }
+
+        state.moves.clear();
+        for (auto move : state.history)
+            state.moves.insertSorted(move);
+    }
+
+    void clear(GameStep& step)
+    {
+        step.state.moves.clear();
+        step.state.history.clear();
+        step.state.hash = 0;
+        changeBoard(step, GameDelta::BoardCleared, 0, BoardSnapshot::Empty);
+    }
+
+    uint64_t hashByte(uint64_t hash, uint8_t byte)
+    {
+        return (hash ^ byte) * 1099511628211ull;
+    }
+}
+
+BoardSnapshot GameState::getSnapshot() const
+{
+    BoardSnapshot snapshot;
+    for (auto move : moves)
+        snapshot.cells[move.cell()] = move.owner();
+    snapshot.usersTurn = usersTurn;
+    snapshot.generation = generation;
+    snapshot.hash = hash;
+    return snapshot;
+}
+
+GameState GameEngine::createState(uint64_t seed)
+{
+    GameState state;
+    state.rng = seed;
+    return state;
+}
+
+GameStep GameEngine::step(const GameState& state, const GameInput& input)
+{
+    GameStep step;
+    step.state = state;
+
+    switch (input.type)
+    {
+    case GameInput::Tick:
+        tick(step);
+        break;
+    case GameInput::UserMove:
+    {
+        UserMoveResult result = userMove(step, input.cell);
+        if (result != UserMoveAccepted)
+            addEvent(step, GameEvent::UserMoveRejected).result = result;
+        break;
+    }
+    case GameInput::AIMove:
+        aiMove(step, input.cell, input.generation);
+        break;
+    case GameInput::Undo:
+        undo(step);
+        break;
+    case GameInput::Clear:
+        clear(step);
+        break;
+    }
+
+    //the slow way, debug builds only
+    assert(step.state.hash == ZobristHash::standard().hashBoard(step.state.getSnapshot().cells.data()));
+    return step;
+}
+
+uint64_t GameEngine::nextRandom(uint64_t& state)
+{
+    //small and good enough, and the whole generator is one uint64 in the state
+    uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+uint32_t GameEngine::getAISeed(const GameState& state)
+{
+    uint64_t rng = state.rng;
+    uint64_t value = nextRandom(rng);
+    return static_cast<uint32_t>(value ^ (value >> 32));
+}
+
+uint64_t GameEngine::hashEvent(uint64_t hash, const GameEvent& event)
+{
+    //field by field, padding bytes aren't part of the trace
+    hash = hashByte(hash, event.type);
+    for (int shift = 0; shift < 64; shift += 8)
+        hash = hashByte(hash, static_cast<uint8_t>(event.delta.generation >> shift));
+    hash = hashByte(hash, event.delta.type);
+    hash = hashByte(hash, event.delta.cell);
+    hash = hashByte(hash, event.delta.owner);
+    hash = hashByte(hash, event.delta.usersTurn ? 1 : 0);
+    hash = hashByte(hash, event.result);
+    hash = hashByte(hash, event.winner);
+    return hash;
+}
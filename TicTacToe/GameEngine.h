@@ -0,0 +1,115 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+#include "GameChangeFeed.h"
+#include "PackedMoveList.h"
+
+#include <cinttypes>
+
+//how a user's move went
+enum UserMoveResult : uint8_t
+{
+    UserMoveAccepted,
+    UserMoveNotYourTurn,
+    UserMoveInvalid,
+    UserMoveSquareTaken
+};
+
+//everything about one game, by value.  No pointers, no Qt, nothing that knows what time it is:
+//time is clock, which only moves when somebody steps a Tick in.
+struct GameState
+{
+    GameState() : usersTurn(true), generation(0), hash(0), clock(0), rng(0), playerWins(0), aiWins(0), catWins(0) {}
+
+    BoardSnapshot getSnapshot() const;
+
+    PackedMoveList moves;       //cell order
+    PackedMoveList history;     //play order, for undo
+    bool usersTurn;
+    uint64_t generation;        //bumped once per GameDelta
+    uint64_t hash;              //zobrist hash of moves, one XOR per move placed or taken back
+    uint64_t clock;             //ticks so far
+    uint64_t rng;               //where the AI's seeds come from, moves on with every AI move
+    uint64_t playerWins;
+    uint64_t aiWins;
+    uint64_t catWins;
+};
+
+struct GameInput
+{
+    enum Type : uint8_t
+    {
+        Tick,       //the clock moves on one.  On the AI's turn that's either its cue or the end of the game.
+        UserMove,
+        AIMove,     //the answer to AIMoveDue, dropped if the board moved on since generation
+        Undo,
+        Clear
+    };
+
+    static GameInput tick() { return GameInput(Tick, 0, 0); }
+    static GameInput userMove(int cell) { return GameInput(UserMove, cell, 0); }
+    static GameInput aiMove(int cell, uint64_t generation) { return GameInput(AIMove, cell, generation); }
+    static GameInput undo() { return GameInput(Undo, 0, 0); }
+    static GameInput clear() { return GameInput(Clear, 0, 0); }
+
+    GameInput(Type type, int cell, uint64_t generation) : type(type), cell(static_cast<uint8_t>(cell)), generation(generation) {}
+
+    Type type;
+    uint8_t cell;
+    uint64_t generation;
+};
+
+struct GameEvent
+{
+    enum Type : uint8_t
+    {
+        BoardChanged,       //delta says how, it's what goes on the change feed
+        UserMoveRejected,   //result says why
+        AIMoveDue,          //ask the AI, seeded with GameEngine::getAISeed, and step its answer in
+        GameOver            //winner got credited, the board clear comes next
+    };
+
+    Type type;
+    GameDelta delta;
+    UserMoveResult result;
+    uint8_t winner;
+};
+
+//what one step hands back: the next state and what happened on the way
+struct GameStep
+{
+    static const int MaxEvents = 4;
+
+    GameStep() : numEvents(0) {}
+
+    const GameEvent* begin() const { return events; }
+    const GameEvent* end() const { return events + numEvents; }
+
+    GameState state;
+    GameEvent events[MaxEvents];
+    int numEvents;
+};
+
+//the rules, as a pure function.  The same state and input always give the same step, whatever
+//thread it's on and however long anything took, so a seed and a list of inputs is a whole game.
+//GameMoveManager drives it from its timer and the clicks; GameSimulation drives it flat out.
+//the AI isn't in here: a Tick on the AI's turn says AIMoveDue, whoever's driving asks the
+//strategy (however it likes) and steps the answer back in as an AIMove.
+class GameEngine
+{
+public:
+    static GameState createState(uint64_t seed);
+
+    static GameStep step(const GameState& state, const GameInput& input);
+
+    //the seed for the AI decision AIMoveDue asked for.  Depends only on the state.
+    static uint32_t getAISeed(const GameState& state);
+
+    //the engine's generator (splitmix64).  Drivers that need randomness of their own use it too,
+    //so a run depends on nothing but its seeds.
+    static uint64_t nextRandom(uint64_t& state);
+
+    //folds an event into a running trace hash (FNV-1a), so two runs can be compared with one number
+    static uint64_t hashEvent(uint64_t hash, const GameEvent& event);
+    static const uint64_t TraceHashStart = 14695981039346656037ull;
+};
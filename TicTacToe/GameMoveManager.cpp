@@ -1,134 +1,730 @@
 #include "GameMoveManager.h"
 
+#include <algorithm>
+#include <random>
+
 #include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+#include <QtConcurrent/QtConcurrentRun>
 
-GameMoveManager::GameMoveManager(QObject* parent) : QThread(parent), m_currentlyUsersTurn(true), m_playerWins(0), m_aiWins(0), m_catWins(0)
+namespace
 {
-    connect(&m_timer, &QTimer::timeout, this, &GameMoveManager::timeout);
-    m_timer.start(2000);
+    //how often our thread looks for clicks, about as fast as anybody can notice
+    const int UserMovePollMs = 5;
+
+    const size_t UserMoveBatchSize = 16;
+
+    //the user's line in the score store.  The AI gets one per strategy, under its name.
+    const char* PlayerScoreName = "Player";
+
+    //the ultimate and qubic AIs' lines, they're the same searches whatever strategy is picked for classic
+    const char* UltimateScoreName = "Ultimate MCTS";
+    const char* QubicScoreName = "Qubic Alpha-Beta";
+
+    //how long the AI waits before it answers, and a finished board stays up before it's cleared
+    const std::chrono::milliseconds TickDelay(2000);
 
-    //temp
-    m_playerWins = 2;
-    m_aiWins = 4;
-    m_catWins = 666;
+    //the classic strategies' deadlines are a few ms, which is only a few thousand playouts (or a
+    //couple of plies) on the bigger boards
+    const std::chrono::milliseconds VariantThinkTime(300);
+
+    ScoreStore::Outcome getOutcome(uint8_t side, uint8_t winner)
+    {
+        if (winner == BoardSnapshot::Empty)
+            return ScoreStore::Draw;
+        return winner == side ? ScoreStore::Win : ScoreStore::Loss;
+    }
+}
+
+GameMoveManager::GameMoveManager(QObject* parent, bool keepScores) : QThread(parent), m_tickTimer(0), m_tickScheduled(false), m_state(GameEngine::createState(std::random_device()())), m_currentlyUsersTurn(true), m_positionHash(0), m_boardGeneration(0), m_variant(Classic), m_ultimateGeneration(0), m_ultimateRng(std::random_device()()), m_qubicGeneration(0), m_aiJobGeneration(0)
+{
+    m_aiStrategy = AIStrategy::create(AIStrategy::FirstFree);
+
+    //never opened, results just add up in memory
+    if (!keepScores)
+    {
+        m_scoreStore.reset(new ScoreStore(ScoreStore::Options()));
+        return;
+    }
+
+    //the score picks up where the last run left off
+    QString scoreDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+    QDir().mkpath(scoreDir);
+
+    ScoreStore::Options scoreOptions;
+    scoreOptions.path = QDir(scoreDir).filePath("scores").toStdString();
+    m_scoreStore.reset(new ScoreStore(scoreOptions));
+    if (m_scoreStore->open())
+    {
+        ScoreStore::PlayerStats stats = m_scoreStore->getPlayerStats(PlayerScoreName);
+        m_state.playerWins = stats.wins;
+        m_state.aiWins = stats.losses;
+        m_state.catWins = stats.draws;
+    }
+    else
+    {
+        qWarning() << "Couldn't open the score store in" << scoreDir << ", scores won't be saved";
+    }
 }
 
 GameMoveManager::~GameMoveManager()
 {
+    //anything still thinking is stale now, let it bail and wait for it
+    ++m_boardGeneration;
+    ++m_ultimateGeneration;
+    ++m_qubicGeneration;
+
+    //a tick that's already fired only posts an event to us, which goes away with us.  Just don't go
+    //while it's posting.
+    if (!GameScheduler::shared().cancel(m_tickTimer))
+        GameScheduler::shared().waitForCallbacks();
+
+    QMutexLocker lock(&m_aiJobMutex);
+    for (auto&& job : m_aiJobs)
+        job.waitForFinished();
+}
+
+void GameMoveManager::run()
+{
+    //the timer belongs to this thread, so the drain happens here and not on whoever owns us
+    QTimer userMoveTimer;
+    connect(&userMoveTimer, &QTimer::timeout, &userMoveTimer, [this]() {
+        processUserMoves();
+    });
+    userMoveTimer.start(UserMovePollMs);
 
+    exec();
+}
+
+bool GameMoveManager::postUserMove(const MoveStruct& move)
+{
+    if (!isOnBoard(move))
+        return false;
+    return m_userMoveQueue.push(move);
+}
+
+bool GameMoveManager::takeUserMoveReply(UserMoveReply& reply)
+{
+    return m_userMoveReplies.pop(reply);
+}
+
+void GameMoveManager::processUserMoves()
+{
+    MoveStruct moves[UserMoveBatchSize];
+    size_t numMoves;
+    while ((numMoves = m_userMoveQueue.popBatch(moves, UserMoveBatchSize)) > 0)
+    {
+        //once one lands it's the AI's turn, the rest of the batch was clicked before anybody
+        //could see that and would only get told so
+        UserMoveReply reply;
+        for (size_t i = 0; i < numMoves; ++i)
+        {
+            reply.move = moves[i];
+            reply.result = storeUserMove(moves[i]);
+            if (reply.result == UserMoveAccepted)
+            {
+                qWarning() << "Successful Move a position " << moves[i].xPos << ", " << moves[i].yPos;
+                break;
+            }
+            qWarning() << getUserMoveMessage(reply.result);
+        }
+
+        //if they aren't reading, they don't get told.  Not worth blocking over.
+        m_userMoveReplies.push(reply);
+    }
+}
+
+const char* GameMoveManager::getUserMoveMessage(UserMoveResult result)
+{
+    switch (result)
+    {
+    case UserMoveNotYourTurn:
+        return "Not your turn!";
+    case UserMoveInvalid:
+        return "Not a valid move!";
+    case UserMoveSquareTaken:
+        return "Square already taken, pick again!";
+    default:
+        return "";
+    }
+}
+
+void GameMoveManager::scheduleTick()
+{
+    if (m_currentlyUsersTurn || m_tickScheduled.exchange(true))
+        return;
+
+    //the scheduler's pool only posts it.  The tick runs wherever we live, which is the GUI thread
+    //(we're never moved to our own), same as the QTimer it replaced.
+    m_tickTimer = GameScheduler::shared().schedule(TickDelay, [this]() {
+        QMetaObject::invokeMethod(this, "timeout", Qt::QueuedConnection);
+    });
 }
 
 void GameMoveManager::timeout()
 {
-    if (!m_currentlyUsersTurn)
-        makeNextAIMove();
+    m_tickScheduled = false;
+
+    if (m_variant != Classic)
+    {
+        variantTimeout();
+    }
+    else
+    {
+        GameStep step;
+        {
+            QWriteLocker lock(&m_rwLock);
+            step = applyInput(GameInput::tick());
+        }
+        handleStep(step);
+    }
+
+    //still the AI's turn (it's thinking, or it gave up on a stale board), it gets another cue
+    scheduleTick();
 }
 
-std::vector<MoveStruct> GameMoveManager::getAllCurrentMoves() const
+GameStep GameMoveManager::applyInput(const GameInput& input)
+{
+    GameStep step = GameEngine::step(m_state, input);
+    m_state = step.state;
+    m_currentlyUsersTurn = m_state.usersTurn;
+    m_positionHash = m_state.hash;
+
+    for (auto&& event : step)
+    {
+        if (event.type != GameEvent::BoardChanged)
+            continue;
+        m_boardGeneration = event.delta.generation;
+        m_changeFeed.publish(event.delta);
+    }
+    return step;
+}
+
+void GameMoveManager::handleStep(const GameStep& step)
+{
+    bool undone = false;
+    for (auto&& event : step)
+    {
+        switch (event.type)
+        {
+        case GameEvent::BoardChanged:
+            if (event.delta.type == GameDelta::BoardCleared)
+                emit boardCleared();
+            else if (event.delta.owner == BoardSnapshot::Empty)
+                undone = true;
+            else
+                emit moveStored(PackedMove(event.delta.cell, event.delta.owner).toMoveStruct());
+            break;
+        case GameEvent::AIMoveDue:
+            requestAIMove();
+            break;
+        case GameEvent::GameOver:
+            recordGameOver(step.state, event.winner);
+            break;
+        default:
+            break;
+        }
+    }
+
+    //listeners only know about stores and clears, so replay what's left
+    if (undone)
+    {
+        emit boardCleared();
+        for (auto move : step.state.history)
+            emit moveStored(move.toMoveStruct());
+    }
+
+    scheduleTick();
+}
+
+QFuture<MoveStruct> GameMoveManager::requestAIMove()
+{
+    QMutexLocker lock(&m_aiJobMutex);
+
+    //forget about jobs that are done
+    m_aiJobs.erase(std::remove_if(m_aiJobs.begin(), m_aiJobs.end(), [](const QFuture<MoveStruct>& job) {
+        return job.isFinished();
+    }), m_aiJobs.end());
+
+    //already working on this board
+    uint64_t generation = getCurrentGeneration();
+    if (!m_aiJobs.empty() && m_aiJobGeneration == generation)
+        return m_aiJobs.back();
+
+    m_aiJobGeneration = generation;
+    m_aiJobs.push_back(QtConcurrent::run([this]() {
+        return makeNextAIMove();
+    }));
+    return m_aiJobs.back();
+}
+
+PackedMoveList GameMoveManager::getCurrentMoves() const
 {
     QReadLocker lock(&m_rwLock);
     //this function returns a copy, and the locker stays in scope
     //until the copy is made.
-    return m_currentMoves;
+    return m_state.moves;
 }
 
-void GameMoveManager::clearGame()
+std::vector<MoveStruct> GameMoveManager::getAllCurrentMoves() const
+{
+    return getCurrentMoves().toMoveStructs();
+}
+
+BoardSnapshot GameMoveManager::getSnapshot() const
 {
+    QReadLocker lock(&m_rwLock);
+    return m_state.getSnapshot();
+}
+
+void GameMoveManager::setAIStrategy(std::shared_ptr<AIStrategy> strategy)
+{
+    if (!strategy)
+        return;
+
     QWriteLocker lock(&m_rwLock);
-    m_currentMoves.clear();
-    emit boardCleared();
+    m_aiStrategy = strategy;
 }
 
-bool GameMoveManager::storeUserMadeMove(const MoveStruct& move, std::string& errorMsg)
+void GameMoveManager::getScore(uint64_t& playerScore, uint64_t& aiScore, uint64_t& catScore) const
 {
-    if (!m_currentlyUsersTurn)
+    QReadLocker lock(&m_rwLock);
+    playerScore = m_state.playerWins;
+    aiScore = m_state.aiWins;
+    catScore = m_state.catWins;
+}
+
+std::shared_ptr<AIStrategy> GameMoveManager::getAIStrategy() const
+{
+    QReadLocker lock(&m_rwLock);
+    return m_aiStrategy;
+}
+
+void GameMoveManager::clearGame()
+{
+    if (m_variant != Classic)
     {
-        errorMsg = "Not your turn!";
-        return false;
+        {
+            QWriteLocker lock(&m_rwLock);
+            clearVariantBoards();
+        }
+        emit boardCleared();
+        return;
     }
-    //quick bail error check
-    if (move.xPos > 2 || move.yPos > 2)
+
+    GameStep step;
     {
-        errorMsg = "Not a valid move!";
-        return false;
+        QWriteLocker lock(&m_rwLock);
+        step = applyInput(GameInput::clear());
     }
+    handleStep(step);
+}
+
+bool GameMoveManager::undoLastMove()
+{
+    if (m_variant == Ultimate)
+        return undoUltimateMove();
+    if (m_variant == Qubic)
+        return undoQubicMove();
+
+    //anybody thinking about the old board is out of luck
+    GameStep step;
+    {
+        QWriteLocker lock(&m_rwLock);
+        step = applyInput(GameInput::undo());
+    }
+    handleStep(step);
+    return step.numEvents > 0;
+}
+
+bool GameMoveManager::storeUserMadeMove(const MoveStruct& move, std::string& errorMsg)
+{
+    UserMoveResult result = storeUserMove(move);
+    errorMsg = getUserMoveMessage(result);
+    return result == UserMoveAccepted;
+}
+
+UserMoveResult GameMoveManager::storeUserMove(const MoveStruct& move)
+{
+    if (m_variant == Ultimate)
+        return storeUltimateMove(move);
+    if (m_variant == Qubic)
+        return storeQubicMove(move);
+
+    //quick bail error checks, the engine makes them again under the lock
+    if (!m_currentlyUsersTurn)
+        return UserMoveNotYourTurn;
+    if (move.xPos > 2 || move.yPos > 2)
+        return UserMoveInvalid;
 
     //if this happened all the time, we could do a read lock, check for error,
     //then write lock to store.  But it doesn't.  So there.
-    QWriteLocker lock(&m_rwLock);
+    GameStep step;
+    {
+        QWriteLocker lock(&m_rwLock);
+        step = applyInput(GameInput::userMove(BoardSnapshot::index(move.xPos, move.yPos)));
+    }
+    handleStep(step);
+
+    for (auto&& event : step)
+        if (event.type == GameEvent::UserMoveRejected)
+            return event.result;
+    return UserMoveAccepted;
+}
+
+//"AI"... less haha now, the thinking lives in AIStrategy
+MoveStruct GameMoveManager::makeNextAIMove()
+{
+    if (m_variant == Ultimate)
+        return makeNextUltimateAIMove();
+    if (m_variant == Qubic)
+        return makeNextQubicAIMove();
+
+    BoardSnapshot board;
+    std::shared_ptr<AIStrategy> strategy;
+    AISearchLimits limits;
 
-    //first move
-    if (m_currentMoves.empty())
+    //only hold the lock long enough to copy the board.  The seed comes from the same state, so a
+    //game plays out the same here as it does in GameSimulation.
     {
-        m_currentMoves.push_back(move);
+        QReadLocker lock(&m_rwLock);
+        if (m_state.usersTurn)
+            return MoveStruct();
+        board = m_state.getSnapshot();
+        strategy = m_aiStrategy;
+        limits.seed = GameEngine::getAISeed(m_state);
+    }
+
+    //the next tick scores it
+    if (board.isGameOver())
+        return MoveStruct();
+
+    //the slow part, nobody is waiting on us while we think.
+    //if the board moves on, the token trips and the search quits early
+    limits.deadline = std::chrono::steady_clock::now() + strategy->getDeadline();
+    limits.cancel = AICancelToken(&m_boardGeneration, board.generation);
+    int cell = strategy->decideMove(board, limits);
+    if (cell < 0)
+        return MoveStruct();
+
+    //if the board changed out from under us (new game, etc) the engine drops it
+    GameStep step;
+    {
+        QWriteLocker lock(&m_rwLock);
+        step = applyInput(GameInput::aiMove(cell, board.generation));
+    }
+    handleStep(step);
+
+    if (!step.numEvents)
+        return MoveStruct();
+    return PackedMove(cell, BoardSnapshot::AI).toMoveStruct();
+}
+
+void GameMoveManager::recordGameOver(const GameState& state, uint8_t winner)
+{
+    std::shared_ptr<AIStrategy> strategy = getAIStrategy();
+
+    //only goes in memory here, the store's writer gets it to disk
+    m_scoreStore->recordResult(PlayerScoreName, getOutcome(BoardSnapshot::Player, winner));
+    m_scoreStore->recordResult(strategy->getName(), getOutcome(BoardSnapshot::AI, winner));
+
+    qWarning() << "Game Over!";
+
+    emit scoreUpdated(state.playerWins, state.aiWins, state.catWins);
+}
+
+void GameMoveManager::setVariant(Variant variant)
+{
+    GameStep step;
+    {
+        QWriteLocker lock(&m_rwLock);
+        if (variant == m_variant)
+            return;
+
+        //every board starts over, and whatever the AI was thinking about is stale either way
+        m_variant = variant;
+        clearVariantBoards();
+        step = applyInput(GameInput::clear());
+
+        //the classic engine says whose turn it is over there, the user always starts the others
+        if (variant != Classic)
+            m_currentlyUsersTurn = true;
+    }
+    handleStep(step);
+}
+
+UltimateBoard GameMoveManager::getUltimateBoard() const
+{
+    QReadLocker lock(&m_rwLock);
+    return m_ultimate;
+}
+
+bool GameMoveManager::isOnBoard(const MoveStruct& move) const
+{
+    switch (m_variant)
+    {
+    case Ultimate:
+        return move.xPos < 9 && move.yPos < 9;
+    case Qubic:
+        return move.xPos < QubicBoard::Size && move.yPos < QubicBoard::Size * QubicBoard::Size;
+    default:
+        return move.xPos < 3 && move.yPos < 3;
+    }
+}
+
+void GameMoveManager::clearVariantBoards()
+{
+    m_ultimate = UltimateBoard();
+    m_ultimateHistory.clear();
+    ++m_ultimateGeneration;
+
+    m_qubic = QubicBoard();
+    m_qubicHistory.clear();
+    ++m_qubicGeneration;
+
+    if (m_variant != Classic)
+        m_currentlyUsersTurn = true;
+}
+
+UserMoveResult GameMoveManager::storeUltimateMove(const MoveStruct& move)
+{
+    if (move.xPos > 8 || move.yPos > 8)
+        return UserMoveInvalid;
+
+    int cell = UltimateBoard::cellFromXY(move.xPos, move.yPos);
+    {
+        QWriteLocker lock(&m_rwLock);
+        if (m_ultimate.sideToMove != BoardSnapshot::Player || m_ultimate.isGameOver())
+            return UserMoveNotYourTurn;
+        if (m_ultimate.at(cell) != BoardSnapshot::Empty)
+            return UserMoveSquareTaken;
+
+        //empty, but not in the small board the last move sent us to
+        UltimateBoard before = m_ultimate;
+        if (!m_ultimate.play(cell))
+            return UserMoveInvalid;
+
+        m_ultimateHistory.push_back(before);
+        ++m_ultimateGeneration;
         m_currentlyUsersTurn = false;
-        emit moveStored(move);
-        return true;
     }
 
-    auto movePosItr = std::lower_bound(m_currentMoves.begin(), m_currentMoves.end(), move);
-    if (movePosItr != m_currentMoves.end() && ( (*movePosItr).xPos == move.xPos && (*movePosItr).yPos == move.yPos ))
+    //the AI answers on the next tick, same as classic
+    emit moveStored(MoveStruct(move.xPos, move.yPos, true));
+    scheduleTick();
+    return UserMoveAccepted;
+}
+
+MoveStruct GameMoveManager::makeNextUltimateAIMove()
+{
+    UltimateBoard board;
+    uint64_t generation;
+    AISearchLimits limits;
+    {
+        QWriteLocker lock(&m_rwLock);
+        if (m_ultimate.sideToMove != BoardSnapshot::AI || m_ultimate.isGameOver())
+            return MoveStruct();
+        board = m_ultimate;
+        generation = m_ultimateGeneration;
+        limits.seed = static_cast<uint32_t>(GameEngine::nextRandom(m_ultimateRng));
+        limits.deadline = std::chrono::steady_clock::now() + VariantThinkTime;
+    }
+    limits.cancel = AICancelToken(&m_ultimateGeneration, generation);
+
+    UltimateSearch::Result result;
     {
-        errorMsg = "Square already taken, pick again!";
-        return false;
+        QMutexLocker lock(&m_ultimateSearchMutex);
+        result = m_ultimateSearch.decideMove(board, limits);
+    }
+    if (result.cell < 0)
+        return MoveStruct();
+
+    {
+        QWriteLocker lock(&m_rwLock);
+        if (generation != m_ultimateGeneration)
+            return MoveStruct();
+
+        m_ultimateHistory.push_back(m_ultimate);
+        m_ultimate.play(result.cell);
+        ++m_ultimateGeneration;
+
+        //if that ended it, leave the turn with us so the next tick scores it
+        m_currentlyUsersTurn = !m_ultimate.isGameOver();
     }
 
-    m_currentMoves.insert(movePosItr, move);
-    m_currentlyUsersTurn = false;
+    MoveStruct move(static_cast<uint8_t>(UltimateBoard::xFromCell(result.cell)), static_cast<uint8_t>(UltimateBoard::yFromCell(result.cell)), false);
     emit moveStored(move);
+
+    //if it just won, the board still has to be scored
+    scheduleTick();
+    return move;
+}
+
+bool GameMoveManager::undoUltimateMove()
+{
+    {
+        QWriteLocker lock(&m_rwLock);
+
+        //back to (and including) the user's last move, same as classic
+        bool hasUserMove = false;
+        for (auto&& board : m_ultimateHistory)
+            hasUserMove = hasUserMove || board.sideToMove == BoardSnapshot::Player;
+        if (!hasUserMove)
+            return false;
+
+        bool poppedUserMove = false;
+        while (!poppedUserMove)
+        {
+            m_ultimate = m_ultimateHistory.back();
+            m_ultimateHistory.pop_back();
+            poppedUserMove = m_ultimate.sideToMove == BoardSnapshot::Player;
+        }
+
+        ++m_ultimateGeneration;
+        m_currentlyUsersTurn = true;
+    }
+
+    emit boardCleared();
     return true;
 }
 
-//"AI"... haha
-MoveStruct GameMoveManager::makeNextAIMove()
+QubicBoard GameMoveManager::getQubicBoard() const
 {
-    QWriteLocker lock(&m_rwLock);
+    QReadLocker lock(&m_rwLock);
+    return m_qubic;
+}
+
+UserMoveResult GameMoveManager::storeQubicMove(const MoveStruct& move)
+{
+    if (move.xPos >= QubicBoard::Size || move.yPos >= QubicBoard::Size * QubicBoard::Size)
+        return UserMoveInvalid;
+
+    int cell = QubicBoard::cellFromMove(move);
+    {
+        QWriteLocker lock(&m_rwLock);
+        if (m_qubic.sideToMove != BoardSnapshot::Player || m_qubic.isGameOver())
+            return UserMoveNotYourTurn;
+        if (!m_qubic.play(cell))
+            return UserMoveSquareTaken;
+
+        m_qubicHistory.push_back(static_cast<uint8_t>(cell));
+        ++m_qubicGeneration;
+        m_currentlyUsersTurn = false;
+    }
+
+    emit moveStored(QubicBoard::getMove(cell, true));
+    scheduleTick();
+    return UserMoveAccepted;
+}
+
+MoveStruct GameMoveManager::makeNextQubicAIMove()
+{
+    QubicBoard board;
+    uint64_t generation;
+    AISearchLimits limits;
+    {
+        QReadLocker lock(&m_rwLock);
+        if (m_qubic.sideToMove != BoardSnapshot::AI || m_qubic.isGameOver())
+            return MoveStruct();
+        board = m_qubic;
+        generation = m_qubicGeneration;
+    }
+    limits.deadline = std::chrono::steady_clock::now() + VariantThinkTime;
+    limits.cancel = AICancelToken(&m_qubicGeneration, generation);
 
-    //for now, we'll just take the next square.
-    //TODO - make this less dumb.
-    if (m_currentMoves.empty())
+    QubicSearch::Result result;
     {
-        MoveStruct nextMove;
-        m_currentMoves.push_back(nextMove);
+        QMutexLocker lock(&m_qubicSearchMutex);
+        result = m_qubicSearch.decideMove(board, limits);
+    }
+    if (result.cell < 0)
+        return MoveStruct();
+
+    {
+        QWriteLocker lock(&m_rwLock);
+        if (generation != m_qubicGeneration)
+            return MoveStruct();
+
+        m_qubic.play(result.cell);
+        m_qubicHistory.push_back(static_cast<uint8_t>(result.cell));
+        ++m_qubicGeneration;
+
+        //if that ended it, leave the turn with us so the next tick scores it
+        m_currentlyUsersTurn = !m_qubic.isGameOver();
+    }
+
+    MoveStruct move = QubicBoard::getMove(result.cell, false);
+    emit moveStored(move);
+
+    //if it just won, the board still has to be scored
+    scheduleTick();
+    return move;
+}
+
+bool GameMoveManager::undoQubicMove()
+{
+    {
+        QWriteLocker lock(&m_rwLock);
+
+        //the user always moves first, so any move at all means there's one of theirs to go back to
+        if (m_qubicHistory.empty())
+            return false;
+
+        bool poppedUserMove = false;
+        while (!poppedUserMove)
+        {
+            m_qubic.undo(m_qubicHistory.back());
+            m_qubicHistory.pop_back();
+            poppedUserMove = m_qubic.sideToMove == BoardSnapshot::Player;
+        }
+
+        ++m_qubicGeneration;
         m_currentlyUsersTurn = true;
-        emit moveStored(nextMove);
-        return nextMove;
     }
 
-    MoveStruct nextMove;
-    bool moveFound = false;
-    for (int x = 0; x <= 2; ++x)
+    emit boardCleared();
+    return true;
+}
+
+void GameMoveManager::variantTimeout()
+{
+    uint8_t winner = BoardSnapshot::Empty;
+    const char* aiScoreName = m_variant == Qubic ? QubicScoreName : UltimateScoreName;
     {
-        for (int y = 0; y <= 2; ++y)
+        QWriteLocker lock(&m_rwLock);
+        bool gameOver = m_variant == Qubic ? m_qubic.isGameOver() : m_ultimate.isGameOver();
+        if (!gameOver)
         {
-            if (!moveFound)
+            //not over, and if it's the AI's turn this is its cue
+            uint8_t sideToMove = m_variant == Qubic ? m_qubic.sideToMove : m_ultimate.sideToMove;
+            if (sideToMove == BoardSnapshot::AI)
             {
-                nextMove.xPos = x;
-                nextMove.yPos = y;
-                auto movePosItr = std::lower_bound(m_currentMoves.begin(), m_currentMoves.end(), nextMove);
-                if (movePosItr == m_currentMoves.end() || ((*movePosItr).xPos != nextMove.xPos && (*movePosItr).yPos != nextMove.yPos))
-                {
-                    moveFound = true;
-                }
+                lock.unlock();
+                requestAIMove();
             }
+            return;
         }
-    }
 
-    if (!moveFound)
-    {
-        //todo, find winner
-        emit scoreUpdated(m_playerWins, m_aiWins, m_catWins);
-        qWarning() << "Game Over!";
-        m_currentMoves.clear();
-        emit boardCleared();
-        return MoveStruct();
+        winner = m_variant == Qubic ? m_qubic.winner : m_ultimate.winner;
+        if (winner == BoardSnapshot::Player)
+            ++m_state.playerWins;
+        else if (winner == BoardSnapshot::AI)
+            ++m_state.aiWins;
+        else
+            ++m_state.catWins;
+        clearVariantBoards();
     }
 
-    auto movePosItr = std::lower_bound(m_currentMoves.begin(), m_currentMoves.end(), nextMove);
-    m_currentMoves.insert(movePosItr, nextMove);
-    nextMove.userMadeMove = false;
-    m_currentlyUsersTurn = true;
-    emit moveStored(nextMove);
-    return nextMove;
-}
+    m_scoreStore->recordResult(PlayerScoreName, getOutcome(BoardSnapshot::Player, winner));
+    m_scoreStore->recordResult(aiScoreName, getOutcome(BoardSnapshot::AI, winner));
+
+    qWarning() << "Game Over!";
+    emit boardCleared();
 
+    uint64_t playerWins;
+    uint64_t aiWins;
+    uint64_t catWins;
+    getScore(playerWins, aiWins, catWins);
+    emit scoreUpdated(playerWins, aiWins, catWins);
+}
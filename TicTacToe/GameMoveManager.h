@@ -1,79 +1,43 @@
 #pragma once
 
+#include "BoardSnapshot.h"
+#include "AIStrategy.h"
+#include "GameChangeFeed.h"
+#include "GameEngine.h"
+#include "GameScheduler.h"
+#include "MoveStruct.h"
+#include "PackedMoveList.h"
+#include "QubicBoard.h"
+#include "QubicSearch.h"
+#include "ScoreStore.h"
+#include "SpscQueue.h"
+#include "UltimateBoard.h"
+#include "UltimateSearch.h"
+
+#include <atomic>
 #include <cinttypes>
+#include <memory>
 #include <vector>
 #include <string>
 
+#include <QFuture>
+#include <QMutex>
 #include <QReadWriteLock>
 #include <QObject>
 #include <QThread>
 #include <QTimer>
 
-//this is the data struct we'll use to define a "move"
-//x and y position, *should* be between 0 and 2
-struct MoveStruct {
+//moves are plain bytes as far as Qt is concerned, it can memcpy them through queued signals
+Q_DECLARE_TYPEINFO(MoveStruct, Q_PRIMITIVE_TYPE);
+Q_DECLARE_TYPEINFO(PackedMove, Q_PRIMITIVE_TYPE);
 
-    MoveStruct() : xPos(0), yPos(0), userMadeMove(false) {};
-    MoveStruct(uint8_t x, uint8_t y, bool userMade) : xPos(x), yPos(y), userMadeMove(userMade){};
-    MoveStruct(const MoveStruct& other) : xPos(other.xPos), yPos(other.yPos), userMadeMove(other.userMadeMove){};
-    MoveStruct(MoveStruct&& other) :  xPos(std::move(other.xPos)), yPos(std::move(other.yPos)), userMadeMove(std::move(other.userMadeMove)) {};
-    ~MoveStruct() {};
-
-    uint8_t xPos;
-    uint8_t yPos;
-    bool userMadeMove;
-
-    //for our purposes, moves go sequentially from 0,0 to 2,2
-    //left to right, top to bottom, 0,0 being top left
-    inline bool operator< (const MoveStruct& rhs) const
-    {
-        if (this->yPos < rhs.yPos)
-            return true;
-        else if (this->yPos == rhs.yPos)
-            if (this->xPos < rhs.xPos)
-                return true;
-        return false;
-    }
-    inline bool operator> (const MoveStruct& rhs) const
-    {
-        return (rhs < *this);
-    }
-    inline bool operator<=(const MoveStruct& rhs) const
-    { 
-        return !(*this > rhs);
-    }
-    inline bool operator>=(const MoveStruct& rhs) const
-    { 
-        return !(*this < rhs);
-    }
-    inline bool operator==(const MoveStruct& rhs) const
-    {
-        return (this->xPos == rhs.xPos && this->yPos == rhs.yPos && this->userMadeMove == rhs.userMadeMove);
-    }
-    inline bool operator!=(const MoveStruct& rhs) const
-    {
-        return !(*this == rhs);
-    }
-
-    //copy and move
-    inline MoveStruct& operator=(const MoveStruct& other)
-    {
-        this->xPos = other.xPos;
-        this->yPos = other.yPos;
-        this->userMadeMove = other.userMadeMove;
-        return *this;
-    }
-
-    inline MoveStruct& operator= (MoveStruct&& other)
-    {
-        this->xPos = std::move(other.xPos);
-        this->yPos = std::move(other.yPos);
-        this->userMadeMove = std::move(other.userMadeMove);
-        return *this;
-    }
+//what comes back to the render thread for moves it posted
+struct UserMoveReply
+{
+    MoveStruct move;
+    UserMoveResult result;
 };
 
-
 //This class is designed to be accessed by multiple threads
 //let's be responsible people
 
@@ -85,22 +49,87 @@ class GameMoveManager : public QThread
 {
     Q_OBJECT
 public:
-    GameMoveManager(QObject* parent = nullptr);
+    enum Variant
+    {
+        Classic,
+        Ultimate,   //9x9, see UltimateBoard.  Moves are x/y on the 9x9 grid, the AI is always UltimateSearch.
+        Qubic       //4x4x4, see QubicBoard for how a cell fits in a MoveStruct.  The AI is always QubicSearch.
+    };
+
+    //keepScores false keeps the score in memory only and never touches the user's score files, for
+    //benchmarks and anything else that mustn't disturb the real app's log
+    GameMoveManager(QObject* parent = nullptr, bool keepScores = true);
     virtual ~GameMoveManager();
 
+    //starts a new game of that kind.  The score carries on, it's still you against the computer.
+    void setVariant(Variant variant);
+    Variant getVariant() const { return m_variant; }
+
+    //whether a move's x/y are on the board of the variant being played
+    bool isOnBoard(const MoveStruct& move) const;
+
+    //copy of the ultimate board.  It only changes when getUltimateGeneration does, so check that first.
+    UltimateBoard getUltimateBoard() const;
+    uint64_t getUltimateGeneration() const { return m_ultimateGeneration; }
+
+    //same for qubic
+    QubicBoard getQubicBoard() const;
+    uint64_t getQubicGeneration() const { return m_qubicGeneration; }
+
+    //every move on the board in cell order, by value, no allocation
+    PackedMoveList getCurrentMoves() const;
+
+    //same thing the old way, for callers that want MoveStructs
     std::vector<MoveStruct> getAllCurrentMoves() const;
+
+    //copy of the board for anybody who wants to think about it without holding our lock
+    BoardSnapshot getSnapshot() const;
+
+    //every change to the board, in order, for views that keep their own copy.
+    //read it with no locks; if it says you're too far behind, start over from getSnapshot().
+    const GameChangeFeed& getChangeFeed() const { return m_changeFeed; }
+
+    //swap the AI out at runtime, takes effect on the AI's next move
+    void setAIStrategy(std::shared_ptr<AIStrategy> strategy);
+    std::shared_ptr<AIStrategy> getAIStrategy() const;
     
+    //what scoreUpdated last said, for anybody who wasn't listening yet
+    void getScore(uint64_t& playerScore, uint64_t& aiScore, uint64_t& catScore) const;
+
     //clears out all of the moves
     void clearGame();
 
+    //takes back the user's last move (and the AI's answer to it), returns false if there's nothing to undo
+    bool undoLastMove();
+
     bool isCurrentlyUsersTurn() const { return m_currentlyUsersTurn; }
 
+    //zobrist hash of the board right now (see ZobristHash), without the lock or a snapshot
+    uint64_t getPositionHash() const { return m_positionHash; }
+
     //decides the next AI move, stores and retrns it
+    //the strategy thinks on a snapshot, the lock is only held to copy the board and to store the move.
+    //if the board changes while we think (new game, undo) the decision is abandoned and nothing is stored.
     MoveStruct makeNextAIMove();
 
+    //same as makeNextAIMove, but on the shared thread pool.  Asking again for the same
+    //board hands back the job that's already running instead of starting another.
+    QFuture<MoveStruct> requestAIMove();
+
     //stores a user made move, returns false if not successful, with error msg
     bool storeUserMadeMove(const MoveStruct& move, std::string& errorMsg);
 
+    //render thread only.  Queues a click for our thread to apply, never touches our locks.
+    //false if the queue's full (or it's not a real square) and the click is dropped.
+    bool postUserMove(const MoveStruct& move);
+
+    //render thread only.  One reply per batch of posted moves we worked through: the move that
+    //was accepted, or the last one that wasn't.
+    bool takeUserMoveReply(UserMoveReply& reply);
+
+    //what to tell the user, empty when there's nothing to say
+    static const char* getUserMoveMessage(UserMoveResult result);
+
 signals:
     void moveStored(const MoveStruct&);
     void boardCleared();
@@ -110,20 +139,109 @@ protected slots:
     void timeout();
 
 protected:
+    //our own thread, just an event loop that also drains the posted moves
+    virtual void run();
+
+    //applies whatever the render thread has posted since last time
+    void processUserMoves();
+
+    UserMoveResult storeUserMove(const MoveStruct& move);
+
+    //must hold the write lock.  Steps the engine, keeps the lock free copies of the turn and
+    //the generation up to date and puts the board changes on the feed.
+    GameStep applyInput(const GameInput& input);
+
+    //no lock.  Tells everybody listening what a step did, and asks the AI for a move if it's due.
+    void handleStep(const GameStep& step);
+
+    //the score store and the log, for a game the engine just finished
+    void recordGameOver(const GameState& state, uint8_t winner);
+
+    //the same API for the ultimate and qubic boards, which GameEngine doesn't know about.  The rules
+    //are all the boards' own, these just keep the history and the generation.
+    UserMoveResult storeUltimateMove(const MoveStruct& move);
+    MoveStruct makeNextUltimateAIMove();
+    bool undoUltimateMove();
+
+    UserMoveResult storeQubicMove(const MoveStruct& move);
+    MoveStruct makeNextQubicAIMove();
+    bool undoQubicMove();
+
+    //scores a finished game, or asks the AI for a move when it's its turn
+    void variantTimeout();
+
+    //a tick only does anything while it isn't the user's turn (the AI's cue, or a finished board to
+    //score), so that's the only time there's one coming.  Safe from any thread, does nothing if
+    //one's already on the way.
+    void scheduleTick();
+
+    //the ultimate and qubic boards both, must hold the write lock
+    void clearVariantBoards();
+
+    //whichever board the AI is thinking about
+    uint64_t getCurrentGeneration() const
+    {
+        switch (m_variant)
+        {
+        case Ultimate:
+            return m_ultimateGeneration;
+        case Qubic:
+            return m_qubicGeneration;
+        default:
+            return m_boardGeneration;
+        }
+    }
+
+    //the next tick, on GameScheduler::shared().  Each one steps the engine's clock once, that's
+    //all the time the rules know about; idle boards don't get any.
+    std::atomic<TimingWheel::TimerId> m_tickTimer;
+    std::atomic<bool> m_tickScheduled;
+
+    //the board, the turn, the score: everything the rules care about, changed only by applyInput
+    GameState m_state;
+
+    //copies of m_state's, so they can be read without the lock
+    std::atomic<bool> m_currentlyUsersTurn;
+    std::atomic<uint64_t> m_positionHash;
+
+    //AI jobs compare against this without the lock to find out they've gone stale
+    std::atomic<uint64_t> m_boardGeneration;
+
+    GameChangeFeed m_changeFeed;
+
+    std::atomic<Variant> m_variant;
+
+    //the ultimate game, under the same lock.  The history is the board before each move, for undo.
+    UltimateBoard m_ultimate;
+    std::vector<UltimateBoard> m_ultimateHistory;
+    std::atomic<uint64_t> m_ultimateGeneration;
+    uint64_t m_ultimateRng;
+
+    //one search at a time, a stale one is told to stop and gets out of the way quickly
+    QMutex m_ultimateSearchMutex;
+    UltimateSearch m_ultimateSearch;
+
+    //qubic, the same again.  Undo just takes the cells back off, so the history is only the cells.
+    QubicBoard m_qubic;
+    std::vector<uint8_t> m_qubicHistory;
+    std::atomic<uint64_t> m_qubicGeneration;
+    QMutex m_qubicSearchMutex;
+    QubicSearch m_qubicSearch;
 
-    QTimer m_timer;
+    //render thread -> us, and the answers going back.  MoveStructs, an ultimate cell doesn't fit in a PackedMove.
+    SpscQueue<MoveStruct, 64> m_userMoveQueue;
+    SpscQueue<UserMoveReply, 64> m_userMoveReplies;
 
-    //we'll sort this, mostly for convienience, but also so we can
-    //surf down in order and make the next "dumb" move until 
-    //I make this thing smart enough to win
-    std::vector<MoveStruct> m_currentMoves;
+    std::shared_ptr<AIStrategy> m_aiStrategy;
 
-    bool m_currentlyUsersTurn;
+    //outstanding AI jobs, including stale ones still winding down.  We wait on these before we go away.
+    QMutex m_aiJobMutex;
+    std::vector<QFuture<MoveStruct>> m_aiJobs;
+    uint64_t m_aiJobGeneration;
 
     //if we do more reads than writes, this is a win
     mutable QReadWriteLock m_rwLock;
 
-    uint64_t m_playerWins;
-    uint64_t m_aiWins;
-    uint64_t m_catWins;
+    //where the score lives between runs, and per AI strategy
+    std::unique_ptr<ScoreStore> m_scoreStore;
 };
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "GameScheduler.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    //callbacks per pool job.  They're meant to be tiny, so one job each would be mostly overhead.
+    const size_t CallbacksPerBatch = 64;
+
+    //they're only meant to post something somewhere else, a couple of threads keeps up with plenty
+    const int PoolThreads = 2;
+}
+
+GameScheduler::GameScheduler() : m_stop(false), m_inFlight(0), m_numFired(0), m_numBatches(0)
+{
+    m_pool.setMaxThreadCount(PoolThreads);
+    m_thread = std::thread(&GameScheduler::run, this);
+}
+
+GameScheduler::~GameScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    waitForCallbacks();
+}
+
+GameScheduler& GameScheduler::shared()
+{
+    static GameScheduler scheduler;
+    return scheduler;
+}
+
+TimingWheel::TimerId GameScheduler::schedule(std::chrono::steady_clock::duration delay, TimingWheel::Callback callback)
+{
+    return scheduleAt(std::chrono::steady_clock::now() + delay, std::move(callback));
+}
+
+TimingWheel::TimerId GameScheduler::scheduleAt(std::chrono::steady_clock::time_point when, TimingWheel::Callback callback)
+{
+    TimingWheel::TimerId id;
+    bool sooner;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sooner = when < m_wheel.getNextExpiry();
+        id = m_wheel.schedule(when, std::move(callback));
+    }
+
+    //only worth waking the thread if it's asleep until later than this
+    if (sooner)
+        m_wake.notify_one();
+    return id;
+}
+
+bool GameScheduler::cancel(TimingWheel::TimerId id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_wheel.cancel(id);
+}
+
+void GameScheduler::waitForCallbacks()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_callbacksDone.wait(lock, [this]() { return m_inFlight == 0; });
+}
+
+size_t GameScheduler::getNumTimers() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_wheel.size();
+}
+
+void GameScheduler::run()
+{
+    std::vector<TimingWheel::Callback> due;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        auto next = m_wheel.getNextExpiry();
+        if (next == std::chrono::steady_clock::time_point::max())
+            m_wake.wait(lock);
+        else
+            m_wake.wait_until(lock, next);
+
+        if (m_stop)
+            break;
+
+        m_wheel.advance(std::chrono::steady_clock::now(), due);
+        if (due.empty())
+            continue;
+
+        //counted before the lock goes, so a cancel that missed can wait for them
+        size_t numBatches = (due.size() + CallbacksPerBatch - 1) / CallbacksPerBatch;
+        m_inFlight += static_cast<int>(numBatches);
+        lock.unlock();
+
+        m_numFired += due.size();
+        m_numBatches += numBatches;
+        for (size_t first = 0; first < due.size(); first += CallbacksPerBatch)
+        {
+            size_t last = std::min(first + CallbacksPerBatch, due.size());
+            dispatch(std::vector<TimingWheel::Callback>(std::make_move_iterator(due.begin() + first), std::make_move_iterator(due.begin() + last)));
+        }
+        due.clear();
+
+        lock.lock();
+    }
+}
+
+void GameScheduler::dispatch(std::vector<TimingWheel::Callback> batch)
+{
+    QtConcurrent::run(&m_pool, [this, batch]() {
+        for (auto&& callback : batch)
+            callback();
+
+        //notified under the lock, once we let go of it the scheduler may be gone
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_inFlight;
+        m_callbacksDone.notify_all();
+    });
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "TimingWheel.h"
+
+#include <QThreadPool>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//one thread and one TimingWheel for every game's timers in the process: AI think delays, and
+//anything else a game has to wait on.  A game with nothing pending has no timer at all, and one
+//that does costs a wheel slot, not a QTimer and a registration with somebody's event loop.
+//the thread sleeps until the next expiry (or until something sooner is scheduled), takes
+//everything that's due in one go and hands it to a small pool of our own in batches, so the
+//callbacks never hold up the wheel.  Not the global pool: the AI searches run there, and timers
+//would queue up behind every one of them.  Callbacks should be quick; post anything big elsewhere.
+class GameScheduler
+{
+public:
+    GameScheduler();
+
+    //anything still scheduled is dropped
+    ~GameScheduler();
+
+    //the one the game managers share, started on first use
+    static GameScheduler& shared();
+
+    //safe from any thread
+    TimingWheel::TimerId schedule(std::chrono::steady_clock::duration delay, TimingWheel::Callback callback);
+    TimingWheel::TimerId scheduleAt(std::chrono::steady_clock::time_point when, TimingWheel::Callback callback);
+
+    //false if it's already been handed to the pool (it may still be running, see waitForCallbacks)
+    bool cancel(TimingWheel::TimerId id);
+
+    //blocks until every callback handed to the pool so far has finished.  For whoever's going away
+    //and lost a cancel race.
+    void waitForCallbacks();
+
+    size_t getNumTimers() const;
+    uint64_t getNumFired() const { return m_numFired; }
+    uint64_t getNumBatches() const { return m_numBatches; }
+
+protected:
+    void run();
+
+    //runs a batch on the pool, keeps m_inFlight honest
+    void dispatch(std::vector<TimingWheel::Callback> batch);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    TimingWheel m_wheel;
+    bool m_stop;
+
+    //just for the callbacks, nothing else runs here
+    QThreadPool m_pool;
+
+    //batches on the pool and not done yet, under m_mutex
+    int m_inFlight;
+    std::condition_variable m_callbacksDone;
+
+    std::atomic<uint64_t> m_numFired;
+    std::atomic<uint64_t> m_numBatches;
+
+    std::thread m_thread;
+};
@@ -0,0 +1,1001 @@
+#include "GameServer.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const size_t ReceiveBufferSize = 4096;
+    const int MaxEventsPerWait = 1024;
+
+    //sit in the poller's user data so we can tell the listener and the AI threads' wakeup apart from connections
+    char ListenerMarker;
+    char WakeupMarker;
+
+    //a node and a bucket in an unordered_map, roughly.  The standard library doesn't say.
+    const size_t MapEntryBytes = 48;
+
+    //set by SIGINT/SIGTERM, the command line server winds down when it sees it
+    volatile sig_atomic_t StopRequested = 0;
+
+    void requestStop(int)
+    {
+        StopRequested = 1;
+    }
+}
+
+struct GameServer::Connection
+{
+    Connection(NetSocket socket) : socket(socket), inUsed(0), direct(BroadcastBuffer::create()), pendingBytes(0), dirty(false), closing(false), wantWrite(false), resyncing(false)
+    {
+        gather.reserve(8);
+        games.reserve(4);
+    }
+
+    NetSocket socket;
+
+    uint8_t inBuffer[ReceiveBufferSize];
+    size_t inUsed;
+
+    //replies meant only for this connection (snapshots, rejections), sent ahead of the game batches
+    BroadcastBuffer::Ptr direct;
+
+    //this tick's game batches, straight out of ServerGame::batch
+    std::vector<BroadcastBuffer*> gather;
+
+    //whatever the socket wouldn't take yet, oldest first.  These hold references to the
+    //shared buffers rather than copies of them.
+    std::deque<BroadcastSlice> pending;
+    size_t pendingBytes;
+
+    std::vector<uint32_t> games;
+
+    bool dirty;
+    bool closing;
+    bool wantWrite;
+
+    //fell too far behind.  Gets no deltas until its socket drains, then a fresh snapshot of each game.
+    bool resyncing;
+};
+
+struct GameServer::ServerGame
+{
+    ServerGame(uint32_t id, AIStrategy::Type aiType) : id(id), ai(AIStrategy::create(aiType)), batch(BroadcastBuffer::create()), dirty(false), playerWins(0), aiWins(0), catWins(0), accountedBytes(0), parkTimer(0), aiJob(0)
+    {
+        seats[WireSeatSpectator] = nullptr;
+        seats[WireSeatPlayer] = nullptr;
+        seats[WireSeatOpponent] = nullptr;
+    }
+
+    uint32_t id;
+    BoardSnapshot board;
+    std::shared_ptr<AIStrategy> ai;
+
+    //who is playing each side, nobody in the opponent seat means the server AI plays it
+    Connection* seats[3];
+
+    std::vector<Connection*> subscribers;
+
+    //everything that happened this tick, encoded once for all subscribers
+    BroadcastBuffer::Ptr batch;
+    bool dirty;
+
+    uint32_t playerWins;
+    uint32_t aiWins;
+    uint32_t catWins;
+
+    //what we last added to liveGameBytes for this one
+    size_t accountedBytes;
+
+    //set while nobody's in it, goes off when it's time to park it
+    TimingWheel::TimerId parkTimer;
+
+    //the AI search that's out for this board, 0 if there isn't one
+    uint64_t aiJob;
+
+    //ourselves, our place in m_games, our AI, and whatever the batch and subscriber list have reserved
+    size_t getMemoryUsage() const
+    {
+        return sizeof(ServerGame) + MapEntryBytes + ai->getMemoryUsage() + sizeof(BroadcastBuffer) + batch->capacity() + (subscribers.capacity() * sizeof(Connection*));
+    }
+};
+
+GameServer::GameServer(const Options& options) : m_options(options),
+    m_listener(InvalidNetSocket),
+    m_port(0),
+    m_stop(false),
+    m_aiStop(false),
+    m_nextAIJob(0),
+    m_aiCancel(0),
+    m_remoteScoreId(0),
+    m_aiScoreId(0),
+    m_numConnections(0),
+    m_numGames(0),
+    m_numParkedGames(0),
+    m_gamesParked(0),
+    m_gamesRehydrated(0),
+    m_liveGameBytes(0),
+    m_parkedGameBytes(0),
+    m_movesApplied(0),
+    m_gamesFinished(0),
+    m_messagesIn(0),
+    m_bytesSent(0),
+    m_sendCalls(0),
+    m_flushes(0),
+    m_deliveries(0),
+    m_flushNanos(0),
+    m_snapshotFallbacks(0),
+    m_staleAIMoves(0)
+{
+    m_sendScratch.reserve(64);
+    m_sourceScratch.reserve(64);
+}
+
+GameServer::~GameServer()
+{
+    //they wake the poller, so they go first
+    {
+        std::lock_guard<std::mutex> lock(m_aiMutex);
+        m_aiStop = true;
+    }
+    m_aiCancel = 1;
+    m_aiWork.notify_all();
+    for (auto&& thread : m_aiThreads)
+        thread.join();
+
+    for (auto&& connection : m_connections)
+        NetPoller::closeSocket(connection.first);
+    if (m_listener != InvalidNetSocket)
+        NetPoller::closeSocket(m_listener);
+}
+
+bool GameServer::start()
+{
+    if (!m_options.scorePath.empty())
+    {
+        ScoreStore::Options scoreOptions;
+        scoreOptions.path = m_options.scorePath;
+        m_scores.reset(new ScoreStore(scoreOptions));
+        if (!m_scores->open())
+            return false;
+
+        m_remoteScoreId = m_scores->getPlayerId("Remote Players");
+        m_aiScoreId = m_scores->getPlayerId(std::string("Server AI: ") + AIStrategy::getTypeName(m_options.aiType));
+    }
+
+    m_listener = NetPoller::listenTcp(m_options.port, m_options.loopbackOnly);
+    if (m_listener == InvalidNetSocket)
+        return false;
+
+    m_port = NetPoller::getLocalPort(m_listener);
+    if (!m_poller.add(m_listener, &ListenerMarker) || !m_poller.addWakeup(&WakeupMarker))
+        return false;
+
+    //nothing to hand off for the lookup strategies
+    int aiThreads = m_options.aiThreads;
+    if (aiThreads <= 0)
+        aiThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    if (AIStrategy::isSearch(m_options.aiType))
+    {
+        for (int i = 0; i < aiThreads; ++i)
+            m_aiThreads.emplace_back(&GameServer::runAIJobs, this);
+    }
+    return true;
+}
+
+void GameServer::stop()
+{
+    m_stop = true;
+}
+
+GameServer::Stats GameServer::getStats() const
+{
+    Stats stats;
+    stats.connections = m_numConnections.load();
+    stats.games = m_numGames.load();
+    stats.parkedGames = m_numParkedGames.load();
+    stats.gamesParked = m_gamesParked.load();
+    stats.gamesRehydrated = m_gamesRehydrated.load();
+    stats.liveGameBytes = m_liveGameBytes.load();
+    stats.parkedGameBytes = m_parkedGameBytes.load();
+    stats.movesApplied = m_movesApplied.load();
+    stats.gamesFinished = m_gamesFinished.load();
+    stats.messagesIn = m_messagesIn.load();
+    stats.bytesSent = m_bytesSent.load();
+    stats.sendCalls = m_sendCalls.load();
+    stats.flushes = m_flushes.load();
+    stats.deliveries = m_deliveries.load();
+    stats.flushNanos = m_flushNanos.load();
+    stats.snapshotFallbacks = m_snapshotFallbacks.load();
+    stats.staleAIMoves = m_staleAIMoves.load();
+    return stats;
+}
+
+void GameServer::run()
+{
+    NetPoller::Event events[MaxEventsPerWait];
+    m_nextFlush = Clock::now();
+
+    while (!m_stop)
+    {
+        //sleep until there's traffic, or until the tick is up if we have something to send
+        int timeoutMs = 100;
+        if (!m_dirtyGames.empty() || !m_dirtyConnections.empty())
+        {
+            auto untilFlush = std::chrono::duration_cast<std::chrono::microseconds>(m_nextFlush - Clock::now()).count();
+            timeoutMs = untilFlush <= 0 ? 0 : static_cast<int>((untilFlush + 999) / 1000);
+        }
+
+        //or until the next timer
+        auto nextTimer = m_timers.getNextExpiry();
+        if (nextTimer != Clock::time_point::max())
+        {
+            auto untilTimer = std::chrono::duration_cast<std::chrono::microseconds>(nextTimer - Clock::now()).count();
+            timeoutMs = std::min(timeoutMs, untilTimer <= 0 ? 0 : static_cast<int>((untilTimer + 999) / 1000));
+        }
+
+        int numEvents = m_poller.wait(events, MaxEventsPerWait, timeoutMs);
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const NetPoller::Event& event = events[i];
+            if (event.userData == &ListenerMarker)
+            {
+                acceptConnections();
+                continue;
+            }
+            if (event.userData == &WakeupMarker)
+            {
+                m_poller.clearWakeup();
+                takeAIMoves();
+                continue;
+            }
+
+            Connection* connection = static_cast<Connection*>(event.userData);
+            if (connection->closing)
+                continue;
+
+            if (event.readable || event.closed)
+                readConnection(connection);
+            if (event.writable && !connection->closing)
+                sendPending(connection);
+        }
+
+        auto now = Clock::now();
+        m_timers.advance(now, m_dueTimers);
+        for (auto&& callback : m_dueTimers)
+            callback();
+        m_dueTimers.clear();
+
+        if (now >= m_nextFlush)
+        {
+            flush();
+            parkIdleGames();
+            m_nextFlush = now + std::chrono::microseconds(m_options.tickMicros);
+        }
+
+        reapClosedConnections();
+    }
+}
+
+void GameServer::acceptConnections()
+{
+    while (true)
+    {
+        NetSocket socket = NetPoller::acceptTcp(m_listener);
+        if (socket == InvalidNetSocket)
+            return;
+
+        std::unique_ptr<Connection> connection(new Connection(socket));
+        if (!m_poller.add(socket, connection.get()))
+        {
+            NetPoller::closeSocket(socket);
+            continue;
+        }
+
+        m_connections[socket] = std::move(connection);
+        ++m_numConnections;
+    }
+}
+
+void GameServer::readConnection(Connection* connection)
+{
+    while (!connection->closing)
+    {
+        int received = NetPoller::recvSome(connection->socket, connection->inBuffer + connection->inUsed, ReceiveBufferSize - connection->inUsed);
+        if (received < 0)
+        {
+            closeConnection(connection);
+            return;
+        }
+        if (received == 0)
+            return;
+
+        connection->inUsed += received;
+
+        //parse in place, whatever's left over is a partial message
+        size_t offset = 0;
+        WireMessage msg;
+        while (offset < connection->inUsed)
+        {
+            int used = readWireMessage(connection->inBuffer + offset, connection->inUsed - offset, msg);
+            if (used < 0)
+            {
+                closeConnection(connection);
+                return;
+            }
+            if (used == 0)
+                break;
+
+            offset += used;
+            ++m_messagesIn;
+            handleMessage(connection, msg);
+            if (connection->closing)
+                return;
+        }
+
+        if (offset)
+        {
+            memmove(connection->inBuffer, connection->inBuffer + offset, connection->inUsed - offset);
+            connection->inUsed -= offset;
+        }
+    }
+}
+
+void GameServer::handleMessage(Connection* connection, const WireMessage& msg)
+{
+    switch (msg.type)
+    {
+    case WireJoinGame:
+        joinGame(connection, msg.gameId, msg.seat);
+        break;
+    case WireLeaveGame:
+        leaveGame(connection, msg.gameId);
+        break;
+    case WireMakeMove:
+        makeMove(connection, msg.gameId, msg.cell);
+        break;
+    default:
+        //server -> client messages have no business coming our way
+        closeConnection(connection);
+        break;
+    }
+}
+
+GameServer::ServerGame& GameServer::getOrCreateGame(uint32_t gameId)
+{
+    auto found = m_games.find(gameId);
+    if (found != m_games.end())
+        return *found->second;
+
+    ServerGame* game = new ServerGame(gameId, m_options.aiType);
+    m_games[gameId].reset(game);
+    ++m_numGames;
+
+    //picks up where it was parked, everything else about it is new
+    DormantGame dormant;
+    if (m_dormantGames.take(gameId, dormant))
+    {
+        game->board = dormant.decodeBoard();
+        game->playerWins = dormant.playerWins;
+        game->aiWins = dormant.aiWins;
+        game->catWins = dormant.catWins;
+        --m_numParkedGames;
+        ++m_gamesRehydrated;
+        m_parkedGameBytes = m_dormantGames.getMemoryUsage();
+    }
+
+    accountGame(*game);
+    return *game;
+}
+
+size_t GameServer::getGameMemoryUsage(uint32_t gameId) const
+{
+    auto found = m_games.find(gameId);
+    if (found != m_games.end())
+        return found->second->getMemoryUsage();
+
+    //a slot's worth, less what the table holds in reserve
+    return m_dormantGames.find(gameId) ? sizeof(uint32_t) + sizeof(DormantGame) : 0;
+}
+
+void GameServer::accountGame(ServerGame& game)
+{
+    size_t bytes = game.getMemoryUsage();
+    m_liveGameBytes += bytes;
+    m_liveGameBytes -= game.accountedBytes;
+    game.accountedBytes = bytes;
+}
+
+void GameServer::parkIdleGames()
+{
+    for (auto&& gameId : m_idleGames)
+    {
+        //somebody may have come back, or it may already be parked from earlier in the list
+        auto found = m_games.find(gameId);
+        if (found == m_games.end() || !found->second->subscribers.empty())
+            continue;
+
+        ServerGame& game = *found->second;
+        m_dormantGames.insert(gameId, DormantGame::encode(game.board, game.playerWins, game.aiWins, game.catWins));
+        m_liveGameBytes -= game.accountedBytes;
+        m_games.erase(found);
+
+        --m_numGames;
+        ++m_numParkedGames;
+        ++m_gamesParked;
+    }
+    m_idleGames.clear();
+    m_parkedGameBytes = m_dormantGames.getMemoryUsage();
+}
+
+void GameServer::joinGame(Connection* connection, uint32_t gameId, uint8_t seat)
+{
+    ServerGame& game = getOrCreateGame(gameId);
+
+    //somebody came back before it was parked
+    if (game.parkTimer)
+    {
+        m_timers.cancel(game.parkTimer);
+        game.parkTimer = 0;
+    }
+
+    if (std::find(connection->games.begin(), connection->games.end(), gameId) == connection->games.end())
+    {
+        connection->games.push_back(gameId);
+        game.subscribers.push_back(connection);
+    }
+
+    //first come first served on the seats, everybody else watches
+    if ((seat == WireSeatPlayer || seat == WireSeatOpponent) && !game.seats[seat])
+        game.seats[seat] = connection;
+
+    //current board goes straight to the joiner, unless they're waiting on a resync which will cover it
+    if (!connection->resyncing)
+    {
+        writeGameState(connection, game);
+        markDirty(connection);
+    }
+
+    //they may have joined a game that's waiting on the AI
+    requestAIMove(game);
+    accountGame(game);
+}
+
+void GameServer::writeGameState(Connection* connection, const ServerGame& game)
+{
+    //deltas already in this tick's batch are older than the snapshot's generation and the client skips them
+    writeSnapshot(connection->direct->getBytes(), game.id, game.board);
+    writeScore(connection->direct->getBytes(), game.id, game.playerWins, game.aiWins, game.catWins);
+}
+
+void GameServer::leaveGame(Connection* connection, uint32_t gameId)
+{
+    auto found = m_games.find(gameId);
+    if (found == m_games.end())
+        return;
+
+    ServerGame& game = *found->second;
+    game.subscribers.erase(std::remove(game.subscribers.begin(), game.subscribers.end(), connection), game.subscribers.end());
+    for (auto&& seat : game.seats)
+        if (seat == connection)
+            seat = nullptr;
+
+    connection->games.erase(std::remove(connection->games.begin(), connection->games.end(), gameId), connection->games.end());
+
+    //if the opponent walked out, the AI takes over
+    requestAIMove(game);
+    accountGame(game);
+
+    //parked at the end of the tick once it's sat empty for a while, so its last batch has gone out by then
+    if (game.subscribers.empty() && m_options.parkIdleGames && !game.parkTimer)
+    {
+        game.parkTimer = m_timers.schedule(Clock::now() + std::chrono::milliseconds(m_options.parkAfterMs), [this, gameId]() {
+            auto found = m_games.find(gameId);
+            if (found == m_games.end())
+                return;
+            found->second->parkTimer = 0;
+            m_idleGames.push_back(gameId);
+        });
+    }
+}
+
+void GameServer::makeMove(Connection* connection, uint32_t gameId, uint8_t cell)
+{
+    auto found = m_games.find(gameId);
+    if (found == m_games.end())
+    {
+        writeMoveRejected(connection->direct->getBytes(), gameId, cell, WireRejectNotSeated);
+        markDirty(connection);
+        return;
+    }
+
+    ServerGame& game = *found->second;
+    uint8_t side = game.board.sideToMove();
+
+    uint8_t reason = 0;
+    if (game.seats[WireSeatPlayer] != connection && game.seats[WireSeatOpponent] != connection)
+        reason = WireRejectNotSeated;
+    else if (game.seats[side] != connection)
+        reason = WireRejectNotYourTurn;
+    else if (cell >= 9)
+        reason = WireRejectBadCell;
+    else if (game.board.cells[cell] != BoardSnapshot::Empty)
+        reason = WireRejectSquareTaken;
+
+    if (reason)
+    {
+        writeMoveRejected(connection->direct->getBytes(), gameId, cell, reason);
+        markDirty(connection);
+        return;
+    }
+
+    applyMove(game, cell, side);
+    requestAIMove(game);
+}
+
+void GameServer::applyMove(ServerGame& game, int cell, uint8_t side)
+{
+    BoardSnapshot& board = game.board;
+    board.cells[cell] = side;
+    board.usersTurn = side != BoardSnapshot::Player;
+    ++board.generation;
+    ++m_movesApplied;
+
+    writeMoveDelta(game.batch->getBytes(), game.id, static_cast<uint32_t>(board.generation), static_cast<uint8_t>(cell), side);
+
+    if (board.isGameOver())
+    {
+        uint8_t winner = board.winner();
+        if (winner == BoardSnapshot::Player)
+            ++game.playerWins;
+        else if (winner == BoardSnapshot::AI)
+            ++game.aiWins;
+        else
+            ++game.catWins;
+
+        //fresh board, player goes first, same as the desktop game
+        uint64_t generation = board.generation + 1;
+        board = BoardSnapshot();
+        board.generation = generation;
+
+        writeGameOver(game.batch->getBytes(), game.id, static_cast<uint32_t>(generation), winner);
+        writeScore(game.batch->getBytes(), game.id, game.playerWins, game.aiWins, game.catWins);
+        ++m_gamesFinished;
+
+        //memory only, the store's own thread does the writing
+        if (m_scores)
+        {
+            m_scores->recordResult(m_remoteScoreId, winner == BoardSnapshot::Player ? ScoreStore::Win : (winner == BoardSnapshot::AI ? ScoreStore::Loss : ScoreStore::Draw));
+            m_scores->recordResult(m_aiScoreId, winner == BoardSnapshot::AI ? ScoreStore::Win : (winner == BoardSnapshot::Player ? ScoreStore::Loss : ScoreStore::Draw));
+        }
+    }
+
+    markDirty(game);
+}
+
+bool GameServer::isAITurn(const ServerGame& game) const
+{
+    //only fills in for an empty opponent seat, and only when somebody is around to see it
+    return !game.board.usersTurn && !game.seats[WireSeatOpponent] && !game.subscribers.empty();
+}
+
+void GameServer::requestAIMove(ServerGame& game)
+{
+    if (game.aiJob || !isAITurn(game))
+        return;
+
+    if (m_aiThreads.empty())
+    {
+        int cell = game.ai->decideMove(game.board);
+        if (cell >= 0)
+            applyMove(game, cell, BoardSnapshot::AI);
+        return;
+    }
+
+    AIJob job;
+    job.gameId = game.id;
+    job.id = ++m_nextAIJob;
+    job.generation = game.board.generation;
+    job.board = game.board;
+    job.ai = game.ai;
+    job.cell = -1;
+    game.aiJob = job.id;
+
+    {
+        std::lock_guard<std::mutex> lock(m_aiMutex);
+        m_aiJobs.push_back(std::move(job));
+    }
+    m_aiWork.notify_one();
+}
+
+void GameServer::runAIJobs()
+{
+    AICancelToken cancel(&m_aiCancel, 0);
+    std::unique_lock<std::mutex> lock(m_aiMutex);
+    while (true)
+    {
+        m_aiWork.wait(lock, [this]() { return m_aiStop || !m_aiJobs.empty(); });
+        if (m_aiStop)
+            return;
+
+        AIJob job = std::move(m_aiJobs.front());
+        m_aiJobs.pop_front();
+        lock.unlock();
+
+        //the strategy's own deadline, it's only this thread that waits on it
+        job.cell = job.ai->decideMove(job.board, cancel);
+        job.ai.reset();
+
+        //one wakeup covers everything that piles up before the reactor gets to it
+        lock.lock();
+        bool wasEmpty = m_aiMoves.empty();
+        m_aiMoves.push_back(std::move(job));
+        if (wasEmpty)
+            m_poller.wake();
+    }
+}
+
+void GameServer::takeAIMoves()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_aiMutex);
+        m_aiMoveScratch.swap(m_aiMoves);
+    }
+
+    for (auto&& job : m_aiMoveScratch)
+    {
+        //parked since (and maybe back with a new AI), nothing to do with this search any more
+        auto found = m_games.find(job.gameId);
+        if (found == m_games.end() || found->second->aiJob != job.id)
+        {
+            ++m_staleAIMoves;
+            continue;
+        }
+
+        ServerGame& game = *found->second;
+        game.aiJob = 0;
+
+        //somebody took the seat and moved, or everybody left, while it was thinking
+        if (job.cell >= 0 && game.board.generation == job.generation && isAITurn(game))
+            applyMove(game, job.cell, BoardSnapshot::AI);
+        else
+            ++m_staleAIMoves;
+
+        //the board may still want a move, just not that one
+        requestAIMove(game);
+        accountGame(game);
+    }
+    m_aiMoveScratch.clear();
+}
+
+void GameServer::markDirty(Connection* connection)
+{
+    if (connection->dirty)
+        return;
+    connection->dirty = true;
+    m_dirtyConnections.push_back(connection);
+}
+
+void GameServer::markDirty(ServerGame& game)
+{
+    if (game.dirty)
+        return;
+    game.dirty = true;
+    m_dirtyGames.push_back(&game);
+}
+
+void GameServer::flush()
+{
+    if (m_dirtyGames.empty() && m_dirtyConnections.empty())
+        return;
+
+    ++m_flushes;
+    auto start = Clock::now();
+
+    //point every subscriber at the game's batch, no copies
+    uint64_t deliveries = 0;
+    for (auto&& game : m_dirtyGames)
+    {
+        BroadcastBuffer* batch = game->batch.get();
+        for (auto&& subscriber : game->subscribers)
+        {
+            //they'll get a snapshot instead once they've caught up
+            if (subscriber->resyncing)
+                continue;
+
+            subscriber->gather.push_back(batch);
+            markDirty(subscriber);
+            ++deliveries;
+        }
+    }
+    m_deliveries += deliveries;
+
+    for (auto&& connection : m_dirtyConnections)
+    {
+        if (!connection->closing)
+            writeConnection(connection);
+        BroadcastBuffer::recycle(connection->direct);
+        connection->gather.clear();
+        connection->dirty = false;
+    }
+    m_dirtyConnections.clear();
+
+    //a batch that somebody couldn't finish sending stays with them, the game starts a new one
+    for (auto&& game : m_dirtyGames)
+    {
+        BroadcastBuffer::recycle(game->batch);
+        game->dirty = false;
+        accountGame(*game);
+    }
+    m_dirtyGames.clear();
+
+    m_flushNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+void GameServer::writeConnection(Connection* connection)
+{
+    m_sourceScratch.clear();
+    if (!connection->direct->empty())
+        m_sourceScratch.push_back(connection->direct.get());
+    m_sourceScratch.insert(m_sourceScratch.end(), connection->gather.begin(), connection->gather.end());
+
+    if (m_sourceScratch.empty())
+        return;
+
+    size_t sent = 0;
+
+    //if we're already backed up, this has to queue behind what's waiting to keep the order
+    if (connection->pending.empty())
+    {
+        m_sendScratch.clear();
+        for (auto&& source : m_sourceScratch)
+        {
+            NetBuffer buffer;
+            buffer.data = source->data();
+            buffer.size = source->size();
+            m_sendScratch.push_back(buffer);
+        }
+
+        int64_t result = NetPoller::sendGather(connection->socket, m_sendScratch.data(), m_sendScratch.size());
+        ++m_sendCalls;
+        if (result < 0)
+        {
+            closeConnection(connection);
+            return;
+        }
+        sent = static_cast<size_t>(result);
+        m_bytesSent += sent;
+    }
+
+    //hang on to whatever didn't make it.  The buffers are shared, so this just keeps them alive.
+    for (auto&& source : m_sourceScratch)
+    {
+        if (sent >= source->size())
+        {
+            sent -= source->size();
+            continue;
+        }
+        connection->pending.emplace_back(source->shared_from_this(), sent);
+        connection->pendingBytes += source->size() - sent;
+        sent = 0;
+    }
+
+    if (connection->pendingBytes > m_options.maxPendingBytes)
+        fallBehind(connection);
+
+    //resyncing connections wait for writable even with nothing queued, that's when their snapshot goes out
+    bool wantWrite = !connection->pending.empty() || connection->resyncing;
+    if (wantWrite && !connection->wantWrite)
+    {
+        connection->wantWrite = true;
+        m_poller.setWantWrite(connection->socket, connection, true);
+    }
+}
+
+void GameServer::fallBehind(Connection* connection)
+{
+    //the front one may be half sent, cutting it off would leave the client in the middle of a message
+    size_t keep = !connection->pending.empty() && connection->pending.front().offset ? 1 : 0;
+    while (connection->pending.size() > keep)
+    {
+        connection->pendingBytes -= connection->pending.back().size();
+        connection->pending.pop_back();
+    }
+
+    if (!connection->resyncing)
+    {
+        connection->resyncing = true;
+        ++m_snapshotFallbacks;
+    }
+}
+
+void GameServer::sendPending(Connection* connection)
+{
+    if (!connection->pending.empty())
+    {
+        m_sendScratch.clear();
+        for (auto&& slice : connection->pending)
+        {
+            NetBuffer buffer;
+            buffer.data = slice.data();
+            buffer.size = slice.size();
+            m_sendScratch.push_back(buffer);
+        }
+
+        int64_t result = NetPoller::sendGather(connection->socket, m_sendScratch.data(), m_sendScratch.size());
+        ++m_sendCalls;
+        if (result < 0)
+        {
+            closeConnection(connection);
+            return;
+        }
+        m_bytesSent += result;
+
+        size_t sent = static_cast<size_t>(result);
+        connection->pendingBytes -= sent;
+        while (sent)
+        {
+            BroadcastSlice& front = connection->pending.front();
+            if (sent < front.size())
+            {
+                front.offset += sent;
+                break;
+            }
+            sent -= front.size();
+            connection->pending.pop_front();
+        }
+    }
+
+    if (!connection->pending.empty())
+        return;
+
+    //caught up, now they can have the current state of everything they're watching
+    if (connection->resyncing)
+    {
+        connection->resyncing = false;
+        for (auto&& gameId : connection->games)
+        {
+            auto found = m_games.find(gameId);
+            if (found != m_games.end())
+                writeGameState(connection, *found->second);
+        }
+        markDirty(connection);
+    }
+
+    if (connection->wantWrite)
+    {
+        connection->wantWrite = false;
+        m_poller.setWantWrite(connection->socket, connection, false);
+    }
+}
+
+void GameServer::closeConnection(Connection* connection)
+{
+    //the actual teardown waits until the end of the loop, there may be pointers to it in the dirty lists
+    if (connection->closing)
+        return;
+    connection->closing = true;
+    m_closedConnections.push_back(connection);
+}
+
+void GameServer::reapClosedConnections()
+{
+    for (auto&& connection : m_closedConnections)
+    {
+        //leaving can make the AI move, which can dirty the game again, that's fine
+        std::vector<uint32_t> games = connection->games;
+        for (auto&& gameId : games)
+            leaveGame(connection, gameId);
+
+        m_dirtyConnections.erase(std::remove(m_dirtyConnections.begin(), m_dirtyConnections.end(), connection), m_dirtyConnections.end());
+
+        m_poller.remove(connection->socket);
+        NetPoller::closeSocket(connection->socket);
+        m_connections.erase(connection->socket);
+        --m_numConnections;
+    }
+    m_closedConnections.clear();
+}
+
+int GameServer::runFromCommandLine(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--port" && hasValue)
+            options.port = static_cast<uint16_t>(atoi(argv[++i]));
+        else if (arg == "--tick-us" && hasValue)
+            options.tickMicros = atoi(argv[++i]);
+        else if (arg == "--ai" && hasValue)
+            AIStrategy::parseType(argv[++i], options.aiType);
+        else if (arg == "--ai-threads" && hasValue)
+            options.aiThreads = atoi(argv[++i]);
+        else if (arg == "--loopback")
+            options.loopbackOnly = true;
+        else if (arg == "--scores" && hasValue)
+            options.scorePath = argv[++i];
+        else if (arg == "--no-park")
+            options.parkIdleGames = false;
+        else if (arg == "--park-after-ms" && hasValue)
+            options.parkAfterMs = atoi(argv[++i]);
+    }
+
+    if (!NetPoller::startup())
+        return 1;
+
+    NetPoller::raiseFileLimit(1 << 20);
+
+    GameServer server(options);
+    if (!server.start())
+    {
+        fprintf(stderr, "couldn't listen on port %d\n", options.port);
+        return 1;
+    }
+
+    printf("serving on port %d, AI: %s\n", server.getPort(), AIStrategy::getTypeName(options.aiType));
+    if (const ScoreStore* scores = server.getScoreStore())
+    {
+        ScoreStore::Stats scoreStats = scores->getStats();
+        printf("scores from %s: replayed %llu log frames in %.1f ms%s\n",
+            options.scorePath.c_str(),
+            (unsigned long long)scoreStats.framesReplayed,
+            scoreStats.recoveryNanos / 1000000.0,
+            scoreStats.tornTail ? ", dropped a torn write at the end" : "");
+    }
+    fflush(stdout);
+
+    std::thread reactor([&server]() {
+        server.run();
+    });
+
+    //ctrl-c or a kill, either way the sockets get closed and the score store flushed on the way out
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+
+    //a line of stats every few seconds until we're told to stop
+    const int intervalSeconds = 5;
+    const int checksPerInterval = 50;
+    Stats last = server.getStats();
+    while (!StopRequested)
+    {
+        for (int check = 0; check < checksPerInterval && !StopRequested; ++check)
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalSeconds * 1000 / checksPerInterval));
+        if (StopRequested)
+            break;
+
+        Stats stats = server.getStats();
+        uint64_t flushes = stats.flushes - last.flushes;
+        PositionCache::Stats cacheStats = AIStrategy::getPositionCache().getStats();
+        printf("connections %llu games %llu (%.0f B each) parked %llu (%.0f B each) | moves/s %.0f | sends/flush %.1f | bytes/s %.0f | snapshot fallbacks %llu | position cache %.1f%% hits, %.0f ns\n",
+            (unsigned long long)stats.connections,
+            (unsigned long long)stats.games,
+            stats.games ? double(stats.liveGameBytes) / stats.games : 0.0,
+            (unsigned long long)stats.parkedGames,
+            stats.parkedGames ? double(stats.parkedGameBytes) / stats.parkedGames : 0.0,
+            double(stats.movesApplied - last.movesApplied) / intervalSeconds,
+            flushes ? double(stats.sendCalls - last.sendCalls) / flushes : 0.0,
+            double(stats.bytesSent - last.bytesSent) / intervalSeconds,
+            (unsigned long long)stats.snapshotFallbacks,
+            cacheStats.getHitRate() * 100.0,
+            cacheStats.getMeanLookupNanos());
+        fflush(stdout);
+        last = stats;
+    }
+
+    printf("shutting down\n");
+    fflush(stdout);
+
+    server.stop();
+    reactor.join();
+    return 0;
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "AIStrategy.h"
+#include "BoardSnapshot.h"
+#include "BroadcastBuffer.h"
+#include "DormantGame.h"
+#include "TimingWheel.h"
+#include "NetPoller.h"
+#include "ScoreStore.h"
+#include "WireProtocol.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//headless game host speaking WireProtocol over TCP.
+//one reactor thread owns every game and connection, so there's no locking in here apart from
+//handing the server AI's searches to its own threads and taking the moves back.  A search is
+//tens of ms (see AIStrategy::isSearch), and on the reactor that's every game and connection waiting.
+//the strategies that just look the move up still answer right there, it's quicker than the handoff.
+//moves are applied as they arrive, but everything going out is held until the end of the
+//tick: each game encodes its deltas once into its own batch buffer, and each connection gets
+//a single gathered send pointing at the batches it's subscribed to.  Nothing is copied per
+//subscriber, even when a socket backs up: it keeps a reference to the part of the batch it
+//still owes, and the game moves on to a new buffer.
+//spectators are just subscribers without a seat, so one game can be watched by thousands.
+//a game everybody has left is parked once it's been idle a little while: it goes down to a DormantGame
+//and comes back the next time somebody joins it, so the games nobody is playing cost next to nothing.
+//those waits are on a TimingWheel the reactor advances every wakeup, not a timer per game.
+class GameServer
+{
+public:
+    struct Options
+    {
+        Options() : port(7777), loopbackOnly(false), tickMicros(1000), aiType(AIStrategy::FirstFree), aiThreads(0), maxPendingBytes(256 * 1024), parkIdleGames(true), parkAfterMs(2000) {}
+
+        uint16_t port;          //0 picks a free one, see getPort()
+        bool loopbackOnly;
+        int tickMicros;         //how long outgoing deltas are held to batch them, 0 flushes every wakeup
+        AIStrategy::Type aiType;
+        int aiThreads;          //for a searching AI, 0 is one per core less the reactor's
+
+        //a connection that can't keep up past this many unsent bytes stops getting deltas.
+        //once it drains it gets snapshots of its games and picks up from there.
+        size_t maxPendingBytes;
+
+        //games with nobody subscribed go dormant, see DormantGame.  Off keeps every game live for good.
+        bool parkIdleGames;
+
+        //how long a game has to sit with nobody in it first, so a quick reconnect doesn't park it
+        //and bring it straight back.  0 parks at the end of the tick.
+        int parkAfterMs;
+
+        //every finished game goes in a ScoreStore here (path.log and path.snapshot).  Empty keeps nothing.
+        std::string scorePath;
+    };
+
+    //counters are atomics so another thread can watch while we run
+    struct Stats
+    {
+        uint64_t connections;
+        uint64_t games;             //live ones
+        uint64_t parkedGames;
+        uint64_t gamesParked;       //how many times, a game can go back and forth
+        uint64_t gamesRehydrated;
+        uint64_t liveGameBytes;     //everything the live games hold, their AIs and buffers included
+        uint64_t parkedGameBytes;   //the whole dormant table
+        uint64_t movesApplied;
+        uint64_t gamesFinished;
+        uint64_t messagesIn;
+        uint64_t bytesSent;
+        uint64_t sendCalls;
+        uint64_t flushes;
+        uint64_t deliveries;        //batches handed to subscribers, i.e. fan-out
+        uint64_t flushNanos;        //time spent fanning out and sending
+        uint64_t snapshotFallbacks; //slow consumers switched to snapshots
+        uint64_t staleAIMoves;      //searches whose board had moved on (or gone) by the time they finished
+    };
+
+    GameServer(const Options& options = Options());
+    ~GameServer();
+
+    //binds the listener, false if we couldn't
+    bool start();
+
+    //runs the reactor on the calling thread until stop()
+    void run();
+
+    //safe from any thread
+    void stop();
+
+    uint16_t getPort() const { return m_port; }
+
+    Stats getStats() const;
+
+    //what one game costs right now, live or parked, 0 if we've never heard of it.  Reactor thread
+    //only; getStats has the totals for everybody else.
+    size_t getGameMemoryUsage(uint32_t gameId) const;
+
+    //nullptr unless Options::scorePath was set
+    const ScoreStore* getScoreStore() const { return m_scores.get(); }
+
+    //--server [--port N] [--ai name] [--ai-threads N] [--tick-us N] [--loopback] [--scores path] [--no-park] [--park-after-ms N]
+    //runs until SIGINT or SIGTERM
+    static int runFromCommandLine(int argc, char* argv[]);
+
+protected:
+    struct Connection;
+    struct ServerGame;
+
+    //a search for one game, stamped so a move for a board that's since changed gets dropped
+    struct AIJob
+    {
+        uint32_t gameId;
+        uint64_t id;
+        uint64_t generation;
+        BoardSnapshot board;
+        std::shared_ptr<AIStrategy> ai;     //the game can be parked while this is out
+        int cell;
+    };
+
+    void acceptConnections();
+    void readConnection(Connection* connection);
+    void handleMessage(Connection* connection, const WireMessage& msg);
+
+    void joinGame(Connection* connection, uint32_t gameId, uint8_t seat);
+    void writeGameState(Connection* connection, const ServerGame& game);
+    void leaveGame(Connection* connection, uint32_t gameId);
+    void makeMove(Connection* connection, uint32_t gameId, uint8_t cell);
+
+    ServerGame& getOrCreateGame(uint32_t gameId);
+    void applyMove(ServerGame& game, int cell, uint8_t side);
+
+    //the opponent seat is empty and somebody is around to see it
+    bool isAITurn(const ServerGame& game) const;
+
+    //plays it now for a lookup strategy, otherwise hands the board to the AI threads unless
+    //there's already a search out for this game
+    void requestAIMove(ServerGame& game);
+
+    //AI threads
+    void runAIJobs();
+
+    //reactor, after a wakeup: plays whatever came back that still fits its board
+    void takeAIMoves();
+
+    void markDirty(Connection* connection);
+    void markDirty(ServerGame& game);
+
+    //brings liveGameBytes up to date with whatever the game holds now
+    void accountGame(ServerGame& game);
+
+    //end of tick, after the flush: games that lost their last subscriber go dormant
+    void parkIdleGames();
+
+    //end of tick, push every game's batch to its subscribers
+    void flush();
+    void writeConnection(Connection* connection);
+    void fallBehind(Connection* connection);
+    void sendPending(Connection* connection);
+
+    void closeConnection(Connection* connection);
+    void reapClosedConnections();
+
+    Options m_options;
+
+    NetSocket m_listener;
+    uint16_t m_port;
+    NetPoller m_poller;
+
+    std::atomic<bool> m_stop;
+
+    std::unordered_map<uint32_t, std::unique_ptr<ServerGame>> m_games;
+    DormantGameTable m_dormantGames;
+
+    //games whose park timer has gone off this tick.  They may have a new subscriber by the time we park.
+    std::vector<uint32_t> m_idleGames;
+
+    //every per game wait, advanced on each wakeup.  The callbacks run right there on the reactor.
+    TimingWheel m_timers;
+    std::vector<TimingWheel::Callback> m_dueTimers;
+    std::unordered_map<NetSocket, std::unique_ptr<Connection>> m_connections;
+
+    std::vector<ServerGame*> m_dirtyGames;
+    std::vector<Connection*> m_dirtyConnections;
+    std::vector<Connection*> m_closedConnections;
+
+    //searches waiting for a thread, and moves waiting for the reactor, both under m_aiMutex
+    std::vector<std::thread> m_aiThreads;
+    std::mutex m_aiMutex;
+    std::condition_variable m_aiWork;
+    std::deque<AIJob> m_aiJobs;
+    std::vector<AIJob> m_aiMoves;
+    bool m_aiStop;
+
+    //swapped with m_aiMoves, so the reactor doesn't hold the lock while it plays them
+    std::vector<AIJob> m_aiMoveScratch;
+    uint64_t m_nextAIJob;
+
+    //goes to 1 on the way out, which calls off whatever is still searching
+    std::atomic<uint64_t> m_aiCancel;
+
+    //results go in under one line for everybody connected and one for our AI
+    std::unique_ptr<ScoreStore> m_scores;
+    uint32_t m_remoteScoreId;
+    uint32_t m_aiScoreId;
+
+    //reused for every gathered send
+    std::vector<NetBuffer> m_sendScratch;
+    std::vector<BroadcastBuffer*> m_sourceScratch;
+
+    std::chrono::steady_clock::time_point m_nextFlush;
+
+    std::atomic<uint64_t> m_numConnections;
+    std::atomic<uint64_t> m_numGames;
+    std::atomic<uint64_t> m_numParkedGames;
+    std::atomic<uint64_t> m_gamesParked;
+    std::atomic<uint64_t> m_gamesRehydrated;
+    std::atomic<uint64_t> m_liveGameBytes;
+    std::atomic<uint64_t> m_parkedGameBytes;
+    std::atomic<uint64_t> m_movesApplied;
+    std::atomic<uint64_t> m_gamesFinished;
+    std::atomic<uint64_t> m_messagesIn;
+    std::atomic<uint64_t> m_bytesSent;
+    std::atomic<uint64_t> m_sendCalls;
+    std::atomic<uint64_t> m_flushes;
+    std::atomic<uint64_t> m_deliveries;
+    std::atomic<uint64_t> m_flushNanos;
+    std::atomic<uint64_t> m_snapshotFallbacks;
+    std::atomic<uint64_t> m_staleAIMoves;
+};
@@ -0,0 +1,178 @@
+#include "GameSimulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    //a game that hasn't ended after this many steps never will, the rules are broken
+    const int MaxStepsPerGame = 64;
+
+    uint64_t gameSeed(uint64_t seed, int game)
+    {
+        uint64_t state = seed ^ (uint64_t(game) * 0xd1b54a32d192ed03ull);
+        return GameEngine::nextRandom(state);
+    }
+}
+
+GameSimulation::GameSimulation(const Options& options) : m_options(options)
+{
+}
+
+GameSimulation::Results GameSimulation::playGame(uint64_t seed, AIStrategy& user, AIStrategy& ai)
+{
+    Results results;
+    results.traceHash = GameEngine::TraceHashStart;
+
+    GameState state = GameEngine::createState(seed);
+
+    //the user draws from a stream of its own, so its picks don't shift the AI's
+    uint64_t userRng = seed ^ 0x5bd1e995ull;
+
+    for (int i = 0; i < MaxStepsPerGame; ++i)
+    {
+        //the user answers straight away, the AI waits for its tick like it does on screen
+        GameInput input = GameInput::tick();
+        if (state.usersTurn)
+        {
+            int cell = user.decideMove(state.getSnapshot(), static_cast<uint32_t>(GameEngine::nextRandom(userRng)));
+            input = GameInput::userMove(cell);
+            ++results.userMoves;
+        }
+        else
+        {
+            ++results.ticks;
+        }
+
+        GameStep step = GameEngine::step(state, input);
+        state = step.state;
+
+        bool over = false;
+        bool aiDue = false;
+        for (auto&& event : step)
+        {
+            results.traceHash = GameEngine::hashEvent(results.traceHash, event);
+            ++results.events;
+            over = over || event.type == GameEvent::GameOver;
+            aiDue = aiDue || event.type == GameEvent::AIMoveDue;
+        }
+
+        if (over)
+            break;
+        if (!aiDue)
+            continue;
+
+        auto start = Clock::now();
+        int cell = ai.decideMove(state.getSnapshot(), GameEngine::getAISeed(state));
+        m_decisionLatency.record(Clock::now() - start);
+
+        step = GameEngine::step(state, GameInput::aiMove(cell, state.generation));
+        state = step.state;
+        for (auto&& event : step)
+        {
+            results.traceHash = GameEngine::hashEvent(results.traceHash, event);
+            ++results.events;
+        }
+        ++results.aiMoves;
+    }
+
+    results.playerWins = state.playerWins;
+    results.aiWins = state.aiWins;
+    results.catWins = state.catWins;
+    return results;
+}
+
+GameSimulation::Results GameSimulation::run()
+{
+    int numThreads = std::max(1, m_options.threads);
+    std::vector<Results> games(std::max(0, m_options.games));
+    m_decisionLatency.reset();
+
+    //game i always gets the same seed, whoever plays it.  Strategies aren't shared between
+    //threads, but nothing in them that matters to the outcome depends on which one you get.
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([this, t, numThreads, &games]() {
+            std::shared_ptr<AIStrategy> user = AIStrategy::create(m_options.userType);
+            std::shared_ptr<AIStrategy> ai = AIStrategy::create(m_options.aiType);
+            for (int game = t; game < static_cast<int>(games.size()); game += numThreads)
+                games[game] = playGame(gameSeed(m_options.seed, game), *user, *ai);
+        });
+    }
+    for (auto&& thread : threads)
+        thread.join();
+
+    Results results;
+    results.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    results.traceHash = GameEngine::TraceHashStart;
+
+    //in game order, so who finished first doesn't matter
+    for (auto&& game : games)
+    {
+        for (int shift = 0; shift < 64; shift += 8)
+            results.traceHash = (results.traceHash ^ ((game.traceHash >> shift) & 0xff)) * 1099511628211ull;
+        results.events += game.events;
+        results.ticks += game.ticks;
+        results.userMoves += game.userMoves;
+        results.aiMoves += game.aiMoves;
+        results.playerWins += game.playerWins;
+        results.aiWins += game.aiWins;
+        results.catWins += game.catWins;
+    }
+    return results;
+}
+
+int GameSimulation::runFromCommandLine(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--seed" && hasValue)
+            options.seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--games" && hasValue)
+            options.games = atoi(argv[++i]);
+        else if (arg == "--threads" && hasValue)
+            options.threads = atoi(argv[++i]);
+        else if (arg == "--ai" && hasValue)
+            AIStrategy::parseType(argv[++i], options.aiType);
+        else if (arg == "--user" && hasValue)
+            AIStrategy::parseType(argv[++i], options.userType);
+    }
+
+    //table builds would land in whichever game got there first
+    AIStrategy::prepareTables();
+
+    GameSimulation simulation(options);
+    Results results = simulation.run();
+
+    printf("seed %llu | %d games | %s vs %s | %d threads | %.2fs\n",
+        (unsigned long long)options.seed,
+        options.games,
+        AIStrategy::getTypeName(options.userType),
+        AIStrategy::getTypeName(options.aiType),
+        std::max(1, options.threads),
+        results.seconds);
+    printf("trace %016llx | %llu events | %llu ticks | %llu user moves | %llu AI moves | player %llu AI %llu cat %llu\n",
+        (unsigned long long)results.traceHash,
+        (unsigned long long)results.events,
+        (unsigned long long)results.ticks,
+        (unsigned long long)results.userMoves,
+        (unsigned long long)results.aiMoves,
+        (unsigned long long)results.playerWins,
+        (unsigned long long)results.aiWins,
+        (unsigned long long)results.catWins);
+    printf("AI decisions: %.0f/s | %s\n",
+        results.aiMoves / results.seconds,
+        simulation.getDecisionLatency().toString().c_str());
+    return 0;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "AIStrategy.h"
+#include "GameEngine.h"
+#include "LatencyHistogram.h"
+
+#include <cinttypes>
+#include <vector>
+
+//plays games on GameEngine as fast as it'll go, no Qt, no timers, no sockets.
+//every game gets its own seed off the run's seed, the user is a strategy too (random by default),
+//and both sides' seeds come out of the engine's generator, so a run is fixed by its seed: the
+//trace hash and every count below come out the same every time, however many threads play.
+//only the timings move.
+class GameSimulation
+{
+public:
+    struct Options
+    {
+        Options() : seed(1), games(10000), threads(1), aiType(AIStrategy::Minimax), userType(AIStrategy::Random) {}
+
+        uint64_t seed;
+        int games;
+        int threads;
+        AIStrategy::Type aiType;
+        AIStrategy::Type userType;
+    };
+
+    //what one run came to.  Everything but the timings is fixed by the seed.
+    struct Results
+    {
+        Results() : traceHash(0), events(0), ticks(0), userMoves(0), aiMoves(0), playerWins(0), aiWins(0), catWins(0), seconds(0.0) {}
+
+        uint64_t traceHash;     //every game's trace, folded in game order
+        uint64_t events;
+        uint64_t ticks;
+        uint64_t userMoves;
+        uint64_t aiMoves;
+        uint64_t playerWins;
+        uint64_t aiWins;
+        uint64_t catWins;
+        double seconds;
+    };
+
+    GameSimulation(const Options& options = Options());
+
+    Results run();
+
+    //time the AI took over each decision, all threads
+    const LatencyHistogram& getDecisionLatency() const { return m_decisionLatency; }
+
+    //--sim [--seed N] [--games N] [--threads N] [--ai name] [--user name]
+    static int runFromCommandLine(int argc, char* argv[]);
+
+protected:
+    //one game from an empty board to its GameOver, on whatever thread
+    Results playGame(uint64_t seed, AIStrategy& user, AIStrategy& ai);
+
+    Options m_options;
+    LatencyHistogram m_decisionLatency;
+};
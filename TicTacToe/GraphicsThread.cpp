@@ -1,10 +1,16 @@
 #include "GraphicsThread.h"
+#include "BoardMonitor.h"
+#include "BoardTileGrid.h"
 #include "ClickEventHandler.h"
+#include "QubicBoardView.h"
+#include "StartupTrace.h"
 #include "TApp.h"
+#include "UltimateBoardView.h"
 #include <OSGViewerWidget.h>
 
 #include <osgViewer/CompositeViewer>
 #include <osgViewer/GraphicsWindow>
+#include <osgViewer/Viewer>
 
 #include <osgQt/GraphicsWindowQt>
 #include <osgQt/QFontImplementation>
@@ -13,6 +19,13 @@
 #include <osg/PositionAttitudeTransform>
 #include <osg/LineSegment>
 #include <osg/Texture2D>
+#include <osg/Camera>
+#include <osg/FrameStamp>
+#include <osg/RenderInfo>
+#include <osg/State>
+#include <osg/Image>
+#include <osg/GraphicsContext>
+#include <osg/Viewport>
 
 #include <osgText/Text>
 
@@ -20,20 +33,88 @@
 
 #include <QApplication>
 #include <QDir>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
 #include <QDebug>
 
+namespace
+{
+    //long enough for the new threads to get going before we start counting
+    const std::chrono::seconds BenchmarkWarmup(1);
+
+    int64_t nowNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //runs once the camera has drawn, on whichever thread drew it
+    class FrameDrawnCallback : public osg::Camera::DrawCallback
+    {
+    public:
+        FrameDrawnCallback(const std::atomic<int64_t>* frameStarts, int numFrameStarts, LatencyHistogram* latency) : m_frameStarts(frameStarts),
+            m_numFrameStarts(numFrameStarts),
+            m_latency(latency)
+        {
+        }
+
+        virtual void operator()(osg::RenderInfo& renderInfo) const override
+        {
+            const osg::FrameStamp* frameStamp = renderInfo.getState()->getFrameStamp();
+            if (!frameStamp)
+                return;
+
+            int64_t started = m_frameStarts[frameStamp->getFrameNumber() % m_numFrameStarts].load(std::memory_order_acquire);
+            if (started)
+                m_latency->record(std::chrono::nanoseconds(nowNanos() - started));
+        }
+
+    protected:
+        const std::atomic<int64_t>* m_frameStarts;
+        int m_numFrameStarts;
+        LatencyHistogram* m_latency;
+    };
+
+    osg::StateSet* createPieceState(osg::Image* image)
+    {
+        osg::Texture2D* texture = new osg::Texture2D;
+        texture->setImage(image);
+
+        osg::StateSet* stateset = new osg::StateSet;
+        stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+        stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+        stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+        return stateset;
+    }
+}
 
 GraphicsThread::GraphicsThread(QObject *parent) : QThread(parent),
     m_done(false),
     m_osgViewer(nullptr),
     m_threadsWaiting(false),
+    m_ultimateLayout(9, 20.0, 4.0, 4.0),
+    m_variant(GameMoveManager::Classic),
+    m_variantGeneration(0),
+    m_variantDrawn(false),
+    m_linesWidth(-1.0),
+    m_linesHeight(-1.0),
+    m_piecesWidth(-1.0),
+    m_piecesHeight(-1.0),
+    m_statsFontApplied(false),
+    m_firstFrameDrawn(false),
     m_playerWins(0),
     m_aiWins(0),
     m_catWins(0)
 {
-    connect(tApp->getGameManager(), &GameMoveManager::moveStored, this, &GraphicsThread::handleMoveStored);
-    connect(tApp->getGameManager(), &GameMoveManager::boardCleared, this, &GraphicsThread::handleBoardCleared);
+    for (auto&& frameStart : m_frameStarts)
+        frameStart = 0;
+
+    tApp->getGameManager()->getScore(m_playerWins, m_aiWins, m_catWins);
     connect(tApp->getGameManager(), &GameMoveManager::scoreUpdated, this, &GraphicsThread::handleScoreUpdated);
+
+    prepareResources();
 }
 
 GraphicsThread::~GraphicsThread()
@@ -68,6 +149,9 @@ void GraphicsThread::addTaskBlocking(std::function<void()> task)
 
 osg::Camera* GraphicsThread::getCamera() const
 {
+    if (m_offscreenViewer.valid())
+        return m_offscreenViewer->getCamera();
+
     if (!m_osgViewer)
         return nullptr;
 
@@ -84,6 +168,60 @@ osg::Camera* GraphicsThread::getCamera() const
 }
 
 
+bool GraphicsThread::startOffscreen()
+{
+    osg::Camera* window = getCamera();
+    if (!window || !window->getViewport() || !m_rootGroup.valid())
+        return false;
+
+    //the window's size, so the layout comes out the same as what the player sees
+    osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits;
+    traits->width = static_cast<int>(window->getViewport()->width());
+    traits->height = static_cast<int>(window->getViewport()->height());
+    traits->windowDecoration = false;
+    traits->doubleBuffer = false;
+    traits->pbuffer = true;
+    if (const osg::GraphicsContext* context = window->getGraphicsContext())
+    {
+        traits->alpha = context->getTraits()->alpha;
+        traits->stencil = context->getTraits()->stencil;
+    }
+
+    osg::ref_ptr<osg::GraphicsContext> pbuffer = osg::GraphicsContext::createGraphicsContext(traits.get());
+    if (!pbuffer.valid())
+        return false;
+
+    //its own copy of the window's camera, looking at the same scene.  The scene just gets a second
+    //parent, the window's frame isn't running while we have it.
+    osg::ref_ptr<osgViewer::Viewer> viewer = new osgViewer::Viewer;
+    viewer->setThreadingModel(osgViewer::ViewerBase::SingleThreaded);
+    osg::Camera* camera = viewer->getCamera();
+    camera->setGraphicsContext(pbuffer.get());
+    camera->setViewport(new osg::Viewport(0, 0, traits->width, traits->height));
+    camera->setDrawBuffer(GL_FRONT);
+    camera->setReadBuffer(GL_FRONT);
+    camera->setClearColor(window->getClearColor());
+    camera->setViewMatrix(window->getViewMatrix());
+    camera->addChild(m_rootGroup);
+
+    viewer->realize();
+    if (!viewer->isRealized())
+        return false;
+
+    m_offscreenViewer = viewer;
+    return true;
+}
+
+void GraphicsThread::stopOffscreen()
+{
+    //the pbuffer closes with the viewer and takes its GL copies of the scene with it
+    m_offscreenViewer = nullptr;
+
+    //and the window's next frame lays everything out again for the window
+    m_linesWidth = -1.0;
+    m_piecesWidth = -1.0;
+}
+
 void GraphicsThread::init()
 {
     assert(m_osgViewer);
@@ -91,13 +229,22 @@ void GraphicsThread::init()
         return;
 
     createBoard();
+    createGamePieces();
     createGameStats();
 
+    if (auto camera = getCamera())
+        camera->setFinalDrawCallback(new FrameDrawnCallback(m_frameStarts, NumFrameStarts, &m_frameLatency));
+
     std::vector<osgViewer::View*> views;
     m_osgViewer->getViews(views);
     for (auto&& view : views)
-        view->addEventHandler(new ClickEventHandler);
+        view->addEventHandler(new ClickEventHandler(&m_layout, &m_ultimateLayout));
 
+    StartupTrace::mark("graphics init done");
+}
+
+void GraphicsThread::prepareResources()
+{
     m_xFile.setFileName(QDir::cleanPath(QApplication::applicationDirPath() + QDir::separator() + ".." + QDir::separator() + ".." + QDir::separator() + 
         "TicTacToe" + QDir::separator() + "Resources" + QDir::separator() + "X_Icon.png"));
     if (!m_xFile.exists())
@@ -107,16 +254,285 @@ void GraphicsThread::init()
         "TicTacToe" + QDir::separator() + "Resources" + QDir::separator() + "O_Icon.png"));
     if (!m_oFile.exists())
         qCritical() << "No O Icons Found!!";
+
+    //none of this needs a GL context, so it all happens on the pool while the window and the
+    //context get built.  Whoever needs a result first waits for it then.
+    std::string xFileName = m_xFile.fileName().toStdString();
+    m_xImage = QtConcurrent::run([xFileName]() {
+        osg::ref_ptr<osg::Image> image = osgDB::readImageFile(xFileName);
+        StartupTrace::mark("X icon decoded");
+        return image;
+    });
+
+    std::string oFileName = m_oFile.fileName().toStdString();
+    m_oImage = QtConcurrent::run([oFileName]() {
+        osg::ref_ptr<osg::Image> image = osgDB::readImageFile(oFileName);
+        StartupTrace::mark("O icon decoded");
+        return image;
+    });
+
+    m_statsFont = QtConcurrent::run([]() {
+        osg::ref_ptr<osgText::Font> font = new osgText::Font(new osgQt::QFontImplementation(QFont("Arial")));
+
+        //rasterize what the score line is made of, at the size Text asks for by default
+        const std::string characters = "Score: Player - / Computer - / Cat's Game - 0123456789*";
+        osgText::FontResolution resolution(32, 32);
+        for (char c : characters)
+            font->getGlyph(resolution, static_cast<unsigned char>(c));
+
+        StartupTrace::mark("score font ready");
+        return font;
+    });
+}
+
+osg::Image* GraphicsThread::getPieceImage(bool userMadeMove)
+{
+    //almost always long done by the time anybody's placed a piece
+    return userMadeMove ? m_oImage.result().get() : m_xImage.result().get();
+}
+
+void GraphicsThread::syncBoard()
+{
+    const GameChangeFeed& feed = tApp->getGameManager()->getChangeFeed();
+
+    //normally one or two deltas a frame.  If we stalled long enough to get lapped, grab the
+    //whole board and go from there.
+    GameChangeFeed::ReadResult result;
+    while ((result = feed.catchUp(m_board)) == GameChangeFeed::Updated)
+        ;
+
+    if (result == GameChangeFeed::NeedsSnapshot)
+        m_board = tApp->getGameManager()->getSnapshot();
+}
+
+void GraphicsThread::setMonitor(std::shared_ptr<BoardMonitor> monitor)
+{
+    addTask([this, monitor]() {
+        if (!m_rootGroup.valid() || !m_boardTransform.valid())
+            return;
+
+        if (monitor && !m_tileGrid)
+        {
+            m_tileGrid.reset(new BoardTileGrid(getPieceImage(false), getPieceImage(true)));
+            m_rootGroup->addChild(m_tileGrid->getNode());
+        }
+
+        //the old monitor (and its network thread) goes away here if nobody else has it
+        m_monitor = monitor;
+
+        m_boardTransform->setNodeMask(m_monitor ? 0u : ~0u);
+        if (m_tileGrid)
+            m_tileGrid->getNode()->setNodeMask(m_monitor ? ~0u : 0u);
+    });
+}
+
+void GraphicsThread::setVariant(GameMoveManager::Variant variant)
+{
+    addTask([this, variant]() {
+        if (!m_rootGroup.valid() || !m_boardTransform.valid() || variant == m_variant)
+            return;
+
+        if (variant == GameMoveManager::Ultimate && !m_ultimateView)
+        {
+            m_ultimateView.reset(new UltimateBoardView(getPieceImage(false), getPieceImage(true)));
+            m_boardTransform->addChild(m_ultimateView->getNode());
+        }
+        if (variant == GameMoveManager::Qubic && !m_qubicView)
+        {
+            m_qubicView.reset(new QubicBoardView);
+            m_boardTransform->addChild(m_qubicView->getNode());
+        }
+        m_variant = variant;
+
+        //the score text stays, the 3x3 lines and pieces make way for the other boards
+        bool classic = variant == GameMoveManager::Classic;
+        for (auto&& line : m_boardLines)
+            line->setNodeMask(classic ? ~0u : 0u);
+        for (auto&& piece : m_gamePieces)
+        {
+            piece.geode->setNodeMask(0);
+            piece.shown = BoardSnapshot::Empty;
+        }
+        if (m_ultimateView)
+            m_ultimateView->getNode()->setNodeMask(variant == GameMoveManager::Ultimate ? ~0u : 0u);
+        if (m_qubicView)
+            m_qubicView->getNode()->setNodeMask(variant == GameMoveManager::Qubic ? ~0u : 0u);
+
+        //draw it all the next frame
+        m_variantDrawn = false;
+        m_piecesWidth = -1.0;
+    });
+}
+
+void GraphicsThread::updateUltimate()
+{
+    auto camera = getCamera();
+    if (!camera || !m_ultimateView)
+        return;
+
+    m_ultimateLayout.setViewport(camera->getViewport()->width(), camera->getViewport()->height());
+
+    //the copy takes GMM's lock, the generation doesn't.  The view itself only redraws what changed.
+    uint64_t generation = tApp->getGameManager()->getUltimateGeneration();
+    if (!m_variantDrawn || generation != m_variantGeneration)
+    {
+        m_ultimateBoard = tApp->getGameManager()->getUltimateBoard();
+        m_variantGeneration = generation;
+        m_variantDrawn = true;
+    }
+    m_ultimateView->update(m_ultimateBoard, m_ultimateLayout);
+}
+
+void GraphicsThread::updateQubic()
+{
+    auto camera = getCamera();
+    if (!camera || !m_qubicView)
+        return;
+
+    uint64_t generation = tApp->getGameManager()->getQubicGeneration();
+    if (!m_variantDrawn || generation != m_variantGeneration)
+    {
+        m_qubicBoard = tApp->getGameManager()->getQubicBoard();
+        m_variantGeneration = generation;
+        m_variantDrawn = true;
+    }
+
+    //the view matrix follows the manipulator every frame, the cells only change with the board
+    m_qubicView->update(m_qubicBoard, camera->getViewport()->width(), camera->getViewport()->height());
+}
+
+void GraphicsThread::scrollMonitor(double tiles)
+{
+    if (m_tileGrid)
+        m_tileGrid->scroll(tiles);
+}
+
+void GraphicsThread::updateMonitor()
+{
+    auto camera = getCamera();
+    if (!camera || !m_tileGrid)
+        return;
+
+    m_tileGrid->update(*m_monitor, camera->getViewport()->width(), camera->getViewport()->height());
+}
+
+void GraphicsThread::setThreadingModel(osgViewer::ViewerBase::ThreadingModel threadingModel)
+{
+    addTask([this, threadingModel]() {
+        applyThreadingModel(threadingModel);
+    });
 }
 
-void GraphicsThread::handleMoveStored(const MoveStruct& move)
+void GraphicsThread::applyThreadingModel(osgViewer::ViewerBase::ThreadingModel threadingModel)
 {
-    m_currentMoves.push_back(move);
+    if (!m_osgViewer || m_osgViewer->getThreadingModel() == threadingModel)
+        return;
+
+    //we've been drawing, so the contexts are current in this thread.  They have to be let go
+    //before the viewer's threads can pick them up.
+    if (m_osgViewer->getThreadingModel() == osgViewer::ViewerBase::SingleThreaded)
+        m_osgViewer->releaseContexts();
+
+    //stops the old threads (they let go on the way out) and starts the new ones.  Going back to
+    //single threaded we just take the contexts the next time we draw.
+    m_osgViewer->setThreadingModel(threadingModel);
+
+    //the frame straddling the switch doesn't count
+    m_lastFrameEnd = std::chrono::steady_clock::time_point();
+}
+
+void GraphicsThread::startThreadingBenchmark(int secondsPerModel, bool quitWhenDone)
+{
+    addTask([this, secondsPerModel, quitWhenDone]() {
+        if (!m_osgViewer || m_benchmark)
+            return;
+
+        m_benchmark.reset(new ThreadingBenchmark);
+        m_benchmark->models.push_back(osgViewer::ViewerBase::SingleThreaded);
+        m_benchmark->models.push_back(osgViewer::ViewerBase::CullDrawThreadPerContext);
+        m_benchmark->models.push_back(osgViewer::ViewerBase::DrawThreadPerContext);
+        m_benchmark->models.push_back(osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext);
+        m_benchmark->current = 0;
+        m_benchmark->perModel = std::chrono::seconds(secondsPerModel > 0 ? secondsPerModel : 1);
+        m_benchmark->restoreModel = m_osgViewer->getThreadingModel();
+        m_benchmark->quitWhenDone = quitWhenDone;
+
+        printf("%-48s %7s | %-26s | %-26s\n", "", "", "frame time (us)", "update -> drawn (us)");
+        printf("%-48s %7s | %8s %8s %8s | %8s %8s %8s\n", "threading model", "fps", "mean", "p50", "p99", "mean", "p50", "p99");
+        fflush(stdout);
+
+        startBenchmarkPhase();
+    });
+}
+
+void GraphicsThread::startBenchmarkPhase()
+{
+    auto threadingModel = m_benchmark->models[m_benchmark->current];
+    applyThreadingModel(threadingModel);
+
+    m_benchmark->warmedUp = false;
+    m_benchmark->phaseStarted = std::chrono::steady_clock::now();
+
+    m_userMessage = std::string("Benchmarking ") + OSGViewerWidget::getThreadingModelName(threadingModel) + "...";
+}
+
+void GraphicsThread::stepThreadingBenchmark()
+{
+    ThreadingBenchmark& benchmark = *m_benchmark;
+    auto now = std::chrono::steady_clock::now();
+
+    if (!benchmark.warmedUp)
+    {
+        if (now - benchmark.phaseStarted < BenchmarkWarmup)
+            return;
+
+        //count from here
+        m_frameTimes.reset();
+        m_frameLatency.reset();
+        benchmark.warmedUp = true;
+        benchmark.phaseStarted = now;
+        return;
+    }
+
+    if (now - benchmark.phaseStarted < benchmark.perModel)
+        return;
+
+    double seconds = std::chrono::duration<double>(now - benchmark.phaseStarted).count();
+    char line[256];
+    snprintf(line, sizeof(line), "%-48s %7.1f | %8.0f %8llu %8llu | %8.0f %8llu %8llu",
+        OSGViewerWidget::getThreadingModelName(benchmark.models[benchmark.current]),
+        m_frameTimes.getCount() / seconds,
+        m_frameTimes.getMeanMicros(),
+        static_cast<unsigned long long>(m_frameTimes.getPercentileMicros(0.5)),
+        static_cast<unsigned long long>(m_frameTimes.getPercentileMicros(0.99)),
+        m_frameLatency.getMeanMicros(),
+        static_cast<unsigned long long>(m_frameLatency.getPercentileMicros(0.5)),
+        static_cast<unsigned long long>(m_frameLatency.getPercentileMicros(0.99)));
+    printf("%s\n", line);
+    fflush(stdout);
+    qDebug() << line;
+
+    if (++benchmark.current < benchmark.models.size())
+    {
+        startBenchmarkPhase();
+        return;
+    }
+
+    applyThreadingModel(benchmark.restoreModel);
+    m_userMessage = "Threading benchmark done, the numbers are in the log.";
+
+    bool quit = benchmark.quitWhenDone;
+    m_benchmark.reset();
+    if (quit)
+        QMetaObject::invokeMethod(tApp, "quit", Qt::QueuedConnection);
 }
 
-void GraphicsThread::handleBoardCleared()
+void GraphicsThread::syncUserMoveReplies()
 {
-    m_currentMoves.clear();
+    //the newest one wins, a successful move clears whatever we were saying before
+    UserMoveReply reply;
+    while (tApp->getGameManager()->takeUserMoveReply(reply))
+        m_userMessage = GameMoveManager::getUserMoveMessage(reply.result);
 }
 
 void GraphicsThread::run()
@@ -172,14 +588,47 @@ void GraphicsThread::run()
 
         }
 
+        //this frame's update starts here, its latency runs until the draw callback sees it drawn
+        if (m_osgViewer)
+        {
+            unsigned int frameNumber = m_osgViewer->getFrameStamp()->getFrameNumber() + 1;
+            m_frameStarts[frameNumber % NumFrameStarts].store(nowNanos(), std::memory_order_release);
+        }
+
+        syncBoard();
+        syncUserMoveReplies();
+
         updateBoard();
         updateGameStats();
-        updateGamePieces();
+        if (m_monitor)
+            updateMonitor();
+        else if (m_variant == GameMoveManager::Ultimate)
+            updateUltimate();
+        else if (m_variant == GameMoveManager::Qubic)
+            updateQubic();
+        else
+            updateGamePieces();
 
         //step viewer
         if (m_osgViewer)
+        {
             m_osgViewer->frame();
 
+            auto frameEnd = std::chrono::steady_clock::now();
+            if (m_lastFrameEnd != std::chrono::steady_clock::time_point())
+                m_frameTimes.record(std::chrono::duration_cast<std::chrono::nanoseconds>(frameEnd - m_lastFrameEnd));
+            m_lastFrameEnd = frameEnd;
+
+            if (!m_firstFrameDrawn)
+            {
+                m_firstFrameDrawn = true;
+                StartupTrace::finish();
+            }
+
+            if (m_benchmark)
+                stepThreadingBenchmark();
+        }
+
         //let Qt's event queue process
         QApplication::processEvents();
 
@@ -200,12 +649,15 @@ void GraphicsThread::createBoard()
     m_boardTransform = new osg::PositionAttitudeTransform;
     m_rootGroup->addChild(m_boardTransform);
 
-    //make four lines for the board
-    for (int i = 0; i < 4; ++i)
+    //make the lines for the board, four of them for the usual 3x3
+    for (int i = 0; i < m_layout.getNumLines(); ++i)
     {
         osg::Geode* lineGeode = new osg::Geode;
         osg::Geometry* segment = new osg::Geometry;
 
+        //updateBoard moves the corners when the window resizes, maybe while a draw thread has it
+        segment->setDataVariance(osg::Object::DYNAMIC);
+
         osg::ref_ptr<osg::Vec4Array> color = new osg::Vec4Array;
         color->push_back(osg::Vec4f(1.0f, 0.0f, 0.0f, 0.8f));
 
@@ -237,8 +689,15 @@ void GraphicsThread::updateBoard()
     // set the projection matrix of the camera, this probably doesn't belong here
     camera->setProjectionMatrixAsOrtho2D(0, xMax, 0, yMax);
 
+    //first thing every frame, everything after this (including clicks) goes by the layout
+    m_layout.setViewport(xMax, yMax);
+
+    //the lines only move when the window does
+    if (xMax == m_linesWidth && yMax == m_linesHeight)
+        return;
+    m_linesWidth = xMax;
+    m_linesHeight = yMax;
 
-    double posMultiplier;
     //update position of board
     for (int i = 0; i < m_boardLines.size(); ++i)
     {
@@ -264,24 +723,14 @@ void GraphicsThread::updateBoard()
         }
         points->clear();
 
-        //two horizontal, then two vertical
+        //horizontal ones first, then vertical
         //forcing the board in the back a bit so the text is on top
-        if (i < 2)
-        {
-            posMultiplier = i == 0 ? 1.0 : 2.0;
-            points->push_back(osg::Vec3d(20.0, (yMax / 3.0) * posMultiplier, -0.1));
-            points->push_back(osg::Vec3d((xMax - 20.0), (yMax / 3.0) * posMultiplier, -0.1));
-            points->push_back(osg::Vec3d((xMax - 20.0), ((yMax / 3.0)* posMultiplier) - 10.0 , -0.1));
-            points->push_back(osg::Vec3d(20.0, ((yMax / 3.0)* posMultiplier) - 10.0, -0.1));
-        }
-        else
-        {
-            posMultiplier = i == 2 ? 1.0 : 2.0;
-            points->push_back(osg::Vec3d((xMax / 3.0) * posMultiplier, yMax - 20, -0.1));
-            points->push_back(osg::Vec3d(((xMax / 3.0)  * posMultiplier) + 10.0, yMax - 20, -0.1));
-            points->push_back(osg::Vec3d(((xMax / 3.0)  * posMultiplier) + 10.0, 20.0, -0.1));
-            points->push_back(osg::Vec3d((xMax / 3.0) * posMultiplier, 20.0, -0.1));
-        }
+        BoardLayout::Rect line = m_layout.getLineRect(i);
+        points->push_back(osg::Vec3d(line.xMin, line.yMax, -0.1));
+        points->push_back(osg::Vec3d(line.xMax, line.yMax, -0.1));
+        points->push_back(osg::Vec3d(line.xMax, line.yMin, -0.1));
+        points->push_back(osg::Vec3d(line.xMin, line.yMin, -0.1));
+        points->dirty();
 
         segment->setVertexArray(points);
     }
@@ -299,7 +748,9 @@ void GraphicsThread::createGameStats()
 
     m_gameStats = new osgText::Text;
 
-    m_gameStats->setFont(new osgText::Font(new osgQt::QFontImplementation(QFont("Arial"))));
+    //the score changes under it, so a draw thread has to be done with it before we carry on
+    m_gameStats->setDataVariance(osg::Object::DYNAMIC);
+
     m_gameStats->setColor(osg::Vec4(1.0f, 1.0f, 1.0f, 0.6f));
     m_gameStats->setCharacterSize(15.0f);
 
@@ -313,11 +764,22 @@ void GraphicsThread::updateGameStats()
     if (!m_gameStats)
         return;
 
+    //the default font stands in until the pool has ours ready
+    if (!m_statsFontApplied && m_statsFont.isFinished())
+    {
+        m_gameStats->setFont(m_statsFont.result());
+        m_statsFontApplied = true;
+    }
+
     std::string userMessage = "Score: Player - " + std::to_string(m_playerWins) + " / Computer - " + std::to_string(m_aiWins) + " / Cat's Game - " + std::to_string(m_catWins);
     if (!m_userMessage.empty())
         userMessage.append("\n    ***" + m_userMessage + "***");
 
-    m_gameStats->setText(userMessage);
+    if (userMessage != m_shownStats)
+    {
+        m_gameStats->setText(userMessage);
+        m_shownStats = userMessage;
+    }
 
     auto camera = getCamera();
     if (!camera)
@@ -331,6 +793,50 @@ void GraphicsThread::updateGameStats()
 
 }
 
+void GraphicsThread::createGamePieces()
+{
+    assert(m_boardTransform);
+    if (!m_boardTransform)
+        return;
+
+    for (int cell = 0; cell < 9; ++cell)
+    {
+        osg::Geometry* geom = new osg::Geometry;
+
+        //the corners get rewritten when the window resizes, and a square's piece is reused for X and O
+        geom->setDataVariance(osg::Object::DYNAMIC);
+        geom->setUseDisplayList(false);
+        geom->setUseVertexBufferObjects(true);
+
+        geom->setVertexArray(new osg::Vec3Array(4));
+
+        osg::Vec2Array* texcoords = new osg::Vec2Array;
+        texcoords->push_back(osg::Vec2f(0.0f, 1.0f));
+        texcoords->push_back(osg::Vec2f(0.0f, 0.0f));
+        texcoords->push_back(osg::Vec2f(1.0f, 0.0f));
+        texcoords->push_back(osg::Vec2f(1.0f, 1.0f));
+        geom->setTexCoordArray(0, texcoords);
+
+        osg::Vec4Array* colors = new osg::Vec4Array;
+        colors->push_back(osg::Vec4f(1.0f, 1.0f, 1.0f, 1.0f));
+        geom->setColorArray(colors, osg::Array::BIND_OVERALL);
+
+        geom->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, 4));
+
+        osg::Geode* geode = new osg::Geode;
+        geode->setDataVariance(osg::Object::DYNAMIC);
+        geode->addDrawable(geom);
+        geode->setNodeMask(0);
+        m_boardTransform->addChild(geode);
+
+        GamePiece piece;
+        piece.geode = geode;
+        piece.geometry = geom;
+        piece.shown = BoardSnapshot::Empty;
+        m_gamePieces.push_back(piece);
+    }
+}
+
 void GraphicsThread::updateGamePieces()
 {
     if (!m_boardTransform.valid())
@@ -342,95 +848,156 @@ void GraphicsThread::updateGamePieces()
 
     auto xMax = camera->getViewport()->width();
     auto yMax = camera->getViewport()->height();
+    bool relayout = xMax != m_piecesWidth || yMax != m_piecesHeight;
+    m_piecesWidth = xMax;
+    m_piecesHeight = yMax;
 
-
-    auto displayedMove = m_displayedMoves.begin();
-    for (auto&& move : m_currentMoves)
+    for (int cell = 0; cell < static_cast<int>(m_gamePieces.size()); ++cell)
     {
-        if (displayedMove == m_displayedMoves.end())
-        {
-            osg::Geometry* geom = new osg::Geometry;
-
-            osg::Vec2Array* texcoords = new osg::Vec2Array;
-            texcoords->push_back(osg::Vec2f(0.0f, 1.0f));
-            texcoords->push_back(osg::Vec2f(0.0f, 0.0f));
-            texcoords->push_back(osg::Vec2f(1.0f, 0.0f));
-            texcoords->push_back(osg::Vec2f(1.0f, 1.0f));
-            geom->setTexCoordArray(0, texcoords);
-
-            osg::Vec4Array* colors = new osg::Vec4Array;
-            colors->push_back(osg::Vec4f(1.0f, 1.0f, 1.0f, 1.0f));
-            geom->setColorArray(colors, osg::Array::BIND_OVERALL);
-
-            geom->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, 4));
+        GamePiece& piece = m_gamePieces[cell];
+        uint8_t side = m_board.cells[cell];
+        if (side == piece.shown && !relayout)
+            continue;
+        piece.shown = side;
 
-            osg::Geode* geode = new osg::Geode;
-            geode->addDrawable(geom);
-            m_boardTransform->addChild(geode);
+        if (side == BoardSnapshot::Empty)
+        {
+            piece.geode->setNodeMask(0);
+            continue;
+        }
 
-            std::string moveFile = move.userMadeMove ? m_oFile.fileName().toStdString() : m_xFile.fileName().toStdString();
+        MoveStruct move(cell % 3, cell / 3, side == BoardSnapshot::Player);
 
-            osg::Texture2D* texture = new osg::Texture2D;
-            texture->setDataVariance(osg::Object::DYNAMIC);
-            texture->setImage(osgDB::readImageFile(moveFile));
+        if (!m_xPieceState)
+        {
+            m_xPieceState = createPieceState(getPieceImage(false));
+            m_oPieceState = createPieceState(getPieceImage(true));
+        }
+        piece.geode->setStateSet(move.userMadeMove ? m_oPieceState.get() : m_xPieceState.get());
 
-            osg::StateSet* stateset = geom->getOrCreateStateSet();
-            stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
-            stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
-            stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+        //min/max positions of texture
+        BoardLayout::Rect rect = m_layout.getPieceRect(move.xPos, move.yPos);
 
-            DisplayedMove dm;
-            dm.geode = geode;
-            dm.geometry = geom;
-            dm.texture = texture;
+        osg::Vec3Array* vertices = static_cast<osg::Vec3Array*>(piece.geometry->getVertexArray());
+        (*vertices)[0].set(rect.xMin, rect.yMax, 0);
+        (*vertices)[1].set(rect.xMax, rect.yMax, 0);
+        (*vertices)[2].set(rect.xMax, rect.yMin, 0);
+        (*vertices)[3].set(rect.xMin, rect.yMin, 0);
+        vertices->dirty();
+        piece.geometry->dirtyBound();
 
-            displayedMove = m_displayedMoves.insert(displayedMove, dm);
+        piece.geode->setNodeMask(~0u);
+    }
+}
 
+void GraphicsThread::addBenchmarks(MicroBenchmark& suite)
+{
+    //post a batch, then wait for the lot to run
+    suite.add("GraphicsThread/addTask/throughput", [this](MicroBenchmark::State& state) {
+        const int batch = 1000;
+        std::atomic<uint64_t> ran(0);
+        while (state.keepRunning())
+        {
+            for (int i = 0; i < batch; ++i)
+                addTask([&ran]() { ++ran; });
+            addTaskBlocking([]() {});
         }
-
-        else if (displayedMove != m_displayedMoves.end())
+        state.setItemsProcessed(ran);
+    });
+
+    //from addTask to the task running.  We're only ever picked up between frames, so this is mostly frame time.
+    suite.add("GraphicsThread/addTask/wakeLatency", [this](MicroBenchmark::State& state) {
+        LatencyHistogram latency;
+        std::atomic<bool> ran(false);
+        while (state.keepRunning())
         {
-            auto texture = (*displayedMove).texture;
-            auto geometry = (*displayedMove).geometry;
-
-            osg::Vec3Array* vertices = dynamic_cast<osg::Vec3Array*>(geometry->getVertexArray());
-            if (!vertices)
-                vertices = new osg::Vec3Array;
-
-            vertices->clear();
+            ran = false;
+            auto posted = std::chrono::steady_clock::now();
+            addTask([&latency, &ran, posted]() {
+                latency.record(std::chrono::steady_clock::now() - posted);
+                ran = true;
+            });
+            while (!ran)
+                std::this_thread::yield();
+        }
+        state.setCounter("p50_us", double(latency.getPercentileMicros(0.5)));
+        state.setCounter("p99_us", double(latency.getPercentileMicros(0.99)));
+        state.setCounter("max_us", double(latency.getMaxMicros()));
+    });
+
+    //the updates run on our thread, between frames, same as they do in run(), but against a pbuffer
+    //so the window isn't part of it (and isn't showing half made boards while we go).
+    //forced ones make the update do its real work every time instead of noticing nothing changed.
+    auto addUpdate = [this, &suite](const std::string& name, std::function<void()> update) {
+        suite.add("GraphicsThread/" + name, [this, update](MicroBenchmark::State& state) {
+            addTaskBlocking([this, update, &state]() {
+                if (!startOffscreen())
+                {
+                    state.skipWithError("no pbuffer");
+                    return;
+                }
+
+                BoardSnapshot board = m_board;
+                while (state.keepRunning())
+                    update();
+
+                //put it all back the way the game has it
+                stopOffscreen();
+                m_board = board;
+                m_shownStats.clear();
+            });
+        });
+    };
+
+    addUpdate("updateBoard/steady", [this]() {
+        updateBoard();
+    });
+    addUpdate("updateBoard/relayout", [this]() {
+        m_linesWidth = -1.0;
+        updateBoard();
+    });
 
-            //calc min/max positions of texture
-            double texXMin = move.xPos == 0 ? 10.0 : move.xPos == 1 ? (xMax / 3) + 10.0 : ((xMax / 3) * 2) + 10.0;
-            double texXMax = move.xPos == 0 ? (xMax / 3) - 10.0 : move.xPos == 1 ? ((xMax / 3) * 2) - 10.0 : xMax - 10.0;
-            double texYMin = move.yPos == 0 ? ((yMax / 3) * 2) + 10.0 : move.yPos == 1 ? (yMax / 3) + 10.0 : 10.0;
-            double texYMax = move.yPos == 0 ? yMax - 10.0 : move.yPos == 1 ? ((yMax / 3)*2) - 10.0 : (yMax / 3) - 10.0;
+    //a board with five pieces on it, drawn over and over
+    addUpdate("updateGamePieces/steady", [this]() {
+        const uint8_t cells[9] = { 1, 2, 0, 0, 1, 0, 2, 0, 1 };
+        std::copy(cells, cells + 9, m_board.cells.begin());
+        updateGamePieces();
+    });
 
-            vertices->push_back(osg::Vec3d(texXMin, texYMax, 0));
-            vertices->push_back(osg::Vec3d(texXMax, texYMax, 0));
-            vertices->push_back(osg::Vec3d(texXMax, texYMin, 0));
-            vertices->push_back(osg::Vec3d(texXMin, texYMin, 0));
+    //empty, then full, then empty: every piece comes and goes
+    addUpdate("updateGamePieces/churn", [this]() {
+        const uint8_t cells[9] = { 1, 2, 1, 2, 1, 2, 2, 1, 2 };
+        if (m_board.numMoves())
+            m_board.cells.fill(BoardSnapshot::Empty);
+        else
+            std::copy(cells, cells + 9, m_board.cells.begin());
+        updateGamePieces();
+    });
 
-            geometry->setVertexArray(vertices);
+    addUpdate("updateGameStats/steady", [this]() {
+        updateGameStats();
+    });
+    addUpdate("updateGameStats/changed", [this]() {
+        m_shownStats.clear();
+        updateGameStats();
+    });
 
-            std::string moveFile = move.userMadeMove ? m_oFile.fileName().toStdString() : m_xFile.fileName().toStdString();
-            if (texture->getImage() && moveFile != texture->getImage()->getFileName())
-            {
-                qWarning() << "Changing image file!!";
-                texture->setImage(osgDB::readImageFile(moveFile));
-            }
-        }
-        ++displayedMove;
-    }
-    while (displayedMove != m_displayedMoves.end())
-    {
-        m_boardTransform->removeChild((*displayedMove).geode);
-        displayedMove = m_displayedMoves.erase(displayedMove);
-    }
+    //everything run() does for a frame of the classic board, drawn to the pbuffer
+    addUpdate("frame/offscreen", [this]() {
+        updateBoard();
+        updateGameStats();
+        updateGamePieces();
+        m_offscreenViewer->frame();
+    });
 }
 
 void GraphicsThread::setUserMessage(const std::string& message)
 {
-    m_userMessage = message;
+    //the UI thread calls this too, so it waits its turn with the other tasks
+    //instead of writing the string while we're drawing it
+    addTask([this, message]() {
+        m_userMessage = message;
+    });
 }
 
 void GraphicsThread::handleScoreUpdated(uint64_t playerScore, uint64_t aiScore, uint64_t catScore)
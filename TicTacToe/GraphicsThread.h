@@ -1,19 +1,31 @@
 #pragma once
 
 #include "GameMoveManager.h"
+#include "BoardLayout.h"
+#include "LatencyHistogram.h"
+#include "MicroBenchmark.h"
 
 
 #include <functional>
 #include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <chrono>
 #include <assert.h>
 
 #include <osg/ref_ptr>
+#include <osgViewer/ViewerBase>
 
 #include <QThread>
 #include <QReadWriteLock>
 #include <QFile>
+#include <QFuture>
 
 class OSGViewerWidget;
+class BoardMonitor;
+class BoardTileGrid;
+class UltimateBoardView;
+class QubicBoardView;
 
 namespace osg
 {
@@ -23,11 +35,19 @@ namespace osg
     class Texture2D;
     class Geometry;
     class Geode;
+    class Image;
+    class StateSet;
 }
 
 namespace osgText
 {
     class Text;
+    class Font;
+}
+
+namespace osgViewer
+{
+    class Viewer;
 }
 
 namespace
@@ -73,16 +93,59 @@ public:
     //add a task and block until it's completion
     void addTaskBlocking(std::function<void()> task);
 
+    //safe from any thread, it's handed over as a task
     void setUserMessage(const std::string& message);
 
+    //where the board is on screen as of this frame.  Only touch it from our thread,
+    //the event handlers run inside frame() so they're fine.
+    const BoardLayout& getBoardLayout() const { return m_layout; }
+
+    //swap our board for tiles of every game the monitor is watching, nullptr to come back.
+    //safe from any thread, we hold on to the monitor until we're done with it.
+    void setMonitor(std::shared_ptr<BoardMonitor> monitor);
+
+    //our board, the 9x9 ultimate one or the qubic cube.  Safe from any thread, the game manager
+    //has to be switched too (it decides where clicks land).
+    void setVariant(GameMoveManager::Variant variant);
+
+    //our thread only, nullptr until qubic's been picked
+    QubicBoardView* getQubicView() const { return m_qubicView.get(); }
+
+    //our thread only
+    bool isMonitoring() const { return m_monitor != nullptr; }
+    void scrollMonitor(double tiles);
+
+    //safe from any thread.  With the threaded models the draw of one frame runs while we update
+    //the next, which only works because everything we touch between frames is marked DYNAMIC:
+    //frame() doesn't come back until the dynamic stuff has been drawn.
+    void setThreadingModel(osgViewer::ViewerBase::ThreadingModel threadingModel);
+
+    //runs each threading model for a while and prints frame time and update -> drawn latency for
+    //each one.  Safe from any thread.
+    void startThreadingBenchmark(int secondsPerModel, bool quitWhenDone);
+
+    //the task queue's throughput and wake up latency, and what each per frame update (and a whole
+    //frame) costs on our thread.  The updates and the frame go to a pbuffer of their own the size
+    //of the window, not to the window.  Run them from some other thread.
+    void addBenchmarks(MicroBenchmark& suite);
+
+    //how far apart frames are, and how long from when we update a frame to when it's drawn
+    const LatencyHistogram& getFrameTimes() const { return m_frameTimes; }
+    const LatencyHistogram& getFrameLatency() const { return m_frameLatency; }
+
 protected slots:
-    void handleMoveStored(const MoveStruct& move);
-    void handleBoardCleared();
     void handleScoreUpdated(uint64_t playerScore, uint64_t aiScore, uint64_t catScore);
 
 protected:
     virtual void run();
 
+    //kicks off everything that doesn't need the GL context on the pool, from the constructor
+    //so it runs while the window is still being built
+    void prepareResources();
+
+    //waits for the decode if it isn't done yet
+    osg::Image* getPieceImage(bool userMadeMove);
+
     void createBoard();
 
     void updateBoard();
@@ -91,10 +154,38 @@ protected:
 
     void updateGameStats();
 
+    //pull whatever changed on the board since last frame
+    void syncBoard();
+
+    //answers to the moves ClickEventHandler posted
+    void syncUserMoveReplies();
+
+    void createGamePieces();
+
+    //only touches the squares that changed since last frame, or all of them if the window did
     void updateGamePieces();
 
+    void updateMonitor();
+
+    //copy the ultimate or qubic board out of GMM only when it's moved on since last frame
+    void updateUltimate();
+    void updateQubic();
+
+    void applyThreadingModel(osgViewer::ViewerBase::ThreadingModel threadingModel);
+
+    void startBenchmarkPhase();
+
+    //once a frame while a benchmark is going, moves it on to the next model when it's time
+    void stepThreadingBenchmark();
+
+    //the window's camera, or the pbuffer's while a benchmark has one
     osg::Camera* getCamera() const;
 
+    //a single threaded viewer on a pbuffer the size of the window, drawing our scene.  false if
+    //there's no window or the platform wouldn't give us a pbuffer.
+    bool startOffscreen();
+    void stopOffscreen();
+
     std::vector < std::function<void()>> m_tasks;
     std::condition_variable m_blockingTaskComplete;
     std::mutex m_blockingTaskMutex;
@@ -104,6 +195,23 @@ protected:
 
     QReadWriteLock m_RWLock;
 
+    BoardLayout m_layout;
+    BoardLayout m_ultimateLayout;
+
+    std::shared_ptr<BoardMonitor> m_monitor;
+    std::unique_ptr<BoardTileGrid> m_tileGrid;
+
+    //made the first time each one is picked, hidden (not thrown away) when we go back
+    std::unique_ptr<UltimateBoardView> m_ultimateView;
+    std::unique_ptr<QubicBoardView> m_qubicView;
+    GameMoveManager::Variant m_variant;
+    UltimateBoard m_ultimateBoard;
+    QubicBoard m_qubicBoard;
+
+    //the generation of whichever of those two boards we last copied
+    uint64_t m_variantGeneration;
+    bool m_variantDrawn;
+
     osg::ref_ptr<osg::Group> m_rootGroup;
 
     std::vector<osg::ref_ptr<osg::Geode>> m_boardLines;
@@ -114,20 +222,72 @@ protected:
     bool m_done;
     bool m_threadsWaiting;
 
-    std::vector<MoveStruct> m_currentMoves;
+    //the viewport the board lines were last laid out for, they only get rewritten when it changes
+    double m_linesWidth;
+    double m_linesHeight;
+
+    //what the score text last said, setText lays the glyphs out again every time
+    std::string m_shownStats;
 
-    struct DisplayedMove
+    //when we started updating each frame, by frame number.  The draw callback (which might be on
+    //one of the viewer's threads) looks its frame up here.  A few deep since the draw can lag.
+    static const int NumFrameStarts = 8;
+    std::atomic<int64_t> m_frameStarts[NumFrameStarts];
+    std::chrono::steady_clock::time_point m_lastFrameEnd;
+    LatencyHistogram m_frameTimes;
+    LatencyHistogram m_frameLatency;
+
+    struct ThreadingBenchmark
+    {
+        std::vector<osgViewer::ViewerBase::ThreadingModel> models;
+        size_t current;
+        bool warmedUp;
+        std::chrono::seconds perModel;
+        std::chrono::steady_clock::time_point phaseStarted;
+        osgViewer::ViewerBase::ThreadingModel restoreModel;
+        bool quitWhenDone;
+    };
+
+    std::unique_ptr<ThreadingBenchmark> m_benchmark;
+
+    //only while an update benchmark runs, see startOffscreen
+    osg::ref_ptr<osgViewer::Viewer> m_offscreenViewer;
+
+    //our own copy of the board, kept current from the GMM change feed.  The slots used to
+    //fill a move list from the UI thread while we were drawing it.
+    BoardSnapshot m_board;
+
+    //one piece per square, made with the board and never thrown away.  An empty square's piece
+    //is masked off; a new game just masks them all again instead of freeing and reallocating.
+    struct GamePiece
     {
-        osg::ref_ptr<osg::Texture2D> texture;
-        osg::ref_ptr<osg::Geometry> geometry;
         osg::ref_ptr<osg::Geode> geode;
+        osg::ref_ptr<osg::Geometry> geometry;    //its four corners are allocated up front and rewritten in place
+        uint8_t shown;      //what the square had when we last drew it, a BoardSnapshot cell
     };
 
-    std::vector<DisplayedMove> m_displayedMoves;
+    std::vector<GamePiece> m_gamePieces;
+
+    //one X and one O look (and texture) for every piece.  Made the first time a piece shows so
+    //building the board doesn't wait on the image decode.
+    osg::ref_ptr<osg::StateSet> m_xPieceState;
+    osg::ref_ptr<osg::StateSet> m_oPieceState;
+
+    //the viewport the pieces were last laid out for, same as the lines
+    double m_piecesWidth;
+    double m_piecesHeight;
 
     QFile m_xFile;
     QFile m_oFile;
 
+    QFuture<osg::ref_ptr<osg::Image>> m_xImage;
+    QFuture<osg::ref_ptr<osg::Image>> m_oImage;
+    QFuture<osg::ref_ptr<osgText::Font>> m_statsFont;
+    bool m_statsFontApplied;
+
+    bool m_firstFrameDrawn;
+
+    //only touched on our thread
     std::string m_userMessage;
 
     //we keep this locally instead of accessing directly from GMM because
@@ -0,0 +1,103 @@
+#include "LatencyHistogram.h"
+
+#include <sstream>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto&& bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_totalMicros.store(0, std::memory_order_relaxed);
+    m_maxMicros.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency)
+{
+    uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+
+    //find the highest set bit, that's our bucket
+    int bucket = 0;
+    uint64_t value = micros;
+    while (value && bucket < NumBuckets - 1)
+    {
+        value >>= 1;
+        ++bucket;
+    }
+
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_totalMicros.fetch_add(micros, std::memory_order_relaxed);
+
+    uint64_t currentMax = m_maxMicros.load(std::memory_order_relaxed);
+    while (micros > currentMax && !m_maxMicros.compare_exchange_weak(currentMax, micros, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint64_t LatencyHistogram::getCount() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getMaxMicros() const
+{
+    return m_maxMicros.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::getMeanMicros() const
+{
+    uint64_t count = getCount();
+    if (!count)
+        return 0.0;
+    return static_cast<double>(m_totalMicros.load(std::memory_order_relaxed)) / count;
+}
+
+uint64_t LatencyHistogram::getBucketCount(int bucket) const
+{
+    if (bucket < 0 || bucket >= NumBuckets)
+        return 0;
+    return m_buckets[bucket].load(std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::getPercentileMicros(double percentile) const
+{
+    uint64_t count = getCount();
+    if (!count)
+        return 0;
+
+    uint64_t target = static_cast<uint64_t>(percentile * count);
+    if (target >= count)
+        target = count - 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < NumBuckets; ++i)
+    {
+        seen += getBucketCount(i);
+        if (seen > target)
+            return uint64_t(1) << i;
+    }
+    return getMaxMicros();
+}
+
+std::string LatencyHistogram::toString() const
+{
+    std::ostringstream out;
+    out << "n=" << getCount()
+        << " mean=" << getMeanMicros() << "us"
+        << " p50<" << getPercentileMicros(0.5) << "us"
+        << " p99<" << getPercentileMicros(0.99) << "us"
+        << " max=" << getMaxMicros() << "us";
+
+    for (int i = 0; i < NumBuckets; ++i)
+    {
+        uint64_t bucketCount = getBucketCount(i);
+        if (bucketCount)
+            out << " [<" << (uint64_t(1) << i) << "us: " << bucketCount << "]";
+    }
+    return out.str();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <string>
+
+//lock free histogram with power of two microsecond buckets.
+//bucket 0 is < 1us, bucket 1 is < 2us, bucket 2 is < 4us, etc.
+//recording is a couple of atomic adds, so it's safe to call from any thread.
+class LatencyHistogram
+{
+public:
+    static const int NumBuckets = 32;
+
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds latency);
+
+    void reset();
+
+    uint64_t getCount() const;
+    uint64_t getMaxMicros() const;
+    double getMeanMicros() const;
+
+    //upper bound (in us) of the bucket the given percentile falls in, 0.0 - 1.0
+    uint64_t getPercentileMicros(double percentile) const;
+
+    uint64_t getBucketCount(int bucket) const;
+
+    //one line summary plus the non-empty buckets, for logging
+    std::string toString() const;
+
+protected:
+    std::atomic<uint64_t> m_buckets[NumBuckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_totalMicros;
+    std::atomic<uint64_t> m_maxMicros;
+};
@@ -0,0 +1,399 @@
+#include "LineBoard.h"
+
+#include <algorithm>
+#include <assert.h>
+
+namespace
+{
+    //right, down, down right, down left
+    const int DirectionX[4] = { 1, 0, 1, -1 };
+    const int DirectionY[4] = { 0, 1, 1, 1 };
+
+    //which list a line is in
+    enum LineList : int8_t
+    {
+        NoList = -1,
+        PlayerFours,
+        AIFours,
+        PlayerThrees,
+        AIThrees
+    };
+
+    //far enough to cover every cell a sensible move could be on
+    const int NeighbourReach = 2;
+
+    int countBits(int bits)
+    {
+        int count = 0;
+        for (; bits; bits &= bits - 1)
+            ++count;
+        return count;
+    }
+
+    //a bit for each direction whose byte isn't zero.  a byte never gets near 0x80 (it's k lines
+    //at most), so adding 0x7f sets its top bit exactly when it's nonzero, and the multiply
+    //gathers those four bits next to each other at 21 to 24
+    int directionBits(uint32_t counts)
+    {
+        uint32_t nonzero = ((counts + 0x7f7f7f7fu) & 0x80808080u) >> 7;
+        return static_cast<int>(((nonzero * 0x00204081u) >> 21) & 0xf);
+    }
+}
+
+LineBoard::LineBoard(int width, int height, int inARow) : m_width(width),
+    m_height(height),
+    m_inARow(inARow),
+    m_numStones(0),
+    m_cells(width * height, BoardSnapshot::Empty),
+    m_cellValues(width * height, CellValue()),
+    m_neighbours(width * height, 0),
+    m_candidateSlot(width * height, -1),
+    m_keys(width * height),
+    m_hash(0)
+{
+    assert(inARow >= 3 && (inARow <= width || inARow <= height));
+
+    for (int direction = 0; direction < 4; ++direction)
+    {
+        int dx = DirectionX[direction];
+        int dy = DirectionY[direction];
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                int endX = x + (dx * (inARow - 1));
+                int endY = y + (dy * (inARow - 1));
+                if (endX < 0 || endX >= width || endY >= height)
+                    continue;
+
+                m_lineStart.push_back((y * width) + x);
+                m_lineStep.push_back((dy * width) + dx);
+                m_lineDirection.push_back(static_cast<uint8_t>(direction));
+            }
+        }
+    }
+
+    int numLines = static_cast<int>(m_lineStart.size());
+    m_lineCounts.assign(numLines * 2, 0);
+    m_lineList.assign(numLines, NoList);
+    m_lineSlot.assign(numLines, 0);
+
+    //so filing lines never allocates in the middle of a search
+    for (int side = 0; side < 2; ++side)
+    {
+        m_fours[side].reserve(numLines);
+        m_threes[side].reserve(numLines);
+    }
+
+    //lines by cell, counted first so they all go in one array
+    std::vector<int> linesPerCell(getNumCells(), 0);
+    for (int line = 0; line < numLines; ++line)
+        for (int i = 0; i < inARow; ++i)
+            ++linesPerCell[getLineCell(line, i)];
+
+    m_cellLineStart.assign(getNumCells() + 1, 0);
+    for (int cell = 0; cell < getNumCells(); ++cell)
+        m_cellLineStart[cell + 1] = m_cellLineStart[cell] + linesPerCell[cell];
+
+    m_cellLines.resize(m_cellLineStart.back());
+    std::vector<int> filled(m_cellLineStart.begin(), m_cellLineStart.end() - 1);
+    for (int line = 0; line < numLines; ++line)
+        for (int i = 0; i < inARow; ++i)
+            m_cellLines[filled[getLineCell(line, i)]++] = line;
+
+    //and the cells near each cell, worked out once so a move doesn't have to clip them to the board
+    m_cellNeighbourStart.push_back(0);
+    for (int cell = 0; cell < getNumCells(); ++cell)
+    {
+        int x = cell % width;
+        int y = cell / width;
+        for (int ny = std::max(0, y - NeighbourReach); ny <= std::min(height - 1, y + NeighbourReach); ++ny)
+            for (int nx = std::max(0, x - NeighbourReach); nx <= std::min(width - 1, x + NeighbourReach); ++nx)
+                m_cellNeighbours.push_back((ny * width) + nx);
+        m_cellNeighbourStart.push_back(static_cast<int>(m_cellNeighbours.size()));
+    }
+
+    //each stone in an open line is worth eight times the last, so one four outweighs
+    //any number of threes the other side could have on a board this size
+    m_weights.assign(inARow + 1, 0);
+    for (int n = 1; n <= inARow; ++n)
+        m_weights[n] = 1 << (3 * (n - 1));
+
+    m_score[0] = m_score[1] = 0;
+    m_completed[0] = m_completed[1] = 0;
+
+    int stride = inARow + 1;
+    m_lineDeltas.resize(stride * stride);
+    for (int own = 0; own < inARow; ++own)
+    {
+        for (int opp = 0; opp <= inARow; ++opp)
+        {
+            LineDelta& delta = m_lineDeltas[(own * stride) + opp];
+            LineValue ours[2] = { getLineValue(own, opp), getLineValue(own + 1, opp) };
+            LineValue theirs[2] = { getLineValue(opp, own), getLineValue(opp, own + 1) };
+            delta.gain[0] = ours[1].gain - ours[0].gain;
+            delta.four[0] = ours[1].four - ours[0].four;
+            delta.three[0] = ours[1].three - ours[0].three;
+            delta.gain[1] = theirs[1].gain - theirs[0].gain;
+            delta.four[1] = theirs[1].four - theirs[0].four;
+            delta.three[1] = theirs[1].three - theirs[0].three;
+            delta.any = delta.gain[0] || delta.gain[1] || delta.four[0] || delta.four[1] || delta.three[0] || delta.three[1];
+        }
+    }
+
+    //every line is open to both sides to start with
+    LineValue open = getLineValue(0, 0);
+    for (int line = 0; line < numLines; ++line)
+    {
+        for (int i = 0; i < inARow; ++i)
+        {
+            CellValue& value = m_cellValues[getLineCell(line, i)];
+            for (int side = 0; side < 2; ++side)
+            {
+                value.gain[side] += open.gain;
+                value.fours[side] += static_cast<uint32_t>(open.four) << (m_lineDirection[line] * 8);
+                value.threes[side] += static_cast<uint32_t>(open.three) << (m_lineDirection[line] * 8);
+            }
+        }
+    }
+    m_candidates.reserve(getNumCells());
+}
+
+void LineBoard::makeMove(int cell, uint8_t side)
+{
+    assert(m_cells[cell] == BoardSnapshot::Empty && side != BoardSnapshot::Empty);
+
+    int mine = side - 1;
+    int theirs = opponentIndex(side);
+    for (int i = m_cellLineStart[cell]; i < m_cellLineStart[cell + 1]; ++i)
+    {
+        int line = m_cellLines[i];
+        int own = m_lineCounts[(line * 2) + mine];
+        int opp = m_lineCounts[(line * 2) + theirs];
+
+        //still ours alone, it's worth more.  Theirs alone until now, it's dead.
+        if (opp == 0)
+            m_score[mine] += m_weights[own + 1] - m_weights[own];
+        else if (own == 0)
+            m_score[theirs] -= m_weights[opp];
+
+        m_lineCounts[(line * 2) + mine] = static_cast<uint8_t>(own + 1);
+        if (own + 1 == m_inARow)
+            ++m_completed[mine];
+        updateCells(line, mine, m_lineDeltas[(own * (m_inARow + 1)) + opp], 1);
+
+        //most lines weren't a threat and still aren't
+        if (m_lineList[line] != NoList || own + 1 >= m_inARow - 2)
+            refile(line);
+    }
+
+    removeCandidate(cell);
+    m_cells[cell] = side;
+    ++m_numStones;
+    m_hash = m_keys.toggle(m_hash, cell, side);
+    countNeighbours(cell, 1);
+}
+
+void LineBoard::unmakeMove(int cell)
+{
+    uint8_t side = m_cells[cell];
+    assert(side != BoardSnapshot::Empty);
+
+    int mine = side - 1;
+    int theirs = opponentIndex(side);
+    for (int i = m_cellLineStart[cell]; i < m_cellLineStart[cell + 1]; ++i)
+    {
+        int line = m_cellLines[i];
+        int own = m_lineCounts[(line * 2) + mine];
+        int opp = m_lineCounts[(line * 2) + theirs];
+
+        if (own == m_inARow)
+            --m_completed[mine];
+        m_lineCounts[(line * 2) + mine] = static_cast<uint8_t>(own - 1);
+        updateCells(line, mine, m_lineDeltas[((own - 1) * (m_inARow + 1)) + opp], -1);
+
+        //the same as making it, backwards
+        if (opp == 0)
+            m_score[mine] -= m_weights[own] - m_weights[own - 1];
+        else if (own == 1)
+            m_score[theirs] += m_weights[opp];
+
+        if (m_lineList[line] != NoList || own - 1 >= m_inARow - 2 || (own == 1 && opp >= m_inARow - 2))
+            refile(line);
+    }
+
+    m_cells[cell] = BoardSnapshot::Empty;
+    --m_numStones;
+    m_hash = m_keys.toggle(m_hash, cell, side);
+    countNeighbours(cell, -1);
+    if (m_neighbours[cell])
+        addCandidate(cell);
+}
+
+uint8_t LineBoard::winner() const
+{
+    if (m_completed[0])
+        return BoardSnapshot::Player;
+    if (m_completed[1])
+        return BoardSnapshot::AI;
+    return BoardSnapshot::Empty;
+}
+
+void LineBoard::getMoveInfo(int cell, uint8_t side, MoveInfo& info) const
+{
+    const CellValue& value = m_cellValues[cell];
+    int mine = side - 1;
+    int theirs = opponentIndex(side);
+    info.gain = value.gain[mine];
+
+    //the windows in one direction overlap, so it's directions that count for threats, not lines.
+    //one bit per direction, ours in the low nibble and theirs in the high one.
+    int fours = directionBits(value.fours[mine]) | (directionBits(value.fours[theirs]) << 4);
+    int threes = directionBits(value.threes[mine]) | (directionBits(value.threes[theirs]) << 4);
+
+    //three in a row makes an empty line a three, but only for whoever's moving
+    if (m_inARow == 3)
+        threes &= 0xf;
+
+    threes &= ~fours;
+    info.fours = countBits(fours & 0xf);
+    info.threes = countBits(threes & 0xf);
+    info.theirFours = countBits(fours >> 4);
+    info.theirThrees = countBits(threes >> 4);
+}
+
+int LineBoard::getEmptyCell(int line) const
+{
+    for (int i = 0; i < m_inARow; ++i)
+    {
+        int cell = getLineCell(line, i);
+        if (m_cells[cell] == BoardSnapshot::Empty)
+            return cell;
+    }
+    return -1;
+}
+
+void LineBoard::refile(int line)
+{
+    int player = m_lineCounts[line * 2];
+    int ai = m_lineCounts[(line * 2) + 1];
+
+    int8_t list = NoList;
+    if (ai == 0 && player == m_inARow - 1)
+        list = PlayerFours;
+    else if (player == 0 && ai == m_inARow - 1)
+        list = AIFours;
+    else if (ai == 0 && player == m_inARow - 2)
+        list = PlayerThrees;
+    else if (player == 0 && ai == m_inARow - 2)
+        list = AIThrees;
+
+    int8_t current = m_lineList[line];
+    if (list == current)
+        return;
+
+    //out of the old one by swapping the last line into its place
+    if (current != NoList)
+    {
+        std::vector<int>& lines = current < PlayerThrees ? m_fours[current] : m_threes[current - PlayerThrees];
+        int moved = lines.back();
+        lines[m_lineSlot[line]] = moved;
+        m_lineSlot[moved] = m_lineSlot[line];
+        lines.pop_back();
+    }
+
+    if (list != NoList)
+    {
+        std::vector<int>& lines = list < PlayerThrees ? m_fours[list] : m_threes[list - PlayerThrees];
+        m_lineSlot[line] = static_cast<int>(lines.size());
+        lines.push_back(line);
+    }
+    m_lineList[line] = list;
+}
+
+LineBoard::LineValue LineBoard::getLineValue(int own, int opp) const
+{
+    //a line only we have stones in gets better, one only they have stones in gets taken off
+    //them, and one we both have stones in (or a finished one) is worth nothing either way
+    LineValue value;
+    value.gain = 0;
+    value.four = 0;
+    value.three = 0;
+    if (opp == 0 && own < m_inARow)
+    {
+        value.gain = m_weights[own + 1] - m_weights[own];
+        value.four = own + 1 == m_inARow - 1;
+        value.three = own + 1 == m_inARow - 2;
+    }
+    else if (own == 0 && opp < m_inARow)
+    {
+        value.gain = m_weights[opp];
+    }
+    return value;
+}
+
+void LineBoard::updateCells(int line, int mine, const LineDelta& delta, int sign)
+{
+    //most moves don't change what a line's worth to the cells in it, it was already dead
+    if (!delta.any)
+        return;
+
+    //the counts wrap, taking one off a byte is adding 0xffffffff shifted up to it
+    int shift = m_lineDirection[line] * 8;
+    int theirs = 1 - mine;
+    int gain[2] = { sign * delta.gain[0], sign * delta.gain[1] };
+    uint32_t four[2] = { static_cast<uint32_t>(sign * delta.four[0]) << shift, static_cast<uint32_t>(sign * delta.four[1]) << shift };
+    uint32_t three[2] = { static_cast<uint32_t>(sign * delta.three[0]) << shift, static_cast<uint32_t>(sign * delta.three[1]) << shift };
+
+    int step = m_lineStep[line];
+    int cell = m_lineStart[line];
+    for (int i = 0; i < m_inARow; ++i, cell += step)
+    {
+        CellValue& value = m_cellValues[cell];
+        value.gain[mine] += gain[0];
+        value.fours[mine] += four[0];
+        value.threes[mine] += three[0];
+        value.gain[theirs] += gain[1];
+        value.fours[theirs] += four[1];
+        value.threes[theirs] += three[1];
+    }
+}
+
+void LineBoard::countNeighbours(int cell, int delta)
+{
+    for (int i = m_cellNeighbourStart[cell]; i < m_cellNeighbourStart[cell + 1]; ++i)
+    {
+        int neighbour = m_cellNeighbours[i];
+        int before = m_neighbours[neighbour];
+        m_neighbours[neighbour] = static_cast<uint8_t>(before + delta);
+
+        //only empty cells are candidates, make and unmake see to the one the stone is on
+        if (m_cells[neighbour] != BoardSnapshot::Empty)
+            continue;
+        if (before == 0)
+            addCandidate(neighbour);
+        else if (before + delta == 0)
+            removeCandidate(neighbour);
+    }
+}
+
+void LineBoard::addCandidate(int cell)
+{
+    if (m_candidateSlot[cell] >= 0)
+        return;
+    m_candidateSlot[cell] = static_cast<int>(m_candidates.size());
+    m_candidates.push_back(cell);
+}
+
+void LineBoard::removeCandidate(int cell)
+{
+    //swap the last one into its place
+    int slot = m_candidateSlot[cell];
+    if (slot < 0)
+        return;
+    int moved = m_candidates.back();
+    m_candidates[slot] = moved;
+    m_candidateSlot[moved] = slot;
+    m_candidates.pop_back();
+    m_candidateSlot[cell] = -1;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+#include "ZobristHash.h"
+
+#include <cinttypes>
+#include <vector>
+
+//a k in a row board of any size (15x15 five in a row, say) that keeps its own evaluation.
+//every run of k cells in any of the four directions is a line, and each line keeps how many
+//stones each side has in it.  A stone only touches the lines through its own cell (4k at most),
+//so making and unmaking a move are a few dozen increments and the evaluation, the winner and
+//the threats are all kept up to date on the way instead of rescanning the board.  So is what a
+//stone on each cell would do (getMoveInfo), and which empty cells are near enough to bother with.
+//a line is worth something to a side only while the other side has nothing in it; the more
+//stones, the more it's worth, and a line one stone short is a four, two short a three.
+//cells are BoardSnapshot cells (Empty, Player, AI), numbered left to right, top to bottom.
+class LineBoard
+{
+public:
+    //inARow has to be 3 or more and fit on the board
+    LineBoard(int width, int height, int inARow);
+
+    int getWidth() const { return m_width; }
+    int getHeight() const { return m_height; }
+    int getInARow() const { return m_inARow; }
+    int getNumCells() const { return m_width * m_height; }
+    int getNumStones() const { return m_numStones; }
+    bool isFull() const { return m_numStones == getNumCells(); }
+
+    uint8_t at(int cell) const { return m_cells[cell]; }
+
+    //the cell has to be empty
+    void makeMove(int cell, uint8_t side);
+
+    //takes whatever's on the cell back off
+    void unmakeMove(int cell);
+
+    //whoever has a whole line, Empty if nobody does (yet)
+    uint8_t winner() const;
+
+    //from side's point of view, what its open lines are worth less what the other side's are
+    int evaluate(uint8_t side) const { return m_score[side - 1] - m_score[opponentIndex(side)]; }
+
+    //what a stone of side's on an empty cell would do.  Kept per cell as the lines through it change,
+    //so this is a lookup.
+    struct MoveInfo
+    {
+        int gain;           //added to side's lines plus taken from the other side's
+        int fours;          //directions it makes a four for side in
+        int threes;         //directions it makes a three in, not counting the ones with a four
+        int theirFours;     //the same for the other side if they went there instead
+        int theirThrees;
+    };
+
+    void getMoveInfo(int cell, uint8_t side, MoveInfo& info) const;
+
+    //lines where side is one stone short and the other side has nothing, with the empty cell in each
+    int getNumFours(uint8_t side) const { return static_cast<int>(m_fours[side - 1].size()); }
+    int getFourCell(uint8_t side, int i) const { return getEmptyCell(m_fours[side - 1][i]); }
+
+    //same, two short.  The cells are the line's empties, writing each one makes a four.
+    int getNumThrees(uint8_t side) const { return static_cast<int>(m_threes[side - 1].size()); }
+    int getThreeLine(uint8_t side, int i) const { return m_threes[side - 1][i]; }
+    int getLineCell(int line, int i) const { return m_lineStart[line] + (i * m_lineStep[line]); }
+
+    //true if there's a stone within two cells of this one, the only cells worth trying
+    bool hasNeighbour(int cell) const { return m_neighbours[cell] != 0; }
+
+    //the empty cells that have one, in no particular order.  Empty on an empty board.
+    int getNumCandidates() const { return static_cast<int>(m_candidates.size()); }
+    int getCandidate(int i) const { return m_candidates[i]; }
+
+    //zobrist, kept up to date by make and unmake
+    uint64_t getHash() const { return m_hash; }
+
+protected:
+    static int opponentIndex(uint8_t side) { return side == BoardSnapshot::Player ? 1 : 0; }
+
+    int getEmptyCell(int line) const;
+
+    //puts a line in the four or three list it belongs in now, if any
+    void refile(int line);
+
+    //what one line does for a stone of a side with own of theirs and opp of the other's in it
+    struct LineValue
+    {
+        int gain;
+        int four;       //1 if it makes a four of the line
+        int three;
+    };
+
+    LineValue getLineValue(int own, int opp) const;
+
+    //what a stone going on a line with own of ours and opp of theirs does to what each of its
+    //cells is worth to us ([0]) and them ([1]).  Taking it off is the same, backwards.
+    struct LineDelta
+    {
+        int gain[2];
+        int four[2];
+        int three[2];
+        bool any;
+    };
+
+    //a line's cells, for both sides, get delta times sign added on.  mine is the side of
+    //the stone that's going on or coming off.
+    void updateCells(int line, int mine, const LineDelta& delta, int sign);
+
+    void countNeighbours(int cell, int delta);
+    void addCandidate(int cell);
+    void removeCandidate(int cell);
+
+    int m_width;
+    int m_height;
+    int m_inARow;
+    int m_numStones;
+
+    std::vector<uint8_t> m_cells;
+
+    //every line is k cells from start, step apart, in one direction (0-3)
+    std::vector<int> m_lineStart;
+    std::vector<int> m_lineStep;
+    std::vector<uint8_t> m_lineDirection;
+
+    //the lines through each cell: m_cellLines[m_cellLineStart[cell]] up to the next cell's start
+    std::vector<int> m_cellLineStart;
+    std::vector<int> m_cellLines;
+
+    std::vector<uint8_t> m_lineCounts;  //line * 2 + side - 1
+
+    //what an open line with n stones in it is worth, n = 0 to k
+    std::vector<int> m_weights;
+
+    std::vector<LineDelta> m_lineDeltas;    //by own * (k + 1) + opp
+
+    int m_score[2];
+    int m_completed[2];                 //lines a side has filled, more than 0 is a win
+
+    //which list a line is in (-1 for none) and where, so moving it is O(1)
+    std::vector<int8_t> m_lineList;
+    std::vector<int> m_lineSlot;
+    std::vector<int> m_fours[2];
+    std::vector<int> m_threes[2];
+
+    //getMoveInfo's answers by cell and side - 1: the gain, and how many lines a stone would
+    //make a four or a three of, one byte per direction.  Occupied cells keep counting, nobody
+    //asks about them.
+    struct CellValue
+    {
+        int gain[2];
+        uint32_t fours[2];
+        uint32_t threes[2];
+    };
+
+    std::vector<CellValue> m_cellValues;
+
+    std::vector<uint8_t> m_neighbours;  //stones within two cells
+    std::vector<int> m_cellNeighbourStart;
+    std::vector<int> m_cellNeighbours;
+
+    //empty cells with a neighbour, and where each is in the list (-1 if it isn't)
+    std::vector<int> m_candidates;
+    std::vector<int> m_candidateSlot;
+
+    ZobristHash m_keys;
+    uint64_t m_hash;
+};
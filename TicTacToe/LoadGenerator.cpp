@@ -0,0 +1,494 @@
+#include "LoadGenerator.h"
+#include "GameServer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const size_t ReceiveBufferSize = 4096;
+    const int MaxEventsPerWait = 1024;
+    const int ConnectTimeoutSeconds = 30;
+}
+
+struct LoadGenerator::Client
+{
+    Client(NetSocket socket, uint32_t gameId, bool spectator) : socket(socket), gameId(gameId), spectator(spectator), connected(false), wantWrite(true), awaitingReply(false), dead(false), inUsed(0)
+    {
+        out.reserve(64);
+    }
+
+    NetSocket socket;
+    uint32_t gameId;
+    bool spectator;
+    BoardSnapshot board;
+
+    bool connected;
+    bool wantWrite;
+    bool awaitingReply;
+    bool dead;
+
+    Clock::time_point sentAt;
+
+    uint8_t inBuffer[ReceiveBufferSize];
+    size_t inUsed;
+
+    std::vector<uint8_t> out;
+};
+
+LoadGenerator::LoadGenerator(const Options& options) : m_options(options),
+    m_measuring(false),
+    m_moves(0),
+    m_games(0),
+    m_rejected(0),
+    m_spectatorUpdates(0),
+    m_serverDeliveries(0),
+    m_serverFlushNanos(0),
+    m_serverSnapshotFallbacks(0),
+    m_scoreStats(),
+    m_positionCacheStats(),
+    m_measuredSeconds(0.0),
+    m_connected(0),
+    m_connecting(0),
+    m_rngState(0x9e3779b9u)
+{
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    for (auto&& client : m_clients)
+        if (!client->dead)
+            NetPoller::closeSocket(client->socket);
+}
+
+bool LoadGenerator::run()
+{
+    //both ends of every connection live in this process when we host the server ourselves
+    NetPoller::raiseFileLimit(static_cast<size_t>(m_options.clients + m_options.spectators) * 2 + 256);
+
+    std::unique_ptr<GameServer> server;
+    std::thread serverThread;
+    uint16_t port = m_options.port;
+
+    if (!port)
+    {
+        GameServer::Options serverOptions;
+        serverOptions.port = 0;
+        serverOptions.loopbackOnly = true;
+        serverOptions.aiType = m_options.aiType;
+        serverOptions.tickMicros = m_options.tickMicros;
+        serverOptions.scorePath = m_options.scorePath;
+
+        server.reset(new GameServer(serverOptions));
+        if (!server->start())
+            return false;
+
+        port = server->getPort();
+        GameServer* serverPtr = server.get();
+        serverThread = std::thread([serverPtr]() {
+            serverPtr->run();
+        });
+    }
+
+    bool connected = connectClients(port);
+
+    if (connected)
+    {
+        //clients start playing as soon as they're joined, let things settle before we count
+        auto warmupEnd = Clock::now() + std::chrono::seconds(m_options.warmupSeconds);
+        while (Clock::now() < warmupEnd)
+            pump(10);
+
+        m_moves = 0;
+        m_games = 0;
+        m_rejected = 0;
+        m_spectatorUpdates = 0;
+        m_latency.reset();
+        m_measuring = true;
+
+        GameServer::Stats before;
+        ScoreStore::Stats scoresBefore = m_scoreStats;
+        if (server)
+            before = server->getStats();
+        if (server && server->getScoreStore())
+            scoresBefore = server->getScoreStore()->getStats();
+        PositionCache::Stats cacheBefore = AIStrategy::getPositionCache().getStats();
+
+        auto start = Clock::now();
+        auto end = start + std::chrono::seconds(m_options.seconds);
+        while (Clock::now() < end)
+            pump(10);
+
+        m_measuring = false;
+        m_measuredSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        if (server)
+        {
+            GameServer::Stats after = server->getStats();
+            m_serverDeliveries = after.deliveries - before.deliveries;
+            m_serverFlushNanos = after.flushNanos - before.flushNanos;
+            m_serverSnapshotFallbacks = after.snapshotFallbacks - before.snapshotFallbacks;
+
+            //the server's AI runs in this process, so it's the same cache
+            PositionCache::Stats cacheAfter = AIStrategy::getPositionCache().getStats();
+            m_positionCacheStats.lookups = cacheAfter.lookups - cacheBefore.lookups;
+            m_positionCacheStats.hits = cacheAfter.hits - cacheBefore.hits;
+            m_positionCacheStats.stores = cacheAfter.stores - cacheBefore.stores;
+            m_positionCacheStats.replacements = cacheAfter.replacements - cacheBefore.replacements;
+            m_positionCacheStats.rejected = cacheAfter.rejected - cacheBefore.rejected;
+            m_positionCacheStats.sampledLookups = cacheAfter.sampledLookups - cacheBefore.sampledLookups;
+            m_positionCacheStats.sampledNanos = cacheAfter.sampledNanos - cacheBefore.sampledNanos;
+        }
+
+        if (server && server->getScoreStore())
+        {
+            ScoreStore::Stats scoresAfter = server->getScoreStore()->getStats();
+            m_scoreStats = scoresAfter;
+            m_scoreStats.results = scoresAfter.results - scoresBefore.results;
+            m_scoreStats.commits = scoresAfter.commits - scoresBefore.commits;
+            m_scoreStats.logBytes = scoresAfter.logBytes - scoresBefore.logBytes;
+            m_scoreStats.snapshots = scoresAfter.snapshots - scoresBefore.snapshots;
+            m_scoreStats.snapshotBytes = scoresAfter.snapshotBytes - scoresBefore.snapshotBytes;
+        }
+    }
+
+    if (server)
+    {
+        server->stop();
+        serverThread.join();
+    }
+
+    return connected;
+}
+
+bool LoadGenerator::connectClients(uint16_t port)
+{
+    int total = m_options.clients + m_options.spectators;
+    m_clients.reserve(total);
+
+    auto giveUp = Clock::now() + std::chrono::seconds(ConnectTimeoutSeconds);
+    int started = 0;
+
+    while (m_connected < total && Clock::now() < giveUp)
+    {
+        while (started < total && m_connecting < m_options.maxConnecting)
+        {
+            NetSocket socket = NetPoller::connectTcp(m_options.host.c_str(), port);
+            if (socket == InvalidNetSocket)
+                return false;
+
+            //one game per client, the server AI is the opponent.  Spectators all pile onto game 1.
+            bool spectator = started >= m_options.clients;
+            uint32_t gameId = spectator ? 1 : static_cast<uint32_t>(started + 1);
+
+            std::unique_ptr<Client> client(new Client(socket, gameId, spectator));
+            writeJoinGame(client->out, client->gameId, spectator ? WireSeatSpectator : WireSeatPlayer);
+
+            m_poller.add(socket, client.get());
+            m_poller.setWantWrite(socket, client.get(), true);
+            m_clients.push_back(std::move(client));
+
+            ++started;
+            ++m_connecting;
+        }
+
+        pump(10);
+    }
+
+    return m_connected == total;
+}
+
+void LoadGenerator::pump(int timeoutMs)
+{
+    NetPoller::Event events[MaxEventsPerWait];
+    int numEvents = m_poller.wait(events, MaxEventsPerWait, timeoutMs);
+
+    for (int i = 0; i < numEvents; ++i)
+    {
+        Client* client = static_cast<Client*>(events[i].userData);
+        if (client->dead)
+            continue;
+
+        if (events[i].closed && !events[i].readable)
+        {
+            dropClient(client);
+            continue;
+        }
+
+        if (events[i].writable)
+        {
+            if (!client->connected)
+            {
+                client->connected = true;
+                ++m_connected;
+                --m_connecting;
+            }
+            flushClient(client);
+        }
+
+        if (events[i].readable && !client->dead)
+            readClient(client);
+    }
+}
+
+void LoadGenerator::readClient(Client* client)
+{
+    while (!client->dead)
+    {
+        int received = NetPoller::recvSome(client->socket, client->inBuffer + client->inUsed, ReceiveBufferSize - client->inUsed);
+        if (received < 0)
+        {
+            dropClient(client);
+            return;
+        }
+        if (received == 0)
+            return;
+
+        client->inUsed += received;
+
+        size_t offset = 0;
+        WireMessage msg;
+        while (offset < client->inUsed)
+        {
+            int used = readWireMessage(client->inBuffer + offset, client->inUsed - offset, msg);
+            if (used < 0)
+            {
+                dropClient(client);
+                return;
+            }
+            if (used == 0)
+                break;
+
+            offset += used;
+            handleMessage(client, msg);
+        }
+
+        memmove(client->inBuffer, client->inBuffer + offset, client->inUsed - offset);
+        client->inUsed -= offset;
+    }
+}
+
+void LoadGenerator::handleMessage(Client* client, const WireMessage& msg)
+{
+    BoardSnapshot& board = client->board;
+
+    //anything older than what we've already seen is a leftover from before our snapshot
+    bool stale = (msg.type == WireMoveDelta || msg.type == WireGameOver) && msg.generation <= board.generation;
+    if (stale)
+        return;
+
+    if (client->spectator && m_measuring && (msg.type == WireMoveDelta || msg.type == WireGameOver))
+        ++m_spectatorUpdates;
+
+    bool replied = false;
+
+    switch (msg.type)
+    {
+    case WireSnapshot:
+        for (int i = 0; i < 9; ++i)
+            board.cells[i] = msg.cells[i];
+        board.usersTurn = msg.usersTurn;
+        board.generation = msg.generation;
+
+        //a snapshot after we've joined means the server gave up on us falling behind,
+        //whatever we were waiting for went with it
+        client->awaitingReply = false;
+        break;
+    case WireMoveDelta:
+        board.cells[msg.cell] = msg.owner;
+        board.usersTurn = msg.owner == BoardSnapshot::AI;
+        board.generation = msg.generation;
+        replied = msg.owner == BoardSnapshot::AI;
+        break;
+    case WireGameOver:
+        board = BoardSnapshot();
+        board.generation = msg.generation;
+        replied = true;
+        if (m_measuring && !client->spectator)
+            ++m_games;
+        break;
+    case WireMoveRejected:
+        //shouldn't happen with one client per game, but don't stall if it does
+        ++m_rejected;
+        client->awaitingReply = false;
+        break;
+    default:
+        break;
+    }
+
+    if (replied && client->awaitingReply)
+    {
+        client->awaitingReply = false;
+        if (m_measuring)
+        {
+            ++m_moves;
+            m_latency.record(Clock::now() - client->sentAt);
+        }
+    }
+
+    //a finished board waits for its GameOver before we play again
+    if (!client->spectator && board.usersTurn && !client->awaitingReply && !board.isGameOver())
+        sendMove(client);
+}
+
+void LoadGenerator::sendMove(Client* client)
+{
+    int freeCells[9];
+    int numFree = 0;
+    for (int cell = 0; cell < 9; ++cell)
+        if (client->board.cells[cell] == BoardSnapshot::Empty)
+            freeCells[numFree++] = cell;
+
+    if (!numFree)
+        return;
+
+    //xorshift, we just need something cheap that isn't always the same square
+    m_rngState ^= m_rngState << 13;
+    m_rngState ^= m_rngState >> 17;
+    m_rngState ^= m_rngState << 5;
+
+    writeMakeMove(client->out, client->gameId, static_cast<uint8_t>(freeCells[m_rngState % numFree]));
+    client->sentAt = Clock::now();
+    client->awaitingReply = true;
+    flushClient(client);
+}
+
+void LoadGenerator::flushClient(Client* client)
+{
+    if (!client->connected)
+        return;
+
+    if (!client->out.empty())
+    {
+        NetBuffer buffer;
+        buffer.data = client->out.data();
+        buffer.size = client->out.size();
+
+        int64_t sent = NetPoller::sendGather(client->socket, &buffer, 1);
+        if (sent < 0)
+        {
+            dropClient(client);
+            return;
+        }
+        client->out.erase(client->out.begin(), client->out.begin() + static_cast<size_t>(sent));
+    }
+
+    bool wantWrite = !client->out.empty();
+    if (wantWrite != client->wantWrite)
+    {
+        client->wantWrite = wantWrite;
+        m_poller.setWantWrite(client->socket, client, wantWrite);
+    }
+}
+
+void LoadGenerator::dropClient(Client* client)
+{
+    if (client->dead)
+        return;
+
+    client->dead = true;
+    if (client->connected)
+        --m_connected;
+    else
+        --m_connecting;
+
+    m_poller.remove(client->socket);
+    NetPoller::closeSocket(client->socket);
+}
+
+int LoadGenerator::runFromCommandLine(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--clients" && hasValue)
+            options.clients = atoi(argv[++i]);
+        else if (arg == "--spectators" && hasValue)
+            options.spectators = atoi(argv[++i]);
+        else if (arg == "--seconds" && hasValue)
+            options.seconds = atoi(argv[++i]);
+        else if (arg == "--port" && hasValue)
+            options.port = static_cast<uint16_t>(atoi(argv[++i]));
+        else if (arg == "--host" && hasValue)
+            options.host = argv[++i];
+        else if (arg == "--ai" && hasValue)
+            AIStrategy::parseType(argv[++i], options.aiType);
+        else if (arg == "--tick-us" && hasValue)
+            options.tickMicros = atoi(argv[++i]);
+        else if (arg == "--scores" && hasValue)
+            options.scorePath = argv[++i];
+    }
+
+    if (!NetPoller::startup())
+        return 1;
+
+    LoadGenerator generator(options);
+    if (!generator.run())
+    {
+        fprintf(stderr, "only %d of %d clients connected\n", generator.getConnectedClients(), options.clients + options.spectators);
+        return 1;
+    }
+
+    const LatencyHistogram& latency = generator.getLatency();
+    printf("clients %d | %.1fs | moves %llu (%.0f/s) | games %llu | rejected %llu\n",
+        generator.getConnectedClients(),
+        generator.getMeasuredSeconds(),
+        (unsigned long long)generator.getMoves(),
+        generator.getMoves() / generator.getMeasuredSeconds(),
+        (unsigned long long)generator.getGames(),
+        (unsigned long long)generator.getRejected());
+    printf("move -> reply latency: %s\n", latency.toString().c_str());
+
+    const ScoreStore::Stats& scores = generator.getScoreStats();
+    if (scores.results)
+    {
+        //two results per game, one for each side
+        printf("scores: %llu results (%.0f games/s) | %llu commits, %.1f results each | %llu log + %llu snapshot bytes | write amplification %.3f\n",
+            (unsigned long long)scores.results,
+            scores.results / 2 / generator.getMeasuredSeconds(),
+            (unsigned long long)scores.commits,
+            scores.commits ? double(scores.results) / scores.commits : 0.0,
+            (unsigned long long)scores.logBytes,
+            (unsigned long long)scores.snapshotBytes,
+            scores.getWriteAmplification());
+    }
+
+    const PositionCache::Stats& cache = generator.getPositionCacheStats();
+    if (cache.lookups)
+    {
+        printf("position cache: %llu lookups, %.1f%% hits | %.0f ns mean lookup | %llu stores, %llu replacements, %llu rejected | %llu of %llu slots used\n",
+            (unsigned long long)cache.lookups,
+            cache.getHitRate() * 100.0,
+            cache.getMeanLookupNanos(),
+            (unsigned long long)cache.stores,
+            (unsigned long long)cache.replacements,
+            (unsigned long long)cache.rejected,
+            (unsigned long long)AIStrategy::getPositionCache().getNumEntries(),
+            (unsigned long long)AIStrategy::getPositionCache().getCapacity());
+    }
+
+    if (options.spectators)
+    {
+        printf("spectators %d | updates seen %llu (%.0f/s per viewer)\n",
+            options.spectators,
+            (unsigned long long)generator.getSpectatorUpdates(),
+            generator.getSpectatorUpdates() / generator.getMeasuredSeconds() / options.spectators);
+
+        //flush time covers the sends too, so this is the whole server side cost of one viewer seeing one batch
+        if (generator.getServerDeliveries())
+        {
+            printf("fan-out: %llu deliveries | %.0f ns per viewer per batch | snapshot fallbacks %llu\n",
+                (unsigned long long)generator.getServerDeliveries(),
+                double(generator.getServerFlushNanos()) / generator.getServerDeliveries(),
+                (unsigned long long)generator.getServerSnapshotFallbacks());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "AIStrategy.h"
+#include "LatencyHistogram.h"
+#include "NetPoller.h"
+#include "ScoreStore.h"
+#include "WireProtocol.h"
+
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <vector>
+
+//loopback load test for GameServer.  Opens a pile of client connections, each one playing
+//its own game against the server AI as fast as the replies come back, and measures moves/sec
+//and move -> reply latency.  Spins up its own server on another thread unless pointed at one.
+//with spectators it also measures fan-out: that many extra connections all watch game 1, and
+//we report what each delivered update costs the server per viewer.
+class LoadGenerator
+{
+public:
+    struct Options
+    {
+        Options() : host("127.0.0.1"), port(0), clients(10000), spectators(0), seconds(10), warmupSeconds(2), aiType(AIStrategy::FirstFree), tickMicros(1000), maxConnecting(1000) {}
+
+        std::string host;
+        uint16_t port;          //0 runs an in-process server
+        int clients;
+        int spectators;         //watchers on game 1, on top of the clients
+        int seconds;
+        int warmupSeconds;
+        AIStrategy::Type aiType; //only used by the in-process server
+        int tickMicros;          //same
+        int maxConnecting;       //connects in flight at once, so we don't overrun the accept backlog
+        std::string scorePath;   //in-process server only, persist every finished game there
+    };
+
+    LoadGenerator(const Options& options = Options());
+    ~LoadGenerator();
+
+    //connects, warms up, measures.  False if the clients couldn't get going.
+    bool run();
+
+    uint64_t getMoves() const { return m_moves; }
+    uint64_t getGames() const { return m_games; }
+    uint64_t getRejected() const { return m_rejected; }
+    double getMeasuredSeconds() const { return m_measuredSeconds; }
+    int getConnectedClients() const { return m_connected; }
+
+    //everything the spectators got while measuring
+    uint64_t getSpectatorUpdates() const { return m_spectatorUpdates; }
+
+    //from the in-process server, zero when we're pointed at somebody else's
+    uint64_t getServerDeliveries() const { return m_serverDeliveries; }
+    uint64_t getServerFlushNanos() const { return m_serverFlushNanos; }
+    uint64_t getServerSnapshotFallbacks() const { return m_serverSnapshotFallbacks; }
+
+    //what the in-process server's score store did while measuring, all zero without --scores
+    const ScoreStore::Stats& getScoreStats() const { return m_scoreStats; }
+
+    //the AI's shared position cache over the measured window, zeroed if the server's somewhere else
+    const PositionCache::Stats& getPositionCacheStats() const { return m_positionCacheStats; }
+    const LatencyHistogram& getLatency() const { return m_latency; }
+
+    //--loadgen [--clients N] [--spectators N] [--seconds N] [--port N] [--host addr] [--ai name] [--tick-us N] [--scores path]
+    static int runFromCommandLine(int argc, char* argv[]);
+
+protected:
+    struct Client;
+
+    bool connectClients(uint16_t port);
+    void pump(int timeoutMs);
+    void readClient(Client* client);
+    void handleMessage(Client* client, const WireMessage& msg);
+    void sendMove(Client* client);
+    void flushClient(Client* client);
+    void dropClient(Client* client);
+
+    Options m_options;
+    NetPoller m_poller;
+
+    std::vector<std::unique_ptr<Client>> m_clients;
+
+    bool m_measuring;
+    uint64_t m_moves;
+    uint64_t m_games;
+    uint64_t m_rejected;
+    uint64_t m_spectatorUpdates;
+    uint64_t m_serverDeliveries;
+    uint64_t m_serverFlushNanos;
+    uint64_t m_serverSnapshotFallbacks;
+    ScoreStore::Stats m_scoreStats;
+    PositionCache::Stats m_positionCacheStats;
+    double m_measuredSeconds;
+    int m_connected;
+    int m_connecting;
+
+    LatencyHistogram m_latency;
+
+    uint32_t m_rngState;
+};
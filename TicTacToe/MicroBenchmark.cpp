@@ -0,0 +1,300 @@
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <regex>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace
+{
+    //past this a benchmark is fast enough, more iterations won't tell us anything
+    const uint64_t MaxIterations = 1000000000;
+
+    int64_t wallNanos()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    //CPU time of the calling thread only
+    int64_t threadCpuNanos()
+    {
+#ifdef _WIN32
+        FILETIME creation, exit, kernel, user;
+        if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+            return 0;
+        uint64_t ticks = ((uint64_t(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) + ((uint64_t(user.dwHighDateTime) << 32) | user.dwLowDateTime);
+        return static_cast<int64_t>(ticks * 100);
+#else
+        timespec now;
+        if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) != 0)
+            return 0;
+        return (int64_t(now.tv_sec) * 1000000000) + now.tv_nsec;
+#endif
+    }
+
+    std::string escapeJson(const std::string& text)
+    {
+        std::string escaped;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                escaped.push_back('\\');
+            escaped.push_back(c);
+        }
+        return escaped;
+    }
+}
+
+MicroBenchmark::State::State(uint64_t iterations, int64_t arg) : m_iterations(iterations),
+    m_done(0),
+    m_arg(arg),
+    m_started(false),
+    m_running(false),
+    m_finished(false),
+    m_wallStart(0),
+    m_cpuStart(0),
+    m_wallNanos(0),
+    m_cpuNanos(0),
+    m_items(0)
+{
+}
+
+bool MicroBenchmark::State::keepRunning()
+{
+    if (!m_started)
+    {
+        m_started = true;
+        startTimer();
+    }
+
+    if (m_done < m_iterations && m_error.empty())
+    {
+        ++m_done;
+        return true;
+    }
+
+    stopTimer();
+    m_finished = true;
+    return false;
+}
+
+void MicroBenchmark::State::pauseTiming()
+{
+    stopTimer();
+}
+
+void MicroBenchmark::State::resumeTiming()
+{
+    startTimer();
+}
+
+void MicroBenchmark::State::setCounter(const std::string& name, double value)
+{
+    for (auto&& counter : m_counters)
+    {
+        if (counter.first == name)
+        {
+            counter.second = value;
+            return;
+        }
+    }
+    m_counters.push_back(std::make_pair(name, value));
+}
+
+void MicroBenchmark::State::skipWithError(const std::string& message)
+{
+    m_error = message;
+}
+
+void MicroBenchmark::State::startTimer()
+{
+    if (m_running)
+        return;
+    m_running = true;
+    m_wallStart = wallNanos();
+    m_cpuStart = threadCpuNanos();
+}
+
+void MicroBenchmark::State::stopTimer()
+{
+    if (!m_running)
+        return;
+    m_running = false;
+    m_cpuNanos += threadCpuNanos() - m_cpuStart;
+    m_wallNanos += wallNanos() - m_wallStart;
+}
+
+MicroBenchmark::Options MicroBenchmark::parseCommandLine(int argc, char* argv[], int first)
+{
+    Options options;
+    for (int i = first; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "--json" && hasValue)
+            options.jsonPath = argv[++i];
+        else if (arg == "--min-time" && hasValue)
+            options.minSeconds = atof(argv[++i]);
+    }
+    return options;
+}
+
+void MicroBenchmark::add(const std::string& name, Function function)
+{
+    Benchmark benchmark;
+    benchmark.name = name;
+    benchmark.function = function;
+    benchmark.arg = 0;
+    m_benchmarks.push_back(benchmark);
+}
+
+void MicroBenchmark::add(const std::string& name, Function function, const std::vector<int64_t>& args)
+{
+    for (auto arg : args)
+    {
+        Benchmark benchmark;
+        benchmark.name = name + "/" + std::to_string(arg);
+        benchmark.function = function;
+        benchmark.arg = arg;
+        m_benchmarks.push_back(benchmark);
+    }
+}
+
+MicroBenchmark::Result MicroBenchmark::runOne(const Benchmark& benchmark, const Options& options)
+{
+    Result result;
+    result.name = benchmark.name;
+
+    uint64_t iterations = 1;
+    while (true)
+    {
+        State state(iterations, benchmark.arg);
+        benchmark.function(state);
+
+        if (!state.m_error.empty() || !state.m_finished)
+        {
+            result.error = state.m_error.empty() ? "the benchmark never finished its keepRunning() loop" : state.m_error;
+            return result;
+        }
+
+        double seconds = state.m_wallNanos / 1e9;
+        if (seconds >= options.minSeconds || iterations >= MaxIterations)
+        {
+            result.iterations = iterations;
+            result.realNanos = double(state.m_wallNanos) / iterations;
+            result.cpuNanos = double(state.m_cpuNanos) / iterations;
+            result.itemsPerSecond = state.m_items && seconds > 0.0 ? state.m_items / seconds : 0.0;
+            result.counters = state.m_counters;
+            return result;
+        }
+
+        //aim a bit past the minimum so the next run is the last, but don't jump more than 10x
+        //off a run too short to say much
+        double multiplier = 10.0;
+        if (seconds > options.minSeconds / 10.0)
+            multiplier = std::min(10.0, (options.minSeconds * 1.4) / seconds);
+        iterations = std::min(MaxIterations, std::max(iterations + 1, static_cast<uint64_t>(iterations * multiplier)));
+    }
+}
+
+std::vector<MicroBenchmark::Result> MicroBenchmark::run(const Options& options)
+{
+    std::regex filter(options.filter.empty() ? ".*" : options.filter);
+
+    size_t nameWidth = 10;
+    for (auto&& benchmark : m_benchmarks)
+        nameWidth = std::max(nameWidth, benchmark.name.size());
+
+    std::string rule(nameWidth + 46, '-');
+    printf("%s\n%-*s %13s %13s %12s\n%s\n", rule.c_str(), static_cast<int>(nameWidth), "Benchmark", "Time", "CPU", "Iterations", rule.c_str());
+    fflush(stdout);
+
+    std::vector<Result> results;
+    for (auto&& benchmark : m_benchmarks)
+    {
+        if (!std::regex_search(benchmark.name, filter))
+            continue;
+
+        Result result = runOne(benchmark, options);
+        results.push_back(result);
+
+        if (!result.error.empty())
+        {
+            printf("%-*s ERROR: %s\n", static_cast<int>(nameWidth), result.name.c_str(), result.error.c_str());
+            fflush(stdout);
+            continue;
+        }
+
+        printf("%-*s %10.0f ns %10.0f ns %12llu", static_cast<int>(nameWidth), result.name.c_str(), result.realNanos, result.cpuNanos, (unsigned long long)result.iterations);
+        if (result.itemsPerSecond > 0.0)
+            printf(" items_per_second=%.4g/s", result.itemsPerSecond);
+        for (auto&& counter : result.counters)
+            printf(" %s=%.4g", counter.first.c_str(), counter.second);
+        printf("\n");
+        fflush(stdout);
+    }
+    return results;
+}
+
+bool MicroBenchmark::writeJson(const std::string& path, const std::vector<Result>& results, const std::string& executable)
+{
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+#ifdef _DEBUG
+    const char* buildType = "debug";
+#else
+    const char* buildType = "release";
+#endif
+
+    fprintf(file, "{\n  \"context\": {\n");
+    fprintf(file, "    \"date\": \"%s\",\n", date);
+    fprintf(file, "    \"executable\": \"%s\",\n", escapeJson(executable).c_str());
+    fprintf(file, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(file, "    \"library_build_type\": \"%s\"\n", buildType);
+    fprintf(file, "  },\n  \"benchmarks\": [");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& result = results[i];
+        fprintf(file, "%s\n    {\n", i ? "," : "");
+        fprintf(file, "      \"name\": \"%s\",\n", escapeJson(result.name).c_str());
+        fprintf(file, "      \"run_name\": \"%s\",\n", escapeJson(result.name).c_str());
+        fprintf(file, "      \"run_type\": \"iteration\",\n");
+        if (!result.error.empty())
+        {
+            fprintf(file, "      \"error_occurred\": true,\n");
+            fprintf(file, "      \"error_message\": \"%s\"\n    }", escapeJson(result.error).c_str());
+            continue;
+        }
+
+        fprintf(file, "      \"iterations\": %llu,\n", (unsigned long long)result.iterations);
+        fprintf(file, "      \"real_time\": %.6g,\n", result.realNanos);
+        fprintf(file, "      \"cpu_time\": %.6g,\n", result.cpuNanos);
+        if (result.itemsPerSecond > 0.0)
+            fprintf(file, "      \"items_per_second\": %.6g,\n", result.itemsPerSecond);
+        for (auto&& counter : result.counters)
+            fprintf(file, "      \"%s\": %.6g,\n", escapeJson(counter.first).c_str(), counter.second);
+        fprintf(file, "      \"time_unit\": \"ns\"\n    }");
+    }
+
+    fprintf(file, "\n  ]\n}\n");
+    return fclose(file) == 0;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cinttypes>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+//a small microbenchmark runner in the style of Google Benchmark, so the numbers (and the JSON)
+//read the same as everybody else's.  A benchmark is a function that loops on keepRunning();
+//we keep doubling (or so) the iterations until a run lasts long enough to trust, then report
+//time and CPU time per iteration.  CPU time is the thread that called keepRunning, so a
+//benchmark can hand its loop to another thread (say, as a graphics task) and still get that
+//thread's CPU time and not its own.
+class MicroBenchmark
+{
+public:
+    class State
+    {
+    public:
+        //true until we've done the iterations asked for.  The clock starts on the first call.
+        bool keepRunning();
+
+        //for setup and teardown inside the loop that shouldn't be counted
+        void pauseTiming();
+        void resumeTiming();
+
+        //the argument this run was registered with, 0 if none
+        int64_t getArg() const { return m_arg; }
+        uint64_t getIterations() const { return m_iterations; }
+
+        //reported as items_per_second, over wall time
+        void setItemsProcessed(uint64_t items) { m_items = items; }
+
+        //anything else worth keeping, goes in the report and the JSON as is
+        void setCounter(const std::string& name, double value);
+
+        //gives up on this benchmark, it's reported as an error instead of a time
+        void skipWithError(const std::string& message);
+
+    protected:
+        friend class MicroBenchmark;
+
+        State(uint64_t iterations, int64_t arg);
+
+        void startTimer();
+        void stopTimer();
+
+        uint64_t m_iterations;
+        uint64_t m_done;
+        int64_t m_arg;
+        bool m_started;
+        bool m_running;
+        bool m_finished;
+
+        int64_t m_wallStart;
+        int64_t m_cpuStart;
+        int64_t m_wallNanos;
+        int64_t m_cpuNanos;
+
+        uint64_t m_items;
+        std::vector<std::pair<std::string, double>> m_counters;
+        std::string m_error;
+    };
+
+    typedef std::function<void(State&)> Function;
+
+    struct Options
+    {
+        Options() : minSeconds(0.5) {}
+
+        double minSeconds;      //a run has to last this long before we believe it
+        std::string filter;     //regex on the name, empty runs everything
+        std::string jsonPath;   //where the JSON goes, empty for none
+    };
+
+    struct Result
+    {
+        Result() : iterations(0), realNanos(0.0), cpuNanos(0.0), itemsPerSecond(0.0) {}
+
+        std::string name;
+        uint64_t iterations;
+        double realNanos;       //per iteration
+        double cpuNanos;        //same
+        double itemsPerSecond;  //0 if the benchmark didn't say
+        std::vector<std::pair<std::string, double>> counters;
+        std::string error;
+    };
+
+    //[--filter regex] [--json path] [--min-time seconds], from argv[first] on
+    static Options parseCommandLine(int argc, char* argv[], int first);
+
+    void add(const std::string& name, Function function);
+
+    //one benchmark per arg, named name/arg
+    void add(const std::string& name, Function function, const std::vector<int64_t>& args);
+
+    //runs everything that matches, printing a line for each as it finishes
+    std::vector<Result> run(const Options& options);
+
+    //Google Benchmark's format: a context block and a "benchmarks" array
+    static bool writeJson(const std::string& path, const std::vector<Result>& results, const std::string& executable);
+
+protected:
+    struct Benchmark
+    {
+        std::string name;
+        Function function;
+        int64_t arg;
+    };
+
+    Result runOne(const Benchmark& benchmark, const Options& options);
+
+    std::vector<Benchmark> m_benchmarks;
+};
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+
+#include <cinttypes>
+#include <type_traits>
+
+//this is the data struct we'll use to define a "move"
+//x and y position, how far they go depends on the variant (GameMoveManager::isOnBoard checks):
+//classic is 0 to 2 both ways, ultimate 0 to 8, and qubic has x 0 to 3 with y as layer * 4 + row,
+//so 0 to 15.  PackedMove only fits classic.
+//no hand written copies or destructor on purpose, the compiler's are a plain memcpy
+struct MoveStruct {
+
+    constexpr MoveStruct() : xPos(0), yPos(0), userMadeMove(false) {}
+    constexpr MoveStruct(uint8_t x, uint8_t y, bool userMade) : xPos(x), yPos(y), userMadeMove(userMade) {}
+
+    uint8_t xPos;
+    uint8_t yPos;
+    bool userMadeMove;
+
+    //for our purposes, moves go sequentially from 0,0 to 2,2
+    //left to right, top to bottom, 0,0 being top left
+    constexpr bool operator< (const MoveStruct& rhs) const
+    {
+        return yPos < rhs.yPos || (yPos == rhs.yPos && xPos < rhs.xPos);
+    }
+    constexpr bool operator> (const MoveStruct& rhs) const
+    {
+        return (rhs < *this);
+    }
+    constexpr bool operator<=(const MoveStruct& rhs) const
+    {
+        return !(*this > rhs);
+    }
+    constexpr bool operator>=(const MoveStruct& rhs) const
+    {
+        return !(*this < rhs);
+    }
+    constexpr bool operator==(const MoveStruct& rhs) const
+    {
+        return (xPos == rhs.xPos && yPos == rhs.yPos && userMadeMove == rhs.userMadeMove);
+    }
+    constexpr bool operator!=(const MoveStruct& rhs) const
+    {
+        return !(*this == rhs);
+    }
+};
+
+//the same move in one byte: cell index (BoardSnapshot order) in the low nibble,
+//owner (a BoardSnapshot::Cell) in the high one.  This is what we store and pass around in bulk,
+//MoveStruct is still there for the signals and the code that thinks in x/y.
+struct PackedMove
+{
+    PackedMove() = default;
+    constexpr PackedMove(int cell, uint8_t owner) : bits(static_cast<uint8_t>((owner << 4) | (cell & 0xf))) {}
+    constexpr explicit PackedMove(const MoveStruct& move) :
+        PackedMove(BoardSnapshot::index(move.xPos, move.yPos), move.userMadeMove ? BoardSnapshot::Player : BoardSnapshot::AI) {}
+
+    constexpr int cell() const { return bits & 0xf; }
+    constexpr uint8_t owner() const { return static_cast<uint8_t>(bits >> 4); }
+
+    constexpr int x() const { return cell() % 3; }
+    constexpr int y() const { return cell() / 3; }
+    constexpr bool userMade() const { return owner() == BoardSnapshot::Player; }
+
+    constexpr MoveStruct toMoveStruct() const
+    {
+        return MoveStruct(static_cast<uint8_t>(x()), static_cast<uint8_t>(y()), userMade());
+    }
+
+    constexpr bool operator==(const PackedMove& rhs) const { return bits == rhs.bits; }
+    constexpr bool operator!=(const PackedMove& rhs) const { return bits != rhs.bits; }
+
+    uint8_t bits;
+};
+
+static_assert(std::is_trivially_copyable<MoveStruct>::value, "MoveStruct should be safe to memcpy");
+static_assert(std::is_trivially_copyable<PackedMove>::value, "PackedMove should be safe to memcpy");
+static_assert(sizeof(PackedMove) == 1, "PackedMove should be one byte");
+static_assert(PackedMove(MoveStruct(2, 1, true)).cell() == 5, "PackedMove cell order should match BoardSnapshot");
+static_assert(PackedMove(7, BoardSnapshot::AI).toMoveStruct() == MoveStruct(1, 2, false), "PackedMove should round trip");
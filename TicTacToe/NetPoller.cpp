@@ -0,0 +1,418 @@
+#include "NetPoller.h"
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+
+namespace
+{
+    //writev can only take so many at once
+    const size_t MaxGatherBuffers = 64;
+
+    bool wouldBlock()
+    {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS;
+#endif
+    }
+
+    void setupSocket(NetSocket socket)
+    {
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ioctlsocket(socket, FIONBIO, &nonBlocking);
+#else
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+        //tiny messages, we do our own batching
+        int noDelay = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+    }
+}
+
+bool NetPoller::startup()
+{
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    //a client hanging up mid-send shouldn't take the whole server down
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+#endif
+}
+
+NetSocket NetPoller::listenTcp(uint16_t port, bool loopbackOnly)
+{
+    NetSocket listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener == InvalidNetSocket)
+        return InvalidNetSocket;
+
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0)
+    {
+        closeSocket(listener);
+        return InvalidNetSocket;
+    }
+
+    setupSocket(listener);
+    return listener;
+}
+
+NetSocket NetPoller::acceptTcp(NetSocket listener)
+{
+    NetSocket client = accept(listener, nullptr, nullptr);
+    if (client == InvalidNetSocket)
+        return InvalidNetSocket;
+
+    setupSocket(client);
+    return client;
+}
+
+NetSocket NetPoller::connectTcp(const char* host, uint16_t port)
+{
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &address.sin_addr) != 1)
+        return InvalidNetSocket;
+
+    NetSocket client = socket(AF_INET, SOCK_STREAM, 0);
+    if (client == InvalidNetSocket)
+        return InvalidNetSocket;
+
+    setupSocket(client);
+
+    //non-blocking, so "in progress" is the normal answer
+    if (connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 && !wouldBlock())
+    {
+        closeSocket(client);
+        return InvalidNetSocket;
+    }
+    return client;
+}
+
+uint16_t NetPoller::getLocalPort(NetSocket socket)
+{
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+        return 0;
+    return ntohs(address.sin_port);
+}
+
+void NetPoller::closeSocket(NetSocket socket)
+{
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+int NetPoller::recvSome(NetSocket socket, uint8_t* buffer, size_t size)
+{
+    if (!size)
+        return 0;
+
+    auto received = recv(socket, reinterpret_cast<char*>(buffer), static_cast<int>(size), 0);
+    if (received > 0)
+        return static_cast<int>(received);
+    if (received < 0 && wouldBlock())
+        return 0;
+    return -1;
+}
+
+int64_t NetPoller::sendGather(NetSocket socket, const NetBuffer* buffers, size_t count)
+{
+    int64_t total = 0;
+    while (count)
+    {
+        size_t batch = count < MaxGatherBuffers ? count : MaxGatherBuffers;
+        size_t batchBytes = 0;
+
+#ifdef _WIN32
+        WSABUF wsaBuffers[MaxGatherBuffers];
+        for (size_t i = 0; i < batch; ++i)
+        {
+            wsaBuffers[i].buf = reinterpret_cast<char*>(const_cast<uint8_t*>(buffers[i].data));
+            wsaBuffers[i].len = static_cast<ULONG>(buffers[i].size);
+            batchBytes += buffers[i].size;
+        }
+        DWORD sentBytes = 0;
+        int64_t sent = WSASend(socket, wsaBuffers, static_cast<DWORD>(batch), &sentBytes, 0, nullptr, nullptr) == 0 ? int64_t(sentBytes) : -1;
+#else
+        iovec ioBuffers[MaxGatherBuffers];
+        for (size_t i = 0; i < batch; ++i)
+        {
+            ioBuffers[i].iov_base = const_cast<uint8_t*>(buffers[i].data);
+            ioBuffers[i].iov_len = buffers[i].size;
+            batchBytes += buffers[i].size;
+        }
+        msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = ioBuffers;
+        message.msg_iovlen = batch;
+        int64_t sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+#endif
+
+        if (sent < 0)
+            return wouldBlock() ? total : -1;
+
+        total += sent;
+
+        //short write, the kernel buffer is full
+        if (static_cast<size_t>(sent) < batchBytes)
+            break;
+
+        buffers += batch;
+        count -= batch;
+    }
+    return total;
+}
+
+size_t NetPoller::raiseFileLimit(size_t wanted)
+{
+#ifdef _WIN32
+    return wanted;
+#else
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0)
+        return 0;
+    if (limit.rlim_cur < wanted)
+    {
+        limit.rlim_cur = wanted < limit.rlim_max ? wanted : limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    return static_cast<size_t>(limit.rlim_cur);
+#endif
+}
+
+#ifdef _WIN32
+
+NetPoller::NetPoller() : m_wakeup(InvalidNetSocket)
+{
+}
+
+NetPoller::~NetPoller()
+{
+    if (m_wakeup != InvalidNetSocket)
+        closeSocket(m_wakeup);
+}
+
+bool NetPoller::add(NetSocket socket, void* userData)
+{
+    WSAPOLLFD pollFd;
+    pollFd.fd = socket;
+    pollFd.events = POLLRDNORM;
+    pollFd.revents = 0;
+    m_indices[socket] = m_pollFds.size();
+    m_pollFds.push_back(pollFd);
+    m_userData.push_back(userData);
+    return true;
+}
+
+bool NetPoller::setWantWrite(NetSocket socket, void*, bool wantWrite)
+{
+    auto found = m_indices.find(socket);
+    if (found == m_indices.end())
+        return false;
+    m_pollFds[found->second].events = wantWrite ? (POLLRDNORM | POLLWRNORM) : POLLRDNORM;
+    return true;
+}
+
+void NetPoller::remove(NetSocket socket)
+{
+    auto found = m_indices.find(socket);
+    if (found == m_indices.end())
+        return;
+
+    //swap the last one into the hole
+    size_t index = found->second;
+    size_t last = m_pollFds.size() - 1;
+    if (index != last)
+    {
+        m_pollFds[index] = m_pollFds[last];
+        m_userData[index] = m_userData[last];
+        m_indices[m_pollFds[index].fd] = index;
+    }
+    m_pollFds.pop_back();
+    m_userData.pop_back();
+    m_indices.erase(found);
+}
+
+int NetPoller::wait(Event* events, int maxEvents, int timeoutMs)
+{
+    if (m_pollFds.empty())
+    {
+        Sleep(timeoutMs);
+        return 0;
+    }
+
+    if (WSAPoll(m_pollFds.data(), static_cast<ULONG>(m_pollFds.size()), timeoutMs) <= 0)
+        return 0;
+
+    int numEvents = 0;
+    for (size_t i = 0; i < m_pollFds.size() && numEvents < maxEvents; ++i)
+    {
+        SHORT revents = m_pollFds[i].revents;
+        if (!revents)
+            continue;
+
+        Event& event = events[numEvents++];
+        event.userData = m_userData[i];
+        event.readable = (revents & POLLRDNORM) != 0;
+        event.writable = (revents & POLLWRNORM) != 0;
+        event.closed = (revents & (POLLERR | POLLHUP | POLLNVAL)) != 0;
+    }
+    return numEvents;
+}
+
+bool NetPoller::addWakeup(void* userData)
+{
+    NetSocket wakeup = socket(AF_INET, SOCK_DGRAM, 0);
+    if (wakeup == InvalidNetSocket)
+        return false;
+
+    //bound to some loopback port and connected to that same port, so a send lands on ourselves
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int length = sizeof(address);
+    if (bind(wakeup, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        getsockname(wakeup, reinterpret_cast<sockaddr*>(&address), &length) != 0 ||
+        connect(wakeup, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        closeSocket(wakeup);
+        return false;
+    }
+
+    u_long nonBlocking = 1;
+    ioctlsocket(wakeup, FIONBIO, &nonBlocking);
+    m_wakeup = wakeup;
+    return add(wakeup, userData);
+}
+
+void NetPoller::wake()
+{
+    char byte = 0;
+    send(m_wakeup, &byte, 1, 0);
+}
+
+void NetPoller::clearWakeup()
+{
+    char bytes[64];
+    while (recv(m_wakeup, bytes, sizeof(bytes), 0) > 0)
+    {
+    }
+}
+
+#else
+
+NetPoller::NetPoller() : m_epollFd(epoll_create1(0)), m_wakeup(InvalidNetSocket)
+{
+}
+
+NetPoller::~NetPoller()
+{
+    if (m_wakeup != InvalidNetSocket)
+        close(m_wakeup);
+    if (m_epollFd >= 0)
+        close(m_epollFd);
+}
+
+bool NetPoller::add(NetSocket socket, void* userData)
+{
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.ptr = userData;
+    return epoll_ctl(m_epollFd, EPOLL_CTL_ADD, socket, &event) == 0;
+}
+
+bool NetPoller::setWantWrite(NetSocket socket, void* userData, bool wantWrite)
+{
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLRDHUP | (wantWrite ? uint32_t(EPOLLOUT) : 0u);
+    event.data.ptr = userData;
+    return epoll_ctl(m_epollFd, EPOLL_CTL_MOD, socket, &event) == 0;
+}
+
+void NetPoller::remove(NetSocket socket)
+{
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, socket, nullptr);
+}
+
+int NetPoller::wait(Event* events, int maxEvents, int timeoutMs)
+{
+    const int MaxBatch = 1024;
+    epoll_event epollEvents[MaxBatch];
+
+    int count = epoll_wait(m_epollFd, epollEvents, maxEvents < MaxBatch ? maxEvents : MaxBatch, timeoutMs);
+    if (count <= 0)
+        return 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        events[i].userData = epollEvents[i].data.ptr;
+        events[i].readable = (epollEvents[i].events & EPOLLIN) != 0;
+        events[i].writable = (epollEvents[i].events & EPOLLOUT) != 0;
+        events[i].closed = (epollEvents[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) != 0;
+    }
+    return count;
+}
+
+bool NetPoller::addWakeup(void* userData)
+{
+    m_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeup < 0)
+        return false;
+    return add(m_wakeup, userData);
+}
+
+void NetPoller::wake()
+{
+    uint64_t one = 1;
+    ssize_t written = write(m_wakeup, &one, sizeof(one));
+    (void)written;
+}
+
+void NetPoller::clearWakeup()
+{
+    //one read takes the whole count back to 0
+    uint64_t count;
+    ssize_t taken = read(m_wakeup, &count, sizeof(count));
+    (void)taken;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET NetSocket;
+const NetSocket InvalidNetSocket = INVALID_SOCKET;
+#else
+typedef int NetSocket;
+const NetSocket InvalidNetSocket = -1;
+#endif
+
+//one piece of a gathered send, maps onto iovec / WSABUF
+struct NetBuffer
+{
+    const uint8_t* data;
+    size_t size;
+};
+
+//thin wrapper over epoll on Linux (WSAPoll on Windows so the project still builds there).
+//level triggered, the caller reads until recvSome says it would block.
+//all sockets it hands out are non-blocking with Nagle off.
+class NetPoller
+{
+public:
+    struct Event
+    {
+        void* userData;
+        bool readable;
+        bool writable;
+        bool closed;
+    };
+
+    //WSAStartup on Windows, ignores SIGPIPE elsewhere.  Call once before anything else.
+    static bool startup();
+
+    static NetSocket listenTcp(uint16_t port, bool loopbackOnly);
+    static NetSocket acceptTcp(NetSocket listener);
+    static NetSocket connectTcp(const char* host, uint16_t port);
+    static uint16_t getLocalPort(NetSocket socket);
+    static void closeSocket(NetSocket socket);
+
+    //bytes read, 0 if it would block, -1 if the peer is gone
+    static int recvSome(NetSocket socket, uint8_t* buffer, size_t size);
+
+    //one syscall for all the buffers.  Bytes sent, 0 if it would block, -1 if the peer is gone
+    static int64_t sendGather(NetSocket socket, const NetBuffer* buffers, size_t count);
+
+    //raise the open file limit so we can hold a lot of connections, returns the new limit
+    static size_t raiseFileLimit(size_t wanted);
+
+    NetPoller();
+    ~NetPoller();
+
+    bool add(NetSocket socket, void* userData);
+    bool setWantWrite(NetSocket socket, void* userData, bool wantWrite);
+    void remove(NetSocket socket);
+
+    //fills events, returns how many (0 on timeout)
+    int wait(Event* events, int maxEvents, int timeoutMs);
+
+    //lets another thread cut a wait() short.  It comes back as a readable event with this user data.
+    bool addWakeup(void* userData);
+
+    //safe from any thread.  Any number of these before the waiter gets to it are one event.
+    void wake();
+
+    //from the waiting thread once it's seen the event, so it stops coming back
+    void clearWakeup();
+
+protected:
+#ifdef _WIN32
+    std::vector<WSAPOLLFD> m_pollFds;
+    std::vector<void*> m_userData;
+    std::unordered_map<NetSocket, size_t> m_indices;
+#else
+    int m_epollFd;
+#endif
+
+    //an eventfd, or a UDP socket sending to itself on Windows (WSAPoll only does sockets)
+    NetSocket m_wakeup;
+};
@@ -0,0 +1,44 @@
+#include "OSGGraphicsWindow.h"
+
+#include <QGLContext>
+#include <QOpenGLContext>
+#include <QThread>
+
+OSGGraphicsWindow::OSGGraphicsWindow(osg::GraphicsContext::Traits* traits) : osgQt::GraphicsWindowQt(traits)
+{
+}
+
+QOpenGLContext* OSGGraphicsWindow::getQtContext() const
+{
+    if (!getGLWidget() || !getGLWidget()->context())
+        return nullptr;
+
+    return getGLWidget()->context()->contextHandle();
+}
+
+void OSGGraphicsWindow::adoptContext()
+{
+    QOpenGLContext* context = getQtContext();
+    if (context && !context->thread())
+        context->moveToThread(QThread::currentThread());
+}
+
+void OSGGraphicsWindow::parkContext()
+{
+    QOpenGLContext* context = getQtContext();
+    if (context && context->thread() == QThread::currentThread())
+        context->moveToThread(nullptr);
+}
+
+bool OSGGraphicsWindow::makeCurrentImplementation()
+{
+    adoptContext();
+    return osgQt::GraphicsWindowQt::makeCurrentImplementation();
+}
+
+bool OSGGraphicsWindow::releaseContextImplementation()
+{
+    bool released = osgQt::GraphicsWindowQt::releaseContextImplementation();
+    parkContext();
+    return released;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <osgQt/GraphicsWindowQt>
+
+class QOpenGLContext;
+
+//Qt won't let a thread make a GL context current unless the context belongs to that thread,
+//and the threaded viewer models draw from threads of OSG's own that Qt has never heard of.
+//so whoever lets go of the context parks it (no thread at all), and whoever makes it current
+//next pulls it over.  Pulling an object with no thread is the one move Qt allows from the
+//receiving side.
+class OSGGraphicsWindow : public osgQt::GraphicsWindowQt
+{
+public:
+    OSGGraphicsWindow(osg::GraphicsContext::Traits* traits);
+
+    //take the context into the calling thread, if nobody has it
+    void adoptContext();
+
+    //give it up so another thread can adopt it.  Does nothing unless the calling thread has it.
+    void parkContext();
+
+protected:
+    virtual bool makeCurrentImplementation() override;
+    virtual bool releaseContextImplementation() override;
+
+    QOpenGLContext* getQtContext() const;
+};
@@ -1,4 +1,5 @@
 #include "OSGViewerWidget.h"
+#include "OSGGraphicsWindow.h"
 
 
 //osg
@@ -48,5 +49,36 @@ osgQt::GraphicsWindowQt* OSGViewerWidget::createGraphicsWindow()
     traits->sampleBuffers = ds->getMultiSamples();
     traits->samples = ds->getNumMultiSamples();
 
-    return new osgQt::GraphicsWindowQt(traits.get());
+    OSGGraphicsWindow* window = new OSGGraphicsWindow(traits.get());
+    m_graphicsWindows.push_back(window);
+    return window;
+}
+
+void OSGViewerWidget::releaseContexts()
+{
+    for (auto&& window : m_graphicsWindows)
+        window->releaseContext();
+}
+
+void OSGViewerWidget::adoptContexts()
+{
+    for (auto&& window : m_graphicsWindows)
+        window->adoptContext();
+}
+
+const char* OSGViewerWidget::getThreadingModelName(osgViewer::ViewerBase::ThreadingModel threadingModel)
+{
+    switch (threadingModel)
+    {
+    case osgViewer::ViewerBase::SingleThreaded:
+        return "Single Threaded";
+    case osgViewer::ViewerBase::CullDrawThreadPerContext:
+        return "Cull/Draw Thread Per Context";
+    case osgViewer::ViewerBase::DrawThreadPerContext:
+        return "Draw Thread Per Context";
+    case osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext:
+        return "Cull Thread Per Camera, Draw Thread Per Context";
+    default:
+        return "Automatic";
+    }
 }
@@ -2,6 +2,8 @@
 #include <QOpenGLWidget>
 #include <osgViewer/CompositeViewer>
 
+class OSGGraphicsWindow;
+
 namespace osgQt
 {
     class GLWidget;
@@ -24,7 +26,15 @@ public:
 
     std::vector<osgQt::GLWidget*> getGLWidgets() const { return m_qglWidgets; }
 
+    //hand the GL contexts between threads, see OSGGraphicsWindow.  Release from the thread that's
+    //been drawing, and whichever thread draws next (ours or one of the viewer's) picks them up.
+    void releaseContexts();
+    void adoptContexts();
+
+    static const char* getThreadingModelName(osgViewer::ViewerBase::ThreadingModel threadingModel);
+
 protected:
     std::vector<osgQt::GLWidget*> m_qglWidgets;
+    std::vector<OSGGraphicsWindow*> m_graphicsWindows;
 
 };
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "MoveStruct.h"
+
+#include <vector>
+
+//up to a board's worth of moves, stored inline.  Ten bytes and trivially copyable, so the
+//bulk getters hand these out by value instead of allocating a vector every call.
+//reads like a span: begin/end/size/operator[].
+class PackedMoveList
+{
+public:
+    static const int Capacity = 9;
+
+    PackedMoveList() : m_size(0) {}
+
+    const PackedMove* begin() const { return m_moves; }
+    const PackedMove* end() const { return m_moves + m_size; }
+    const PackedMove* data() const { return m_moves; }
+    int size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const PackedMove& operator[](int i) const { return m_moves[i]; }
+    const PackedMove& back() const { return m_moves[m_size - 1]; }
+
+    void clear() { m_size = 0; }
+
+    void push_back(PackedMove move)
+    {
+        if (m_size < Capacity)
+            m_moves[m_size++] = move;
+    }
+
+    void pop_back()
+    {
+        if (m_size)
+            --m_size;
+    }
+
+    //keeps the list in cell order, false if that cell is already in it
+    bool insertSorted(PackedMove move)
+    {
+        int i = m_size;
+        while (i > 0 && m_moves[i - 1].cell() > move.cell())
+            --i;
+
+        if ((i > 0 && m_moves[i - 1].cell() == move.cell()) || m_size == Capacity)
+            return false;
+
+        for (int j = m_size; j > i; --j)
+            m_moves[j] = m_moves[j - 1];
+        m_moves[i] = move;
+        ++m_size;
+        return true;
+    }
+
+    bool containsCell(int cell) const
+    {
+        for (int i = 0; i < m_size; ++i)
+            if (m_moves[i].cell() == cell)
+                return true;
+        return false;
+    }
+
+    //for callers that still want the old vector of MoveStructs
+    std::vector<MoveStruct> toMoveStructs() const
+    {
+        std::vector<MoveStruct> moves;
+        moves.reserve(m_size);
+        for (int i = 0; i < m_size; ++i)
+            moves.push_back(m_moves[i].toMoveStruct());
+        return moves;
+    }
+
+protected:
+    PackedMove m_moves[Capacity];
+    uint8_t m_size;
+};
+
+static_assert(std::is_trivially_copyable<PackedMoveList>::value, "PackedMoveList should be safe to memcpy");
@@ -0,0 +1,232 @@
+#include "PositionCache.h"
+
+#include <chrono>
+
+namespace
+{
+    //slot layout, from the top: occupied, referenced (hit since the last sweep), book,
+    //29 bits of clock stamp, then the score (offset by 128), the best move (15 for none) and the key
+    const uint64_t Occupied = uint64_t(1) << 63;
+    const uint64_t Referenced = uint64_t(1) << 62;
+    const uint64_t Book = uint64_t(1) << 61;
+    const int StampShift = 32;
+    const uint64_t StampMask = (uint64_t(1) << 29) - 1;
+    const int ScoreShift = 20;
+    const int MoveShift = 16;
+    const uint64_t KeyMask = 0xffff;
+
+    uint64_t pack(uint32_t key, int bestMove, int score, bool book, uint64_t stamp)
+    {
+        uint64_t value = Occupied | (uint64_t(key) & KeyMask);
+        value |= uint64_t(bestMove < 0 ? 15 : bestMove & 0xf) << MoveShift;
+        value |= uint64_t((score + 128) & 0xff) << ScoreShift;
+        value |= (stamp & StampMask) << StampShift;
+        if (book)
+            value |= Book;
+        return value;
+    }
+
+    PositionCache::Entry unpack(uint64_t value)
+    {
+        PositionCache::Entry entry;
+        int move = static_cast<int>((value >> MoveShift) & 0xf);
+        entry.bestMove = static_cast<int8_t>(move == 15 ? -1 : move);
+        entry.score = static_cast<int8_t>(static_cast<int>((value >> ScoreShift) & 0xff) - 128);
+        entry.book = (value & Book) != 0;
+        return entry;
+    }
+
+    uint32_t stampOf(uint64_t value)
+    {
+        return static_cast<uint32_t>((value >> StampShift) & StampMask);
+    }
+
+    //the keys are small and dense, spread them out so neighbours don't pile into one window
+    size_t homeSlot(uint32_t key, size_t mask)
+    {
+        uint32_t hash = key * 0x9e3779b1u;
+        hash ^= hash >> 15;
+        return hash & mask;
+    }
+}
+
+PositionCache::PositionCache(size_t capacity) : m_capacity(ProbeLimit),
+    m_clock(0)
+{
+    while (m_capacity < capacity)
+        m_capacity <<= 1;
+    m_mask = m_capacity - 1;
+
+    m_slots.reset(new std::atomic<uint64_t>[m_capacity]);
+    for (size_t i = 0; i < m_capacity; ++i)
+        m_slots[i].store(0, std::memory_order_relaxed);
+}
+
+uint32_t PositionCache::makeKey(const BoardSnapshot& board, uint8_t side)
+{
+    uint32_t code = 0;
+    for (int cell = 8; cell >= 0; --cell)
+        code = (code * 3) + board.cells[cell];
+    return (code << 1) | (side == BoardSnapshot::AI ? 1 : 0);
+}
+
+PositionCache::Counters& PositionCache::getCounters()
+{
+    static std::atomic<uint32_t> nextStripe(0);
+    static thread_local uint32_t stripe = nextStripe++ % NumCounterStripes;
+    return m_counters[stripe];
+}
+
+bool PositionCache::find(uint32_t key, Entry& entry)
+{
+    size_t home = homeSlot(key, m_mask);
+    for (int i = 0; i < ProbeLimit; ++i)
+    {
+        std::atomic<uint64_t>& slot = m_slots[(home + i) & m_mask];
+        uint64_t value = slot.load(std::memory_order_acquire);
+
+        //nothing is ever removed, only replaced, so nobody's past an empty slot
+        if (!(value & Occupied))
+            return false;
+        if ((value & KeyMask) != key)
+            continue;
+
+        //at most one write per entry per sweep, lookups stay reads almost all the time
+        if (!(value & Referenced))
+            slot.compare_exchange_strong(value, value | Referenced, std::memory_order_relaxed);
+
+        entry = unpack(value);
+        return true;
+    }
+    return false;
+}
+
+bool PositionCache::lookup(uint32_t key, Entry& entry)
+{
+    Counters& counters = getCounters();
+    uint64_t lookups = counters.lookups.fetch_add(1, std::memory_order_relaxed);
+
+    bool found;
+    if ((lookups % SampleInterval) == 0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        found = find(key, entry);
+        uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        counters.sampledNanos.fetch_add(nanos, std::memory_order_relaxed);
+        counters.sampledLookups.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        found = find(key, entry);
+    }
+
+    if (found)
+        counters.hits.fetch_add(1, std::memory_order_relaxed);
+    return found;
+}
+
+void PositionCache::store(uint32_t key, int bestMove, int score, bool book)
+{
+    Counters& counters = getCounters();
+    counters.stores.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t stamp = m_clock.fetch_add(1, std::memory_order_relaxed) & StampMask;
+    uint64_t desired = pack(key, bestMove, score, book, stamp);
+    size_t home = homeSlot(key, m_mask);
+
+    //somebody else can get in first, look again if they do.  Two threads racing to put the same
+    //key in different slots can leave it in twice, which costs a slot but both answers are right.
+    for (int attempt = 0; attempt < ProbeLimit; ++attempt)
+    {
+        int victim = -1;
+        uint64_t victimValue = 0;
+        uint32_t victimAge = 0;
+        bool raced = false;
+
+        for (int i = 0; i < ProbeLimit && !raced; ++i)
+        {
+            std::atomic<uint64_t>& slot = m_slots[(home + i) & m_mask];
+            uint64_t value = slot.load(std::memory_order_acquire);
+
+            if (!(value & Occupied) || (value & KeyMask) == key)
+            {
+                //a solved answer never beats the book's
+                if ((value & Book) && !book)
+                    return;
+                if (slot.compare_exchange_strong(value, desired, std::memory_order_acq_rel))
+                    return;
+                raced = true;
+                break;
+            }
+
+            if (value & Book)
+                continue;
+
+            //second chance: anything hit since the last sweep loses to anything that wasn't, then oldest goes
+            uint32_t age = (stamp - stampOf(value)) & StampMask;
+            bool better = victim < 0;
+            if (!better)
+            {
+                bool referenced = (value & Referenced) != 0;
+                bool victimReferenced = (victimValue & Referenced) != 0;
+                better = referenced != victimReferenced ? !referenced : age > victimAge;
+            }
+            if (better)
+            {
+                victim = i;
+                victimValue = value;
+                victimAge = age;
+            }
+        }
+
+        if (raced)
+            continue;
+
+        if (victim < 0)
+        {
+            counters.rejected.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        std::atomic<uint64_t>& slot = m_slots[(home + victim) & m_mask];
+        if (!slot.compare_exchange_strong(victimValue, desired, std::memory_order_acq_rel))
+            continue;
+
+        counters.replacements.fetch_add(1, std::memory_order_relaxed);
+
+        //the sweep: whoever got a second chance this time has to earn the next one
+        for (int i = 0; i < ProbeLimit; ++i)
+        {
+            std::atomic<uint64_t>& other = m_slots[(home + i) & m_mask];
+            uint64_t value = other.load(std::memory_order_relaxed);
+            if (value & Referenced)
+                other.compare_exchange_strong(value, value & ~Referenced, std::memory_order_relaxed);
+        }
+        return;
+    }
+}
+
+size_t PositionCache::getNumEntries() const
+{
+    size_t entries = 0;
+    for (size_t i = 0; i < m_capacity; ++i)
+        if (m_slots[i].load(std::memory_order_relaxed) & Occupied)
+            ++entries;
+    return entries;
+}
+
+PositionCache::Stats PositionCache::getStats() const
+{
+    Stats stats = Stats();
+    for (auto&& counters : m_counters)
+    {
+        stats.lookups += counters.lookups.load(std::memory_order_relaxed);
+        stats.hits += counters.hits.load(std::memory_order_relaxed);
+        stats.stores += counters.stores.load(std::memory_order_relaxed);
+        stats.replacements += counters.replacements.load(std::memory_order_relaxed);
+        stats.rejected += counters.rejected.load(std::memory_order_relaxed);
+        stats.sampledLookups += counters.sampledLookups.load(std::memory_order_relaxed);
+        stats.sampledNanos += counters.sampledNanos.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
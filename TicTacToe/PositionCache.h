@@ -0,0 +1,92 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <memory>
+
+//solved positions, shared by every game in the process.  Thousands of games keep running into
+//the same few hundred boards, so whoever solves one first saves everybody else the search.
+//each slot is a single 64 bit atomic holding the key, the answer and the bookkeeping, so a
+//lookup is a handful of relaxed loads and a store is one compare and swap: no locks anywhere.
+//open addressing with a short linear probe, and the table never grows.  When the probe window
+//is full the stalest entry goes, with a second chance for anything that's been hit since it was
+//last looked at (CLOCK).  Opening book entries are pinned and never get replaced.
+class PositionCache
+{
+public:
+    //how far a key can land from its home slot
+    static const int ProbeLimit = 8;
+
+    struct Entry
+    {
+        int8_t bestMove;
+        int8_t score;       //from the point of view of the side to move
+        bool book;
+    };
+
+    struct Stats
+    {
+        uint64_t lookups;
+        uint64_t hits;
+        uint64_t stores;
+        uint64_t replacements;      //stores that pushed somebody else out
+        uint64_t rejected;          //stores with nowhere to go, the window was all book
+        uint64_t sampledLookups;    //one lookup in SampleInterval gets timed
+        uint64_t sampledNanos;
+
+        double getHitRate() const { return lookups ? double(hits) / lookups : 0.0; }
+        double getMeanLookupNanos() const { return sampledLookups ? double(sampledNanos) / sampledLookups : 0.0; }
+    };
+
+    //rounded up to a power of two.  Memory is capacity * 8 bytes, forever.
+    explicit PositionCache(size_t capacity);
+
+    //base 3 board plus who's moving, unique for every tic tac toe position
+    static uint32_t makeKey(const BoardSnapshot& board, uint8_t side);
+
+    //safe from any thread
+    bool lookup(uint32_t key, Entry& entry);
+    void store(uint32_t key, int bestMove, int score, bool book = false);
+
+    size_t getCapacity() const { return m_capacity; }
+
+    //slots in use, walks the whole table so it's for reports, not hot paths
+    size_t getNumEntries() const;
+
+    //summed over every thread's counters
+    Stats getStats() const;
+
+protected:
+    static const int NumCounterStripes = 16;
+    static const uint64_t SampleInterval = 64;
+
+    //the counters are per thread (well, per stripe), so every lookup isn't fighting over one cache line
+    struct alignas(64) Counters
+    {
+        Counters() : lookups(0), hits(0), stores(0), replacements(0), rejected(0), sampledLookups(0), sampledNanos(0) {}
+
+        std::atomic<uint64_t> lookups;
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> stores;
+        std::atomic<uint64_t> replacements;
+        std::atomic<uint64_t> rejected;
+        std::atomic<uint64_t> sampledLookups;
+        std::atomic<uint64_t> sampledNanos;
+    };
+
+    Counters& getCounters();
+
+    bool find(uint32_t key, Entry& entry);
+
+    size_t m_capacity;
+    size_t m_mask;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_slots;
+
+    //handed out to stores, so replacement knows who's oldest
+    std::atomic<uint32_t> m_clock;
+
+    Counters m_counters[NumCounterStripes];
+};
@@ -0,0 +1,137 @@
+#include "QubicBoard.h"
+
+namespace
+{
+    //every line through the cube, and which ones go through each cell, worked out once
+    struct LineTables
+    {
+        LineTables() : numLines(0)
+        {
+            for (int cell = 0; cell < QubicBoard::NumCells; ++cell)
+                numThrough[cell] = 0;
+
+            //each direction once: the first step that isn't 0 is forwards
+            for (int dz = -1; dz <= 1; ++dz)
+            {
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    for (int dx = -1; dx <= 1; ++dx)
+                    {
+                        int first = dz ? dz : (dy ? dy : dx);
+                        if (first <= 0)
+                            continue;
+                        addLines(dx, dy, dz);
+                    }
+                }
+            }
+        }
+
+        void addLines(int dx, int dy, int dz)
+        {
+            for (int z = 0; z < QubicBoard::Size; ++z)
+            {
+                for (int y = 0; y < QubicBoard::Size; ++y)
+                {
+                    for (int x = 0; x < QubicBoard::Size; ++x)
+                    {
+                        //a line runs the whole width in every direction it moves in
+                        int endX = x + (dx * 3);
+                        int endY = y + (dy * 3);
+                        int endZ = z + (dz * 3);
+                        if (endX < 0 || endX > 3 || endY < 0 || endY > 3 || endZ < 0 || endZ > 3)
+                            continue;
+
+                        uint64_t mask = 0;
+                        for (int i = 0; i < QubicBoard::Size; ++i)
+                        {
+                            int cell = QubicBoard::cellFromXYZ(x + (dx * i), y + (dy * i), z + (dz * i));
+                            mask |= uint64_t(1) << cell;
+                            through[cell][numThrough[cell]++] = static_cast<uint8_t>(numLines);
+                        }
+                        lines[numLines++] = mask;
+                    }
+                }
+            }
+        }
+
+        uint64_t lines[QubicBoard::NumLines];
+        int numLines;
+        uint8_t through[QubicBoard::NumCells][QubicBoard::MaxLinesThrough];
+        uint8_t numThrough[QubicBoard::NumCells];
+    };
+
+    const LineTables Tables;
+}
+
+QubicBoard::QubicBoard() : sideToMove(BoardSnapshot::Player), winner(BoardSnapshot::Empty), numMoves(0)
+{
+    cells[0] = cells[1] = 0;
+}
+
+uint64_t QubicBoard::getLine(int line)
+{
+    return Tables.lines[line];
+}
+
+int QubicBoard::getNumLinesThrough(int cell)
+{
+    return Tables.numThrough[cell];
+}
+
+const uint8_t* QubicBoard::getLinesThrough(int cell)
+{
+    return Tables.through[cell];
+}
+
+int QubicBoard::popcount(uint64_t mask)
+{
+    //the usual SWAR count, there's no portable intrinsic in VS2015
+    mask = mask - ((mask >> 1) & 0x5555555555555555ull);
+    mask = (mask & 0x3333333333333333ull) + ((mask >> 2) & 0x3333333333333333ull);
+    mask = (mask + (mask >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<int>((mask * 0x0101010101010101ull) >> 56);
+}
+
+uint8_t QubicBoard::at(int cell) const
+{
+    uint64_t bit = uint64_t(1) << cell;
+    if (cells[0] & bit)
+        return BoardSnapshot::Player;
+    if (cells[1] & bit)
+        return BoardSnapshot::AI;
+    return BoardSnapshot::Empty;
+}
+
+bool QubicBoard::play(int cell)
+{
+    if (cell < 0 || cell >= NumCells || isGameOver())
+        return false;
+
+    uint64_t bit = uint64_t(1) << cell;
+    if (!(getEmpty() & bit))
+        return false;
+
+    uint64_t& mine = cells[sideToMove - 1];
+    mine |= bit;
+
+    //only the lines through this cell could have just been finished
+    const uint8_t* lines = Tables.through[cell];
+    for (int i = 0; i < Tables.numThrough[cell]; ++i)
+    {
+        uint64_t line = Tables.lines[lines[i]];
+        if ((mine & line) == line)
+            winner = sideToMove;
+    }
+
+    sideToMove = BoardSnapshot::opponent(sideToMove);
+    ++numMoves;
+    return true;
+}
+
+void QubicBoard::undo(int cell)
+{
+    sideToMove = BoardSnapshot::opponent(sideToMove);
+    cells[sideToMove - 1] &= ~(uint64_t(1) << cell);
+    winner = BoardSnapshot::Empty;
+    --numMoves;
+}
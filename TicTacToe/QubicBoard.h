@@ -0,0 +1,54 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+#include "MoveStruct.h"
+
+#include <cinttypes>
+
+//qubic, 4x4x4 tic tac toe: four in a row in any direction through the cube wins, 76 lines in all.
+//one bit per cell per side, so the whole position is two uint64_ts.  Each line is a mask made
+//once, and each cell knows the (up to 7) lines through it, so a win check after a move is a
+//handful of ands.
+//cells are layer * 16 + row * 4 + column.  Layer 0 is the bottom of the cube as it's drawn.
+struct QubicBoard
+{
+    static const int Size = 4;
+    static const int NumCells = 64;
+    static const int NumLines = 76;
+
+    //the corners and the middle eight are on 7 lines, everything else on 4
+    static const int MaxLinesThrough = 7;
+
+    QubicBoard();
+
+    static int cellFromXYZ(int x, int y, int z) { return (z * 16) + (y * 4) + x; }
+    static int xFromCell(int cell) { return cell & 3; }
+    static int yFromCell(int cell) { return (cell >> 2) & 3; }
+    static int zFromCell(int cell) { return cell >> 4; }
+
+    //MoveStruct only has x and y, so the layers go one under the other: yPos is layer * 4 + row
+    static int cellFromMove(const MoveStruct& move) { return cellFromXYZ(move.xPos, move.yPos & 3, move.yPos >> 2); }
+    static MoveStruct getMove(int cell, bool userMadeMove) { return MoveStruct(static_cast<uint8_t>(xFromCell(cell)), static_cast<uint8_t>((zFromCell(cell) * 4) + yFromCell(cell)), userMadeMove); }
+
+    uint8_t at(int cell) const;
+    uint64_t getEmpty() const { return ~(cells[0] | cells[1]); }
+
+    //false (and nothing changes) if the cell's taken or the game's over
+    bool play(int cell);
+
+    //takes back the last move, which was on cell
+    void undo(int cell);
+
+    bool isGameOver() const { return winner != BoardSnapshot::Empty || getEmpty() == 0; }
+
+    static uint64_t getLine(int line);
+    static int getNumLinesThrough(int cell);
+    static const uint8_t* getLinesThrough(int cell);
+
+    static int popcount(uint64_t mask);
+
+    uint64_t cells[2];      //[side - 1]
+    uint8_t sideToMove;     //Player or AI
+    uint8_t winner;         //Empty until somebody has four in a row
+    uint8_t numMoves;
+};
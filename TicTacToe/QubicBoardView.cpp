@@ -0,0 +1,206 @@
+#include "QubicBoardView.h"
+
+#include <osg/Camera>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/MatrixTransform>
+#include <osg/ShapeDrawable>
+#include <osg/Switch>
+
+#include <osgGA/OrbitManipulator>
+
+#include <osgUtil/IntersectionVisitor>
+#include <osgUtil/LineSegmentIntersector>
+
+#include <algorithm>
+
+namespace
+{
+    //cells are a unit apart in a layer, the layers further apart so you can see between them
+    const double CellSpacing = 1.0;
+    const double LayerSpacing = 1.6;
+
+    //the switch's children, in BoardSnapshot cell order
+    const unsigned int EmptyShape = 0;
+    const unsigned int PlayerShape = 1;
+    const unsigned int AIShape = 2;
+
+    osg::Vec3d getCellCenter(int cell)
+    {
+        //row 0 at the back, same as the top row of the flat boards
+        return osg::Vec3d((QubicBoard::xFromCell(cell) - 1.5) * CellSpacing,
+            (1.5 - QubicBoard::yFromCell(cell)) * CellSpacing,
+            (QubicBoard::zFromCell(cell) - 1.5) * LayerSpacing);
+    }
+
+    void setTransparent(osg::StateSet* stateset)
+    {
+        stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+        stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+    }
+
+    osg::Geode* createShape(osg::Shape* shape, const osg::Vec4f& color)
+    {
+        //a few dozen triangles a sphere is plenty at this size, and keeps a software GL at frame rate
+        osg::TessellationHints* hints = new osg::TessellationHints;
+        hints->setDetailRatio(0.4f);
+
+        osg::ShapeDrawable* drawable = new osg::ShapeDrawable(shape, hints);
+        drawable->setColor(color);
+
+        osg::Geode* geode = new osg::Geode;
+        geode->addDrawable(drawable);
+        if (color.a() < 1.0f)
+            setTransparent(geode->getOrCreateStateSet());
+        return geode;
+    }
+
+    osg::Geode* createPlates()
+    {
+        osg::Geometry* geometry = new osg::Geometry;
+        osg::Vec3Array* vertices = new osg::Vec3Array;
+        double half = 2.0 * CellSpacing;
+        for (int layer = 0; layer < QubicBoard::Size; ++layer)
+        {
+            //just under the layer's cells
+            double z = ((layer - 1.5) * LayerSpacing) - (0.45 * CellSpacing);
+            vertices->push_back(osg::Vec3d(-half, half, z));
+            vertices->push_back(osg::Vec3d(half, half, z));
+            vertices->push_back(osg::Vec3d(half, -half, z));
+            vertices->push_back(osg::Vec3d(-half, -half, z));
+        }
+        geometry->setVertexArray(vertices);
+
+        osg::Vec4Array* colors = new osg::Vec4Array;
+        colors->push_back(osg::Vec4f(1.0f, 0.0f, 0.0f, 0.15f));
+        geometry->setColorArray(colors, osg::Array::BIND_OVERALL);
+
+        geometry->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, QubicBoard::Size * 4));
+
+        osg::Geode* geode = new osg::Geode;
+        geode->addDrawable(geometry);
+
+        //flat and see through, lighting would only make them darker from underneath
+        osg::StateSet* stateset = geode->getOrCreateStateSet();
+        stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+        setTransparent(stateset);
+        return geode;
+    }
+}
+
+QubicBoardView::QubicBoardView() : m_width(0.0),
+    m_height(0.0)
+{
+    //our own projection and view, drawn after (and over) whatever the 2D camera has drawn so far
+    m_camera = new osg::Camera;
+    m_camera->setReferenceFrame(osg::Transform::ABSOLUTE_RF);
+    m_camera->setRenderOrder(osg::Camera::NESTED_RENDER);
+    m_camera->setClearMask(GL_DEPTH_BUFFER_BIT);
+
+    osg::StateSet* stateset = m_camera->getOrCreateStateSet();
+    stateset->setMode(GL_LIGHTING, osg::StateAttribute::ON);
+    stateset->setMode(GL_DEPTH_TEST, osg::StateAttribute::ON);
+
+    //looking at a corner from a bit above, far enough back for the whole cube
+    m_manipulator = new osgGA::OrbitManipulator;
+    m_manipulator->setHomePosition(osg::Vec3d(7.0, -11.0, 7.0), osg::Vec3d(0.0, 0.0, 0.0), osg::Vec3d(0.0, 0.0, 1.0));
+    m_manipulator->home(0.0);
+
+    m_camera->addChild(createPlates());
+
+    //one of each look, shared by all 64 cells
+    osg::ref_ptr<osg::Geode> shapes[3];
+    shapes[EmptyShape] = createShape(new osg::Box(osg::Vec3(), 0.2f * CellSpacing), osg::Vec4f(1.0f, 1.0f, 1.0f, 0.35f));
+    shapes[PlayerShape] = createShape(new osg::Sphere(osg::Vec3(), 0.35f * CellSpacing), osg::Vec4f(0.25f, 0.55f, 1.0f, 1.0f));
+    shapes[AIShape] = createShape(new osg::Sphere(osg::Vec3(), 0.35f * CellSpacing), osg::Vec4f(1.0f, 0.3f, 0.2f, 1.0f));
+
+    m_cellGroup = new osg::Group;
+    for (int cell = 0; cell < QubicBoard::NumCells; ++cell)
+    {
+        osg::MatrixTransform* transform = new osg::MatrixTransform(osg::Matrixd::translate(getCellCenter(cell)));
+
+        osg::Switch* cellShapes = new osg::Switch;
+        for (auto&& shape : shapes)
+            cellShapes->addChild(shape, false);
+        cellShapes->setSingleChildOn(EmptyShape);
+        transform->addChild(cellShapes);
+
+        m_cellGroup->addChild(transform);
+        m_cells.push_back(transform);
+        m_cellShapes.push_back(cellShapes);
+        m_shown.push_back(BoardSnapshot::Empty);
+    }
+    m_camera->addChild(m_cellGroup);
+}
+
+QubicBoardView::~QubicBoardView()
+{
+}
+
+osg::Node* QubicBoardView::getNode() const
+{
+    return m_camera.get();
+}
+
+bool QubicBoardView::handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa)
+{
+    return m_manipulator->handle(ea, aa);
+}
+
+void QubicBoardView::update(const QubicBoard& board, double width, double height)
+{
+    if (width != m_width || height != m_height)
+    {
+        m_width = width;
+        m_height = height;
+        if (height > 0.0)
+            m_camera->setProjectionMatrixAsPerspective(30.0, width / height, 1.0, 100.0);
+    }
+
+    //cheap, and the manipulator can still be coasting after a drag
+    m_camera->setViewMatrix(m_manipulator->getInverseMatrix());
+
+    for (int cell = 0; cell < QubicBoard::NumCells; ++cell)
+    {
+        uint8_t side = board.at(cell);
+        if (side == m_shown[cell])
+            continue;
+        m_shown[cell] = side;
+        m_cellShapes[cell]->setSingleChildOn(side);
+    }
+}
+
+int QubicBoardView::pick(double x, double y) const
+{
+    if (m_width <= 0.0 || m_height <= 0.0)
+        return -1;
+
+    //the pixel's ray from the near plane to the far one, back through the view and projection
+    osg::Matrixd toWorld = osg::Matrixd::inverse(m_camera->getViewMatrix() * m_camera->getProjectionMatrix());
+    double ndcX = ((2.0 * x) / m_width) - 1.0;
+    double ndcY = ((2.0 * y) / m_height) - 1.0;
+    osg::Vec3d start = osg::Vec3d(ndcX, ndcY, -1.0) * toWorld;
+    osg::Vec3d end = osg::Vec3d(ndcX, ndcY, 1.0) * toWorld;
+
+    osg::ref_ptr<osgUtil::LineSegmentIntersector> intersector = new osgUtil::LineSegmentIntersector(start, end);
+    osgUtil::IntersectionVisitor visitor(intersector.get());
+    m_cellGroup->accept(visitor);
+
+    //nearest first.  The cell is whichever of ours is on the way down to what got hit.
+    for (auto&& hit : intersector->getIntersections())
+    {
+        for (auto node = hit.nodePath.rbegin(); node != hit.nodePath.rend(); ++node)
+        {
+            osg::Node* pathNode = *node;
+            auto found = std::find_if(m_cells.begin(), m_cells.end(), [pathNode](const osg::ref_ptr<osg::MatrixTransform>& cell) { return cell.get() == pathNode; });
+            if (found == m_cells.end())
+                continue;
+
+            int cell = static_cast<int>(found - m_cells.begin());
+            if (m_shown[cell] == BoardSnapshot::Empty)
+                return cell;
+            break;
+        }
+    }
+    return -1;
+}
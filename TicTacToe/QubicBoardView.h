@@ -0,0 +1,64 @@
+#pragma once
+
+#include "QubicBoard.h"
+
+#include <osg/ref_ptr>
+
+#include <cinttypes>
+#include <vector>
+
+namespace osg
+{
+    class Camera;
+    class Group;
+    class MatrixTransform;
+    class Node;
+    class Switch;
+}
+
+namespace osgGA
+{
+    class GUIActionAdapter;
+    class GUIEventAdapter;
+    class OrbitManipulator;
+}
+
+//draws a qubic board in 3D: the 64 cells as a 4x4x4 lattice with a plate under each layer, in a
+//perspective camera of its own nested under our 2D one, so the score text still draws over it.
+//drag to turn the cube round, the wheel zooms; that's an OrbitManipulator we feed the events to.
+//the same three shapes (an empty cell marker, a player piece and an AI piece) are shared by every
+//cell, a cell is just a transform and a switch picking which one shows, so the scene is 64 tiny
+//nodes over three drawables.  Like the other boards, a cell is only touched when it changes.
+//clicks come back as cells through an intersection visitor, not layout math.
+class QubicBoardView
+{
+public:
+    QubicBoardView();
+    ~QubicBoardView();
+
+    osg::Node* getNode() const;
+
+    //the viewport's size, for the projection
+    void update(const QubicBoard& board, double width, double height);
+
+    //turning and zooming.  True if the manipulator used it.
+    bool handle(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& aa);
+
+    //the nearest empty cell under a viewport pixel (bottom left origin, same as BoardLayout),
+    //-1 if there isn't one.  Clicks go through the pieces to get at the cells behind them.
+    int pick(double x, double y) const;
+
+protected:
+    osg::ref_ptr<osg::Camera> m_camera;
+    osg::ref_ptr<osgGA::OrbitManipulator> m_manipulator;
+
+    osg::ref_ptr<osg::Group> m_cellGroup;
+    std::vector<osg::ref_ptr<osg::MatrixTransform>> m_cells;
+    std::vector<osg::ref_ptr<osg::Switch>> m_cellShapes;
+
+    //a BoardSnapshot cell for each, what its switch shows
+    std::vector<uint8_t> m_shown;
+
+    double m_width;
+    double m_height;
+};
@@ -0,0 +1,205 @@
+#include "QubicSearch.h"
+
+#include <algorithm>
+
+namespace
+{
+    //what an open line is worth for the side with n in it
+    const int LineWeights[5] = { 0, 1, 6, 40, 0 };
+
+    //looking at the clock every node would cost more than the node
+    const uint64_t CheckEvery = 1024;
+
+    int countIn(uint64_t mask, uint64_t line)
+    {
+        return QubicBoard::popcount(mask & line);
+    }
+
+    int lowestCell(uint64_t mask)
+    {
+        int cell = 0;
+        while (!((mask >> cell) & 1))
+            ++cell;
+        return cell;
+    }
+}
+
+QubicSearch::QubicSearch(int maxDepth) : m_maxDepth(maxDepth), m_limits(nullptr), m_stopped(false), m_nodes(0)
+{
+}
+
+int QubicSearch::evaluate(const QubicBoard& board) const
+{
+    uint64_t mine = board.cells[board.sideToMove - 1];
+    uint64_t theirs = board.cells[BoardSnapshot::opponent(board.sideToMove) - 1];
+
+    int score = 0;
+    for (int line = 0; line < QubicBoard::NumLines; ++line)
+    {
+        uint64_t mask = QubicBoard::getLine(line);
+        int m = countIn(mine, mask);
+        int t = countIn(theirs, mask);
+        if (!t)
+            score += LineWeights[m];
+        else if (!m)
+            score -= LineWeights[t];
+    }
+    return score;
+}
+
+int QubicSearch::getMoves(const QubicBoard& board, uint8_t* out) const
+{
+    uint64_t mine = board.cells[board.sideToMove - 1];
+    uint64_t theirs = board.cells[BoardSnapshot::opponent(board.sideToMove) - 1];
+    uint64_t empty = board.getEmpty();
+
+    //one pass over the lines for the counts, wins and blocks
+    uint8_t mineIn[QubicBoard::NumLines];
+    uint8_t theirsIn[QubicBoard::NumLines];
+    uint64_t blocks = 0;
+    for (int line = 0; line < QubicBoard::NumLines; ++line)
+    {
+        uint64_t mask = QubicBoard::getLine(line);
+        int m = countIn(mine, mask);
+        int t = countIn(theirs, mask);
+        mineIn[line] = static_cast<uint8_t>(m);
+        theirsIn[line] = static_cast<uint8_t>(t);
+
+        if (m == 3 && !t)
+        {
+            out[0] = static_cast<uint8_t>(lowestCell(mask & empty));
+            return 1;
+        }
+        if (t == 3 && !m)
+            blocks |= mask & empty;
+    }
+
+    //two of them and we've lost, but block one anyway
+    if (blocks)
+    {
+        out[0] = static_cast<uint8_t>(lowestCell(blocks));
+        return 1;
+    }
+
+    int scores[QubicBoard::NumCells];
+    int count = 0;
+    for (uint64_t left = empty; left; left &= left - 1)
+    {
+        int cell = lowestCell(left);
+
+        //what it does for our open lines plus what it takes from theirs; a three is a threat they have to answer
+        int score = 0;
+        const uint8_t* lines = QubicBoard::getLinesThrough(cell);
+        for (int i = 0; i < QubicBoard::getNumLinesThrough(cell); ++i)
+        {
+            int m = mineIn[lines[i]];
+            int t = theirsIn[lines[i]];
+            if (!t)
+                score += LineWeights[m + 1] - LineWeights[m];
+            if (!m)
+                score += LineWeights[t];
+        }
+
+        //insertion sort, there's never more than 64
+        int slot = count++;
+        while (slot > 0 && scores[slot - 1] < score)
+        {
+            scores[slot] = scores[slot - 1];
+            out[slot] = out[slot - 1];
+            --slot;
+        }
+        scores[slot] = score;
+        out[slot] = static_cast<uint8_t>(cell);
+    }
+    return count;
+}
+
+int QubicSearch::negamax(QubicBoard& board, int depth, int alpha, int beta, int ply)
+{
+    if (++m_nodes % CheckEvery == 0 && m_limits->shouldStop())
+        m_stopped = true;
+    if (m_stopped)
+        return 0;
+
+    if (board.getEmpty() == 0)
+        return 0;
+    if (depth <= 0)
+        return evaluate(board);
+
+    uint8_t moves[QubicBoard::NumCells];
+    int numMoves = getMoves(board, moves);
+    for (int i = 0; i < numMoves; ++i)
+    {
+        board.play(moves[i]);
+        int score;
+        if (board.winner != BoardSnapshot::Empty)
+            score = WinScore - ply;
+        else
+            score = -negamax(board, depth - 1, -beta, -alpha, ply + 1);
+        board.undo(moves[i]);
+
+        if (score > alpha)
+        {
+            alpha = score;
+            if (alpha >= beta)
+                break;
+        }
+    }
+    return alpha;
+}
+
+QubicSearch::Result QubicSearch::decideMove(const QubicBoard& board, const AISearchLimits& limits)
+{
+    Result result;
+    if (board.isGameOver())
+        return result;
+
+    m_limits = &limits;
+    m_stopped = false;
+    m_nodes = 0;
+
+    QubicBoard position = board;
+    uint8_t moves[QubicBoard::NumCells];
+    int numMoves = getMoves(position, moves);
+    result.cell = moves[0];
+
+    //a forced move needs no search
+    if (numMoves == 1)
+        return result;
+
+    for (int depth = 1; depth <= m_maxDepth; ++depth)
+    {
+        int alpha = -WinScore - 1;
+        int best = moves[0];
+        for (int i = 0; i < numMoves && !m_stopped; ++i)
+        {
+            position.play(moves[i]);
+            int score = position.winner != BoardSnapshot::Empty ? WinScore : -negamax(position, depth - 1, -WinScore - 1, -alpha, 1);
+            position.undo(moves[i]);
+
+            if (!m_stopped && score > alpha)
+            {
+                alpha = score;
+                best = moves[i];
+            }
+        }
+
+        //a depth cut off part way doesn't count
+        if (m_stopped)
+            break;
+
+        result.cell = best;
+        result.score = alpha;
+        result.depth = depth;
+
+        //nothing deeper changes a win or a loss we can already see
+        if (alpha >= WinScore - m_maxDepth || alpha <= -WinScore + m_maxDepth)
+            break;
+
+        //the best goes first next time round
+        std::rotate(moves, std::find(moves, moves + numMoves, static_cast<uint8_t>(best)), std::find(moves, moves + numMoves, static_cast<uint8_t>(best)) + 1);
+    }
+
+    result.nodes = m_nodes;
+    return result;
+}
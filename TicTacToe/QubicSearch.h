@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AIStrategy.h"
+#include "QubicBoard.h"
+
+#include <cinttypes>
+
+//alpha-beta for qubic, deeper each time round until the limits say stop; the move the last
+//finished depth liked is tried first on the next.  A side that can finish a line does; a side
+//facing a line of three blocks it and tries nothing else, which is what lets this get deep
+//on a 64 cell board.  Everything else goes in order of what the lines through the cell are worth.
+//the evaluation counts, over all 76 lines, what each side has in the lines the other hasn't
+//touched; on bitboards that's two ands and two popcounts a line.
+class QubicSearch
+{
+public:
+    struct Result
+    {
+        Result() : cell(-1), score(0), depth(0), nodes(0) {}
+
+        int cell;           //-1 if the game's over
+        int score;          //for the side that moved
+        int depth;          //deepest search that finished
+        uint64_t nodes;
+    };
+
+    //anything past this is a win, less the plies it takes
+    static const int WinScore = 1 << 20;
+
+    explicit QubicSearch(int maxDepth = 12);
+
+    Result decideMove(const QubicBoard& board, const AISearchLimits& limits);
+
+protected:
+    int negamax(QubicBoard& board, int depth, int alpha, int beta, int ply);
+
+    //side to move's point of view
+    int evaluate(const QubicBoard& board) const;
+
+    //the moves worth trying, best first.  Just the one if there's a win or a block.
+    int getMoves(const QubicBoard& board, uint8_t* out) const;
+
+    int m_maxDepth;
+    const AISearchLimits* m_limits;
+    bool m_stopped;
+    uint64_t m_nodes;
+};
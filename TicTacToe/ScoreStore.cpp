@@ -0,0 +1,671 @@
+#include "ScoreStore.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+    //"TSLF" and "TSSS", little endian
+    const uint32_t FrameMagic = 0x464c5354;
+    const uint32_t SnapshotMagic = 0x53535354;
+    const uint32_t SnapshotVersion = 1;
+
+    //magic, payload size, crc, sequence.  The crc covers the sequence and the payload.
+    const size_t FrameHeaderSize = 20;
+    const size_t FrameCrcStart = 12;
+
+    const uint8_t NameRecord = 'N';
+    const uint8_t DeltaRecord = 'D';
+    const size_t DeltaRecordSize = 17;
+
+    //what one result would cost written on its own, for the write amplification
+    const double ResultRecordSize = 5.0;
+
+    uint32_t crc32(const uint8_t* data, size_t size)
+    {
+        static const std::array<uint32_t, 256> table = []() {
+            std::array<uint32_t, 256> result;
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit)
+                    value = (value & 1) ? (0xedb88320 ^ (value >> 1)) : (value >> 1);
+                result[i] = value;
+            }
+            return result;
+        }();
+
+        uint32_t crc = 0xffffffff;
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        return crc ^ 0xffffffff;
+    }
+
+    //files are little endian no matter what we run on
+    void putU16(std::vector<uint8_t>& out, uint16_t value)
+    {
+        out.push_back(static_cast<uint8_t>(value));
+        out.push_back(static_cast<uint8_t>(value >> 8));
+    }
+
+    void putU32(std::vector<uint8_t>& out, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+
+    void putU64(std::vector<uint8_t>& out, uint64_t value)
+    {
+        for (int i = 0; i < 8; ++i)
+            out.push_back(static_cast<uint8_t>(value >> (i * 8)));
+    }
+
+    void setU32(uint8_t* out, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+            out[i] = static_cast<uint8_t>(value >> (i * 8));
+    }
+
+    uint16_t getU16(const uint8_t* in)
+    {
+        return static_cast<uint16_t>(in[0] | (in[1] << 8));
+    }
+
+    uint32_t getU32(const uint8_t* in)
+    {
+        return uint32_t(in[0]) | (uint32_t(in[1]) << 8) | (uint32_t(in[2]) << 16) | (uint32_t(in[3]) << 24);
+    }
+
+    uint64_t getU64(const uint8_t* in)
+    {
+        return uint64_t(getU32(in)) | (uint64_t(getU32(in + 4)) << 32);
+    }
+
+    bool readFile(const std::string& path, std::vector<uint8_t>& bytes)
+    {
+        bytes.clear();
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file)
+            return false;
+
+        uint8_t chunk[64 * 1024];
+        size_t got;
+        while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0)
+            bytes.insert(bytes.end(), chunk, chunk + got);
+        fclose(file);
+        return true;
+    }
+
+    //all the way to the disk, not just the OS
+    bool syncFile(FILE* file)
+    {
+        if (fflush(file) != 0)
+            return false;
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    //atomic as far as anybody opening the file is concerned, it's the old one or the new one
+    bool replaceFile(const std::string& from, const std::string& to)
+    {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+    //held exclusively until unlockFile, -1 if somebody else has it (or it can't be made)
+    intptr_t lockFile(const std::string& path)
+    {
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        return handle == INVALID_HANDLE_VALUE ? -1 : reinterpret_cast<intptr_t>(handle);
+#else
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0)
+            return -1;
+        if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+#endif
+    }
+
+    void unlockFile(intptr_t lock)
+    {
+#ifdef _WIN32
+        CloseHandle(reinterpret_cast<HANDLE>(lock));
+#else
+        ::close(static_cast<int>(lock));
+#endif
+    }
+}
+
+double ScoreStore::Stats::getWriteAmplification() const
+{
+    if (!results)
+        return 0.0;
+    return double(logBytes + snapshotBytes) / (results * ResultRecordSize);
+}
+
+ScoreStore::ScoreStore(const Options& options) : m_options(options),
+    m_pendingResults(0),
+    m_namesLogged(0),
+    m_recorded(0),
+    m_durable(0),
+    m_attempted(0),
+    m_flushRequested(false),
+    m_stop(false),
+    m_sequence(0),
+    m_logSize(0),
+    m_log(nullptr),
+    m_lockFile(-1),
+    m_results(0),
+    m_commits(0),
+    m_logBytes(0),
+    m_snapshots(0),
+    m_snapshotBytes(0),
+    m_failedCommits(0),
+    m_recoveryNanos(0),
+    m_framesReplayed(0),
+    m_tornTail(false)
+{
+}
+
+ScoreStore::~ScoreStore()
+{
+    close();
+}
+
+bool ScoreStore::open()
+{
+    if (m_thread.joinable())
+        return true;
+
+    //before we so much as read the log, recovery rewrites it
+    m_lockFile = lockFile(getLockPath());
+    if (m_lockFile == -1)
+    {
+        fprintf(stderr, "scores at %s are already open somewhere else\n", m_options.path.c_str());
+        return false;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    if (!recover())
+    {
+        unlockFile(m_lockFile);
+        m_lockFile = -1;
+        return false;
+    }
+    m_recoveryNanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count();
+
+    //everybody starts from what's on disk
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_players = m_durablePlayers;
+        m_playerIds.clear();
+        m_pending.clear();
+        for (uint32_t id = 0; id < m_players.size(); ++id)
+        {
+            m_playerIds[m_players[id].name] = id;
+            m_pending.push_back(Delta());
+            m_pending.back().playerId = id;
+        }
+        m_namesLogged = static_cast<uint32_t>(m_players.size());
+        m_stop = false;
+    }
+
+    m_thread = std::thread([this]() {
+        run();
+    });
+    return true;
+}
+
+void ScoreStore::close()
+{
+    if (!m_thread.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+
+    if (m_log)
+    {
+        fclose(m_log);
+        m_log = nullptr;
+    }
+
+    unlockFile(m_lockFile);
+    m_lockFile = -1;
+}
+
+uint32_t ScoreStore::addPlayer(const std::string& name)
+{
+    uint32_t id = static_cast<uint32_t>(m_players.size());
+
+    Player player;
+    player.name = name;
+    m_players.push_back(player);
+    m_playerIds[name] = id;
+
+    m_pending.push_back(Delta());
+    m_pending.back().playerId = id;
+    return id;
+}
+
+uint32_t ScoreStore::getPlayerId(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_playerIds.find(name);
+    if (found != m_playerIds.end())
+        return found->second;
+    return addPlayer(name);
+}
+
+void ScoreStore::recordResult(uint32_t playerId, Outcome outcome)
+{
+    bool batchFull = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (playerId >= m_players.size())
+            return;
+
+        PlayerStats& stats = m_players[playerId].stats;
+        Delta& delta = m_pending[playerId];
+        if (!delta.wins && !delta.losses && !delta.draws)
+            m_touched.push_back(playerId);
+
+        switch (outcome)
+        {
+        case Win:
+            ++stats.wins;
+            ++delta.wins;
+            break;
+        case Loss:
+            ++stats.losses;
+            ++delta.losses;
+            break;
+        default:
+            ++stats.draws;
+            ++delta.draws;
+            break;
+        }
+
+        ++m_recorded;
+        batchFull = ++m_pendingResults >= m_options.maxBatchResults;
+    }
+
+    ++m_results;
+    if (batchFull)
+        m_wake.notify_one();
+}
+
+void ScoreStore::recordResult(const std::string& name, Outcome outcome)
+{
+    recordResult(getPlayerId(name), outcome);
+}
+
+bool ScoreStore::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t target = m_recorded;
+    if (!m_thread.joinable())
+        return m_durable >= target;
+
+    m_flushRequested = true;
+    m_wake.notify_one();
+    m_committed.wait(lock, [this, target]() {
+        return m_attempted >= target;
+    });
+    return m_durable >= target;
+}
+
+ScoreStore::PlayerStats ScoreStore::getPlayerStats(const std::string& name) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto found = m_playerIds.find(name);
+    if (found == m_playerIds.end())
+        return PlayerStats();
+    return m_players[found->second].stats;
+}
+
+ScoreStore::Stats ScoreStore::getStats() const
+{
+    Stats stats;
+    stats.results = m_results.load();
+    stats.commits = m_commits.load();
+    stats.logBytes = m_logBytes.load();
+    stats.snapshots = m_snapshots.load();
+    stats.snapshotBytes = m_snapshotBytes.load();
+    stats.failedCommits = m_failedCommits.load();
+    stats.recoveryNanos = m_recoveryNanos;
+    stats.framesReplayed = m_framesReplayed;
+    stats.tornTail = m_tornTail;
+    return stats;
+}
+
+void ScoreStore::applyDelta(const Delta& delta)
+{
+    if (delta.playerId >= m_durablePlayers.size())
+        return;
+
+    PlayerStats& stats = m_durablePlayers[delta.playerId].stats;
+    stats.wins += delta.wins;
+    stats.losses += delta.losses;
+    stats.draws += delta.draws;
+}
+
+bool ScoreStore::recover()
+{
+    m_durablePlayers.clear();
+    m_sequence = 0;
+    m_framesReplayed = 0;
+    m_tornTail = false;
+
+    std::vector<uint8_t> bytes;
+    if (readFile(getSnapshotPath(), bytes))
+    {
+        //it only ever shows up by rename, so it's whole unless something else went badly wrong
+        bool valid = bytes.size() >= 24 && getU32(&bytes[0]) == SnapshotMagic && getU32(&bytes[4]) == SnapshotVersion &&
+            crc32(bytes.data(), bytes.size() - 4) == getU32(&bytes[bytes.size() - 4]);
+
+        if (valid)
+        {
+            m_sequence = getU64(&bytes[8]);
+            uint32_t numPlayers = getU32(&bytes[16]);
+            size_t offset = 20;
+            size_t end = bytes.size() - 4;
+            for (uint32_t i = 0; i < numPlayers && valid; ++i)
+            {
+                valid = offset + 2 <= end;
+                if (!valid)
+                    break;
+                uint16_t nameSize = getU16(&bytes[offset]);
+                offset += 2;
+
+                valid = offset + nameSize + 24 <= end;
+                if (!valid)
+                    break;
+
+                Player player;
+                player.name.assign(reinterpret_cast<const char*>(&bytes[offset]), nameSize);
+                offset += nameSize;
+                player.stats.wins = getU64(&bytes[offset]);
+                player.stats.losses = getU64(&bytes[offset + 8]);
+                player.stats.draws = getU64(&bytes[offset + 16]);
+                offset += 24;
+                m_durablePlayers.push_back(player);
+            }
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "score snapshot %s is damaged, starting from the log alone\n", getSnapshotPath().c_str());
+            m_durablePlayers.clear();
+            m_sequence = 0;
+        }
+    }
+
+    if (readFile(getLogPath(), bytes))
+    {
+        size_t offset = 0;
+        while (offset < bytes.size())
+        {
+            //anything that doesn't check out is where the last write got cut off
+            size_t remaining = bytes.size() - offset;
+            if (remaining < FrameHeaderSize || getU32(&bytes[offset]) != FrameMagic)
+            {
+                m_tornTail = true;
+                break;
+            }
+
+            uint32_t payloadSize = getU32(&bytes[offset + 4]);
+            if (remaining - FrameHeaderSize < payloadSize ||
+                crc32(&bytes[offset + FrameCrcStart], (FrameHeaderSize - FrameCrcStart) + payloadSize) != getU32(&bytes[offset + 8]))
+            {
+                m_tornTail = true;
+                break;
+            }
+
+            //the snapshot might already have it, if we went down between writing one and starting the log over
+            uint64_t sequence = getU64(&bytes[offset + FrameCrcStart]);
+            if (sequence > m_sequence)
+            {
+                const uint8_t* payload = &bytes[offset + FrameHeaderSize];
+                size_t at = 0;
+                while (at < payloadSize)
+                {
+                    if (payload[at] == NameRecord && at + 7 <= payloadSize)
+                    {
+                        uint16_t nameSize = getU16(&payload[at + 5]);
+                        if (at + 7 + nameSize > payloadSize)
+                            break;
+
+                        //ids are handed out in order, so the next name is always the next id
+                        Player player;
+                        player.name.assign(reinterpret_cast<const char*>(&payload[at + 7]), nameSize);
+                        if (getU32(&payload[at + 1]) == m_durablePlayers.size())
+                            m_durablePlayers.push_back(player);
+                        at += 7 + nameSize;
+                    }
+                    else if (payload[at] == DeltaRecord && at + DeltaRecordSize <= payloadSize)
+                    {
+                        Delta delta;
+                        delta.playerId = getU32(&payload[at + 1]);
+                        delta.wins = getU32(&payload[at + 5]);
+                        delta.losses = getU32(&payload[at + 9]);
+                        delta.draws = getU32(&payload[at + 13]);
+                        applyDelta(delta);
+                        at += DeltaRecordSize;
+                    }
+                    else
+                    {
+                        break;
+                    }
+                }
+
+                m_sequence = sequence;
+                ++m_framesReplayed;
+            }
+
+            offset += FrameHeaderSize + payloadSize;
+        }
+    }
+
+    //fold whatever the log had into a fresh snapshot and start the log over.  The next recovery
+    //stays short, and new frames don't end up stranded behind a torn one.
+    if (m_framesReplayed || m_tornTail)
+        return writeSnapshot();
+
+    m_log = fopen(getLogPath().c_str(), "ab");
+    if (!m_log)
+        return false;
+
+    fseek(m_log, 0, SEEK_END);
+    m_logSize = static_cast<uint64_t>(ftell(m_log));
+    return true;
+}
+
+bool ScoreStore::writeSnapshot()
+{
+    std::vector<uint8_t> bytes;
+    putU32(bytes, SnapshotMagic);
+    putU32(bytes, SnapshotVersion);
+    putU64(bytes, m_sequence);
+    putU32(bytes, static_cast<uint32_t>(m_durablePlayers.size()));
+    for (auto&& player : m_durablePlayers)
+    {
+        //names past 64k get cut, nobody's going to notice
+        uint16_t nameSize = static_cast<uint16_t>(std::min<size_t>(player.name.size(), 0xffff));
+        putU16(bytes, nameSize);
+        bytes.insert(bytes.end(), player.name.begin(), player.name.begin() + nameSize);
+        putU64(bytes, player.stats.wins);
+        putU64(bytes, player.stats.losses);
+        putU64(bytes, player.stats.draws);
+    }
+    putU32(bytes, crc32(bytes.data(), bytes.size()));
+
+    //written off to the side and swapped in whole, so there's always one good snapshot
+    std::string tempPath = getSnapshotPath() + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() && syncFile(file);
+    fclose(file);
+    if (!written || !replaceFile(tempPath, getSnapshotPath()))
+        return false;
+
+    ++m_snapshots;
+    m_snapshotBytes += bytes.size();
+
+    //everything the log had is in the snapshot now
+    if (m_log)
+        fclose(m_log);
+    m_log = fopen(getLogPath().c_str(), "wb");
+    m_logSize = 0;
+    return m_log != nullptr;
+}
+
+void ScoreStore::run()
+{
+    std::vector<std::string> names;
+    std::vector<Delta> deltas;
+    std::vector<uint8_t> frame;
+    bool failed = false;
+
+    //a write that failed may have left part of a frame on the end of the log, and anything appended
+    //after it would be thrown away with it by the next recovery.  So nothing more goes in the log
+    //until a snapshot (which has everything, and starts the log over) makes it out.
+    bool needSnapshot = false;
+
+    while (true)
+    {
+        uint32_t firstNewId;
+        uint64_t upTo;
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_for(lock, m_options.commitInterval, [this]() {
+                return m_stop || m_flushRequested || m_pendingResults >= m_options.maxBatchResults;
+            });
+
+            //take the whole batch and let the recorders carry on while we write it
+            names.clear();
+            firstNewId = m_namesLogged;
+            for (uint32_t id = m_namesLogged; id < m_players.size(); ++id)
+                names.push_back(m_players[id].name);
+            m_namesLogged = static_cast<uint32_t>(m_players.size());
+
+            deltas.clear();
+            for (auto&& id : m_touched)
+            {
+                deltas.push_back(m_pending[id]);
+                m_pending[id] = Delta();
+                m_pending[id].playerId = id;
+            }
+            m_touched.clear();
+            m_pendingResults = 0;
+
+            upTo = m_recorded;
+            m_flushRequested = false;
+            stopping = m_stop;
+        }
+
+        bool written = true;
+        if (!names.empty() || !deltas.empty())
+        {
+            frame.assign(FrameHeaderSize, 0);
+
+            for (size_t i = 0; i < names.size(); ++i)
+            {
+                uint16_t nameSize = static_cast<uint16_t>(std::min<size_t>(names[i].size(), 0xffff));
+                frame.push_back(NameRecord);
+                putU32(frame, firstNewId + static_cast<uint32_t>(i));
+                putU16(frame, nameSize);
+                frame.insert(frame.end(), names[i].begin(), names[i].begin() + nameSize);
+
+                Player player;
+                player.name = names[i].substr(0, nameSize);
+                m_durablePlayers.push_back(player);
+            }
+
+            for (auto&& delta : deltas)
+            {
+                frame.push_back(DeltaRecord);
+                putU32(frame, delta.playerId);
+                putU32(frame, delta.wins);
+                putU32(frame, delta.losses);
+                putU32(frame, delta.draws);
+                applyDelta(delta);
+            }
+
+            ++m_sequence;
+            setU32(&frame[0], FrameMagic);
+            setU32(&frame[4], static_cast<uint32_t>(frame.size() - FrameHeaderSize));
+            for (int i = 0; i < 8; ++i)
+                frame[FrameCrcStart + i] = static_cast<uint8_t>(m_sequence >> (i * 8));
+            setU32(&frame[8], crc32(&frame[FrameCrcStart], frame.size() - FrameCrcStart));
+
+            //one write and one sync for the whole batch, that's the group commit
+            if (!needSnapshot)
+            {
+                written = m_log && fwrite(frame.data(), 1, frame.size(), m_log) == frame.size() && syncFile(m_log);
+                if (written)
+                {
+                    m_logSize += frame.size();
+                    m_logBytes += frame.size();
+                    ++m_commits;
+                }
+                else
+                {
+                    ++m_failedCommits;
+                    needSnapshot = true;
+                }
+            }
+        }
+
+        //m_durablePlayers already has the batch in it, so a snapshot covers whatever didn't make the log
+        if (needSnapshot || m_logSize >= m_options.snapshotLogBytes)
+        {
+            written = writeSnapshot();
+            needSnapshot = !written;
+        }
+
+        //keep going in memory and keep retrying, but say something once
+        if (!written && !failed)
+            fprintf(stderr, "couldn't write scores to %s, retrying; until then they won't survive a restart\n", getLogPath().c_str());
+        failed = !written;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_attempted = upTo;
+            if (written)
+                m_durable = upTo;
+        }
+        m_committed.notify_all();
+
+        if (stopping)
+            break;
+    }
+}
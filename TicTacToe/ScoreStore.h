@@ -0,0 +1,167 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+//win/loss/draw counts per player that survive a restart (or a crash).
+//recording a result only touches memory.  A writer thread group commits whatever piled up every
+//few milliseconds as one checksummed frame on the end of an append only log, one fsync per frame.
+//a frame holds the net change per player for its batch, so a thousand games between the same two
+//players cost two small records, not a thousand.
+//once the log gets big the writer rolls it into a snapshot (written off to the side, then renamed
+//over the old one) and starts the log over.  Opening loads the snapshot and replays the log frames
+//after it, stopping at the first torn or corrupt one: a crash loses at most the last commit
+//interval, and never anything that was already committed.
+class ScoreStore
+{
+public:
+    enum Outcome : uint8_t
+    {
+        Win,
+        Loss,
+        Draw
+    };
+
+    struct PlayerStats
+    {
+        PlayerStats() : wins(0), losses(0), draws(0) {}
+
+        uint64_t getGames() const { return wins + losses + draws; }
+
+        uint64_t wins;
+        uint64_t losses;
+        uint64_t draws;
+    };
+
+    struct Options
+    {
+        Options() : commitInterval(10), maxBatchResults(4096), snapshotLogBytes(1 << 20) {}
+
+        std::string path;                           //the log is path.log, the snapshot path.snapshot
+        std::chrono::milliseconds commitInterval;   //the longest a result waits to be written
+        size_t maxBatchResults;                     //commit early once this many pile up
+        uint64_t snapshotLogBytes;                  //roll the log into a snapshot past this size
+    };
+
+    struct Stats
+    {
+        uint64_t results;           //recorded since open
+        uint64_t commits;           //log frames written, an fsync each
+        uint64_t logBytes;          //written to the log since open
+        uint64_t snapshots;
+        uint64_t snapshotBytes;     //written to snapshots since open
+        uint64_t failedCommits;     //batches that didn't make it to disk the first time
+        uint64_t recoveryNanos;     //loading the snapshot and replaying the log in open()
+        uint64_t framesReplayed;
+        bool tornTail;              //open() found a partial or corrupt frame at the end of the log and dropped it
+
+        //bytes that hit the disk per byte of results, counting a result as a 5 byte record (id and outcome)
+        double getWriteAmplification() const;
+    };
+
+    ScoreStore(const Options& options);
+
+    //commits anything still outstanding
+    ~ScoreStore();
+
+    //recovers from the files (creating them if need be) and starts the writer.  False if we can't write
+    //there, or another store (in this process or any other) already has them open: path.lock is held
+    //for as long as we're open, so two writers can't cut each other's log off.
+    bool open();
+    void close();
+
+    //safe from any thread, none of these wait on the disk.  Ids stay the same for the life of the store.
+    uint32_t getPlayerId(const std::string& name);
+    void recordResult(uint32_t playerId, Outcome outcome);
+    void recordResult(const std::string& name, Outcome outcome);
+
+    //blocks until everything recorded so far is on disk, or the writer has given up on it.  False
+    //if it isn't there (the disk is full, say); the writer keeps retrying with a snapshot.
+    bool flush();
+
+    PlayerStats getPlayerStats(const std::string& name) const;
+    Stats getStats() const;
+
+    std::string getLogPath() const { return m_options.path + ".log"; }
+    std::string getSnapshotPath() const { return m_options.path + ".snapshot"; }
+    std::string getLockPath() const { return m_options.path + ".lock"; }
+
+protected:
+    struct Player
+    {
+        std::string name;
+        PlayerStats stats;
+    };
+
+    //a batch's worth of change for one player
+    struct Delta
+    {
+        Delta() : playerId(0), wins(0), losses(0), draws(0) {}
+
+        uint32_t playerId;
+        uint32_t wins;
+        uint32_t losses;
+        uint32_t draws;
+    };
+
+    //must hold m_mutex
+    uint32_t addPlayer(const std::string& name);
+
+    void run();
+
+    //writer thread (or open, before it starts) only
+    bool recover();
+    bool writeSnapshot();
+    void applyDelta(const Delta& delta);
+
+    Options m_options;
+
+    //what everybody reads and records into, under m_mutex
+    mutable std::mutex m_mutex;
+    std::vector<Player> m_players;
+    std::unordered_map<std::string, uint32_t> m_playerIds;
+
+    //waiting for the writer.  Indexed by player id; m_touched lists the ones with anything in them.
+    std::vector<Delta> m_pending;
+    std::vector<uint32_t> m_touched;
+    size_t m_pendingResults;
+    uint32_t m_namesLogged;     //players below this are already in the log or the snapshot
+
+    uint64_t m_recorded;        //results recorded, ever
+    uint64_t m_durable;         //results on disk, ever
+    uint64_t m_attempted;       //results the writer has had a go at, on disk or not
+    bool m_flushRequested;
+    bool m_stop;
+
+    std::condition_variable m_wake;
+    std::condition_variable m_committed;
+
+    //writer thread only: what's on disk, which is what snapshots are made of
+    std::vector<Player> m_durablePlayers;
+    uint64_t m_sequence;
+    uint64_t m_logSize;
+    FILE* m_log;
+
+    //the OS handle that holds path.lock, -1 when we aren't open
+    intptr_t m_lockFile;
+
+    std::thread m_thread;
+
+    std::atomic<uint64_t> m_results;
+    std::atomic<uint64_t> m_commits;
+    std::atomic<uint64_t> m_logBytes;
+    std::atomic<uint64_t> m_snapshots;
+    std::atomic<uint64_t> m_snapshotBytes;
+    std::atomic<uint64_t> m_failedCommits;
+    uint64_t m_recoveryNanos;
+    uint64_t m_framesReplayed;
+    bool m_tornTail;
+};
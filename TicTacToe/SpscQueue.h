@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+//fixed size, lock free queue for exactly one producer thread and one consumer thread.
+//neither side ever waits on the other: push fails when it's full, pop comes back empty.
+//the two indexes live on their own cache lines so the threads aren't fighting over one,
+//and each side keeps a stale copy of the other's index so it only has to look when it
+//thinks it's out of room (or out of items).
+template <class T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity has to be a power of two");
+
+public:
+    SpscQueue() : m_head(0), m_cachedTail(0), m_tail(0), m_cachedHead(0) {}
+
+    //producer only
+    bool push(const T& item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == Capacity)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == Capacity)
+                return false;
+        }
+
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //consumer only.  Takes up to maxItems, oldest first, returns how many it got.
+    size_t popBatch(T* out, size_t maxItems)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (m_cachedTail == head)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (m_cachedTail == head)
+                return 0;
+        }
+
+        size_t count = m_cachedTail - head;
+        if (count > maxItems)
+            count = maxItems;
+
+        for (size_t i = 0; i < count; ++i)
+            out[i] = m_items[(head + i) & (Capacity - 1)];
+
+        m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    //consumer only
+    bool pop(T& out)
+    {
+        return popBatch(&out, 1) == 1;
+    }
+
+protected:
+    //written by the consumer
+    alignas(64) std::atomic<size_t> m_head;
+    size_t m_cachedTail;
+
+    //written by the producer
+    alignas(64) std::atomic<size_t> m_tail;
+    size_t m_cachedHead;
+
+    alignas(64) T m_items[Capacity];
+};
@@ -0,0 +1,115 @@
+#include "StartupTrace.h"
+
+#include <QDebug>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Milestone
+    {
+        std::string name;
+        std::chrono::nanoseconds at;
+    };
+
+    struct Trace
+    {
+        Trace() : started(std::chrono::steady_clock::now()), interactiveNanos(-1) {}
+
+        std::mutex mutex;
+        std::chrono::steady_clock::time_point started;
+        std::vector<Milestone> milestones;
+        std::atomic<int64_t> interactiveNanos;
+    };
+
+    Trace& getTrace()
+    {
+        static Trace trace;
+        return trace;
+    }
+
+    double toMillis(std::chrono::nanoseconds nanos)
+    {
+        return nanos.count() / 1000000.0;
+    }
+}
+
+void StartupTrace::start()
+{
+    Trace& trace = getTrace();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+    trace.started = std::chrono::steady_clock::now();
+    trace.milestones.clear();
+    trace.interactiveNanos = -1;
+}
+
+void StartupTrace::mark(const char* name)
+{
+    Trace& trace = getTrace();
+    std::lock_guard<std::mutex> lock(trace.mutex);
+
+    Milestone milestone;
+    milestone.name = name;
+    milestone.at = std::chrono::steady_clock::now() - trace.started;
+    trace.milestones.push_back(milestone);
+}
+
+void StartupTrace::finish()
+{
+    if (isFinished())
+        return;
+
+    mark("first interactive frame");
+
+    Trace& trace = getTrace();
+    {
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        trace.interactiveNanos = trace.milestones.back().at.count();
+    }
+
+    qDebug() << toString().c_str();
+}
+
+bool StartupTrace::isFinished()
+{
+    return getTrace().interactiveNanos >= 0;
+}
+
+std::chrono::nanoseconds StartupTrace::getTimeToInteractive()
+{
+    return std::chrono::nanoseconds(getTrace().interactiveNanos.load());
+}
+
+std::string StartupTrace::toString()
+{
+    Trace& trace = getTrace();
+    std::vector<Milestone> milestones;
+    {
+        std::lock_guard<std::mutex> lock(trace.mutex);
+        milestones = trace.milestones;
+    }
+
+    //the background jobs can check in a little out of order
+    std::stable_sort(milestones.begin(), milestones.end(), [](const Milestone& a, const Milestone& b) {
+        return a.at < b.at;
+    });
+
+    std::string result;
+    char line[128];
+    if (isFinished())
+    {
+        snprintf(line, sizeof(line), "startup: first interactive frame after %.1f ms\n", toMillis(getTimeToInteractive()));
+        result += line;
+    }
+
+    for (auto&& milestone : milestones)
+    {
+        snprintf(line, sizeof(line), "%10.1f ms  %s\n", toMillis(milestone.at), milestone.name.c_str());
+        result += line;
+    }
+    return result;
+}
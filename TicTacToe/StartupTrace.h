@@ -0,0 +1,25 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+//milestones from the top of main to the first frame you can actually click on.
+//mark() is safe from any thread, so the jobs that run in the background while the window comes
+//up can check in too.  The whole trace gets logged once the first interactive frame lands.
+class StartupTrace
+{
+public:
+    //top of main, everything is measured from here
+    static void start();
+
+    static void mark(const char* name);
+
+    //the first frame that takes clicks, marks it and logs the trace so far
+    static void finish();
+
+    static bool isFinished();
+    static std::chrono::nanoseconds getTimeToInteractive();
+
+    //one milestone a line, in the order they happened
+    static std::string toString();
+};
@@ -2,6 +2,9 @@
 
 #include "GameMoveManager.h"
 #include "GraphicsThread.h"
+#include "StartupTrace.h"
+
+#include <QtConcurrent/QtConcurrentRun>
 TApp::TApp(int argc, char *argv[]) : QApplication(argc, argv),
     m_graphicsThread(nullptr),
     m_gameManager(nullptr)
@@ -11,10 +14,18 @@ TApp::TApp(int argc, char *argv[]) : QApplication(argc, argv),
 
     m_gameManager = new GameMoveManager(this);
     m_gameManager->start();
+    StartupTrace::mark("game manager started");
+
+    //nobody needs the AI tables until somebody picks that AI, but there's no reason to wait
+    QtConcurrent::run([]() {
+        AIStrategy::prepareTables();
+        StartupTrace::mark("AI tables built");
+    });
 
     m_graphicsThread = new GraphicsThread();
     m_graphicsThread->start();
     m_graphicsThread->moveToThread(m_graphicsThread);
+    StartupTrace::mark("graphics thread started");
 }
 
 TApp::~TApp()
@@ -1,15 +1,22 @@
 
 #include <QMessageBox>
 #include <QVBoxLayout>
+#include <QActionGroup>
+#include <QInputDialog>
+#include <QFileDialog>
+#include <QDebug>
 
 #include <osgQt/GraphicsWindowQt>
 
 
 #include "TMainWindow.h"
 #include "TApp.h"
+#include "BoardMonitor.h"
+#include "BoardThumbnailAtlas.h"
 #include "OSGViewerWidget.h"
 #include "GraphicsThread.h"
 #include "GameMoveManager.h"
+#include "StartupTrace.h"
 #include <QOpenGLContext>
 
 TMainWindow::TMainWindow(QWidget *parent)
@@ -22,6 +29,11 @@ TMainWindow::TMainWindow(QWidget *parent)
     //create my openGL widget and put in the center
     createOpenGLContext();
 
+    createGameMenu();
+    createAIMenu();
+    createMonitorMenu();
+    createRenderingMenu();
+
     //Tool Bar Actions
     connect(m_ui.actionNew_Game, SIGNAL(triggered(bool)), this, SLOT(handleNewGame()));
     connect(m_ui.actionUndo, SIGNAL(triggered(bool)), this, SLOT(handleUndo()));
@@ -36,15 +48,16 @@ TMainWindow::~TMainWindow()
     //tell graphics that we want our viewer back
     tApp->getGraphicsThread()->setOSGViewer(nullptr);
 
-    auto mainThread = QThread::currentThread();
-    auto osgViewer = m_glWidget;
+    auto viewerWidget = m_glWidget;
 
-    tApp->getGraphicsThread()->addTaskBlocking([mainThread, osgViewer]() {
-        //move to our thread
-        auto glWidgetList = osgViewer->getGLWidgets();
-        for (auto&& glWidget : glWidgetList)
-            glWidget->context()->moveToThread(mainThread);
+    tApp->getGraphicsThread()->addTaskBlocking([viewerWidget]() {
+        //any draw threads give the contexts up when they stop, then we let go of them too
+        viewerWidget->setThreadingModel(osgViewer::ViewerBase::SingleThreaded);
+        viewerWidget->releaseContexts();
     });
+
+    //move to our thread
+    viewerWidget->adoptContexts();
 }
 
 
@@ -68,7 +81,8 @@ void TMainWindow::handleAbout()
 
 void TMainWindow::handleUndo()
 {
-
+    if (!tApp->getGameManager()->undoLastMove())
+        tApp->getGraphicsThread()->setUserMessage("Nothing to undo!");
 }
 
 void TMainWindow::handleNewGame()
@@ -79,10 +93,188 @@ void TMainWindow::handleNewGame()
     });
 }
 
+void TMainWindow::handleAIStrategyChanged(QAction* action)
+{
+    auto type = static_cast<AIStrategy::Type>(action->data().toInt());
+    tApp->getGameManager()->setAIStrategy(AIStrategy::create(type));
+}
+
+void TMainWindow::handleVariantChanged(QAction* action)
+{
+    auto variant = static_cast<GameMoveManager::Variant>(action->data().toInt());
+    tApp->getGameManager()->setVariant(variant);
+    tApp->getGraphicsThread()->setVariant(variant);
+}
+
+void TMainWindow::createGameMenu()
+{
+    QMenu* gameMenu = m_ui.menuBar->addMenu("Game");
+
+    QActionGroup* variants = new QActionGroup(this);
+    variants->setExclusive(true);
+
+    QAction* classic = gameMenu->addAction("Classic");
+    classic->setCheckable(true);
+    classic->setChecked(true);
+    classic->setData(GameMoveManager::Classic);
+    variants->addAction(classic);
+
+    //the AI menu only picks the classic opponent, the others always play their own searches
+    QAction* ultimate = gameMenu->addAction("Ultimate");
+    ultimate->setCheckable(true);
+    ultimate->setData(GameMoveManager::Ultimate);
+    variants->addAction(ultimate);
+
+    QAction* qubic = gameMenu->addAction("Qubic (4x4x4)");
+    qubic->setCheckable(true);
+    qubic->setData(GameMoveManager::Qubic);
+    variants->addAction(qubic);
+
+    connect(variants, SIGNAL(triggered(QAction*)), this, SLOT(handleVariantChanged(QAction*)));
+}
+
+void TMainWindow::createAIMenu()
+{
+    QMenu* aiMenu = m_ui.menuBar->addMenu("AI");
+
+    //one checkable action per strategy, only one can be picked at a time
+    QActionGroup* strategies = new QActionGroup(this);
+    strategies->setExclusive(true);
+
+    auto currentType = tApp->getGameManager()->getAIStrategy()->getType();
+    for (int type = 0; type < AIStrategy::NumTypes; ++type)
+    {
+        QAction* action = aiMenu->addAction(AIStrategy::getTypeName(static_cast<AIStrategy::Type>(type)));
+        action->setCheckable(true);
+        action->setChecked(type == currentType);
+        action->setData(type);
+        strategies->addAction(action);
+    }
+
+    connect(strategies, SIGNAL(triggered(QAction*)), this, SLOT(handleAIStrategyChanged(QAction*)));
+}
+
+void TMainWindow::createMonitorMenu()
+{
+    QMenu* monitorMenu = m_ui.menuBar->addMenu("Monitor");
+
+    QAction* watch = monitorMenu->addAction("Watch Server Games...");
+    connect(watch, SIGNAL(triggered(bool)), this, SLOT(handleWatchServer()));
+
+    QAction* stop = monitorMenu->addAction("Back To My Game");
+    connect(stop, SIGNAL(triggered(bool)), this, SLOT(handleStopWatching()));
+
+    monitorMenu->addSeparator();
+
+    QAction* thumbnails = monitorMenu->addAction("Save Board Thumbnails...");
+    connect(thumbnails, SIGNAL(triggered(bool)), this, SLOT(handleSaveThumbnails()));
+}
+
+void TMainWindow::handleWatchServer()
+{
+    bool ok = false;
+    QString address = QInputDialog::getText(this, "Watch Server Games", "Server (host:port):", QLineEdit::Normal, "127.0.0.1:7777", &ok);
+    if (!ok || address.isEmpty())
+        return;
+
+    int numGames = QInputDialog::getInt(this, "Watch Server Games", "Games to watch, starting at game 1:", 100, 1, 10000, 1, &ok);
+    if (!ok)
+        return;
+
+    BoardMonitor::Options options;
+    QStringList hostPort = address.split(':');
+    options.host = hostPort.value(0).toStdString();
+    if (hostPort.size() > 1)
+        options.port = static_cast<uint16_t>(hostPort.value(1).toUInt());
+    options.numGames = numGames;
+
+    //it connects on its own thread, the tiles fill in as the snapshots arrive
+    std::shared_ptr<BoardMonitor> monitor = std::make_shared<BoardMonitor>(options);
+    monitor->start();
+    tApp->getGraphicsThread()->setMonitor(monitor);
+    m_monitor = monitor;
+}
+
+void TMainWindow::handleStopWatching()
+{
+    tApp->getGraphicsThread()->setMonitor(nullptr);
+    m_monitor.reset();
+}
+
+void TMainWindow::handleSaveThumbnails()
+{
+    if (!m_monitor)
+    {
+        QMessageBox::information(this, "Save Board Thumbnails", "Watch some server games first.");
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(this, "Save Board Thumbnails", "thumbnails.png", "Images (*.png)");
+    if (fileName.isEmpty())
+        return;
+
+    //the monitor's boards are atomics, reading them from here is fine
+    std::vector<BoardSnapshot> boards(m_monitor->getNumGames());
+    for (int i = 0; i < m_monitor->getNumGames(); ++i)
+        boards[i] = BoardMonitor::unpackBoardState(m_monitor->getBoardState(i));
+
+    if (!m_thumbnails)
+        m_thumbnails.reset(new BoardThumbnailAtlas(BoardThumbnailAtlas::loadIcon(BoardSnapshot::Player), BoardThumbnailAtlas::loadIcon(BoardSnapshot::AI)));
+
+    const QImage& atlas = m_thumbnails->render(boards.data(), static_cast<int>(boards.size()));
+    qDebug() << "thumbnails:" << m_thumbnails->getTilesDrawn() << "drawn," << m_thumbnails->getTilesCopied() << "copied";
+    if (!atlas.save(fileName))
+        QMessageBox::warning(this, "Save Board Thumbnails", "Couldn't write " + fileName);
+}
+
+void TMainWindow::createRenderingMenu()
+{
+    QMenu* renderingMenu = m_ui.menuBar->addMenu("Rendering");
+
+    QActionGroup* threadingModels = new QActionGroup(this);
+    threadingModels->setExclusive(true);
+
+    const osgViewer::ViewerBase::ThreadingModel models[] = {
+        osgViewer::ViewerBase::SingleThreaded,
+        osgViewer::ViewerBase::CullDrawThreadPerContext,
+        osgViewer::ViewerBase::DrawThreadPerContext,
+        osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext
+    };
+
+    for (auto&& model : models)
+    {
+        QAction* action = renderingMenu->addAction(OSGViewerWidget::getThreadingModelName(model));
+        action->setCheckable(true);
+        action->setChecked(model == m_glWidget->getThreadingModel());
+        action->setData(static_cast<int>(model));
+        threadingModels->addAction(action);
+    }
+
+    connect(threadingModels, SIGNAL(triggered(QAction*)), this, SLOT(handleThreadingModelChanged(QAction*)));
+
+    renderingMenu->addSeparator();
+
+    QAction* benchmark = renderingMenu->addAction("Benchmark Threading Models");
+    connect(benchmark, SIGNAL(triggered(bool)), this, SLOT(handleThreadingBenchmark()));
+}
+
+void TMainWindow::handleThreadingModelChanged(QAction* action)
+{
+    auto model = static_cast<osgViewer::ViewerBase::ThreadingModel>(action->data().toInt());
+    tApp->getGraphicsThread()->setThreadingModel(model);
+}
+
+void TMainWindow::handleThreadingBenchmark()
+{
+    //a few seconds each, it puts the model that's picked back when it's done
+    tApp->getGraphicsThread()->startThreadingBenchmark(5, false);
+}
+
 void TMainWindow::createOpenGLContext()
 {
     //create gl context widget
     m_glWidget = new OSGViewerWidget(this);
+    StartupTrace::mark("viewer widget created");
 
     //set main layout
     QVBoxLayout* mainLayout = new QVBoxLayout();
@@ -100,15 +292,15 @@ void TMainWindow::createOpenGLContext()
     //swapping buffers on hidden objects.
     osgViewer->frame();
     QApplication::processEvents();
+    StartupTrace::mark("first frame on main thread");
 
-    //move to graphics thread
-    auto glWidgetList = osgViewer->getGLWidgets();
-    for (auto&& glWidget : glWidgetList)
-        glWidget->context()->moveToThread(tApp->getGraphicsThread());
+    //let go of the contexts, the graphics thread takes them the first time it draws
+    osgViewer->releaseContexts();
 
 
-    //move graphics to current thread
-    tApp->getGraphicsThread()->addTaskBlocking([osgViewer]() {
+    //move graphics to current thread.  No need to wait on it, the window can come up while the
+    //graphics thread builds the scene, and anything asked of it after this queues up behind it.
+    tApp->getGraphicsThread()->addTask([osgViewer]() {
         tApp->getGraphicsThread()->setOSGViewer(osgViewer);
         tApp->getGraphicsThread()->init();
     });
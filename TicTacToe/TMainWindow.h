@@ -2,9 +2,13 @@
 
 #include <QtWidgets/QMainWindow>
 
+#include <memory>
+
 //ui
 #include "ui_TMainWindow.h"
 
+class BoardMonitor;
+class BoardThumbnailAtlas;
 class OSGViewerWidget;
 
 class TMainWindow : public QMainWindow
@@ -20,13 +24,34 @@ protected slots:
     void handleAbout();
     void handleUndo();
     void handleNewGame();
+    void handleAIStrategyChanged(QAction* action);
+    void handleVariantChanged(QAction* action);
+    void handleWatchServer();
+    void handleStopWatching();
+    void handleSaveThumbnails();
+    void handleThreadingModelChanged(QAction* action);
+    void handleThreadingBenchmark();
 
 protected:
     void createOpenGLContext();
 
+    void createGameMenu();
+
+    void createAIMenu();
+
+    void createMonitorMenu();
+
+    void createRenderingMenu();
+
 private:
 
     OSGViewerWidget* m_glWidget;
 
+    //what we're watching, if anything, for the thumbnails.  The graphics thread has its own copy.
+    std::shared_ptr<BoardMonitor> m_monitor;
+
+    //kept between saves so only the boards that changed are drawn again
+    std::unique_ptr<BoardThumbnailAtlas> m_thumbnails;
+
     Ui::TicTacToeClass m_ui;
 };
@@ -0,0 +1,253 @@
+#include "ThreatSearch.h"
+
+#include <algorithm>
+
+namespace
+{
+    //a win right here is a win
+    const int WinNow = 1 << 30;
+
+    //ahead of anything the line weights could add up to on a sane board
+    const int DoubleThreatBonus = 1 << 24;
+    const int FourBonus = 1 << 22;
+
+    //the cells that win for side right now, no repeats
+    int collectFourCells(const LineBoard& board, uint8_t side, int* out, int maxOut)
+    {
+        int count = 0;
+        for (int i = 0; i < board.getNumFours(side) && count < maxOut; ++i)
+        {
+            int cell = board.getFourCell(side, i);
+            if (std::find(out, out + count, cell) == out + count)
+                out[count++] = cell;
+        }
+        return count;
+    }
+}
+
+ThreatSearch::ThreatSearch(const Options& options) : m_options(options), m_nodes(0)
+{
+}
+
+ThreatSearch::Result ThreatSearch::search(LineBoard& board, uint8_t side)
+{
+    Result result;
+    m_nodes = 0;
+    if (board.winner() != BoardSnapshot::Empty || board.isFull())
+        return result;
+
+    int depth = std::max(1, m_options.depth);
+    m_candidates.resize(depth + 1);
+    m_gains.resize(depth + 1);
+    for (int ply = 0; ply <= depth; ++ply)
+    {
+        m_candidates[ply].resize(std::max(m_options.maxCandidates, board.getNumCells()));
+        m_gains[ply].resize(m_candidates[ply].size());
+    }
+
+    //a forced win beats anything the search could find
+    int vcf = findVCF(board, side, m_options.vcfDepth);
+    if (vcf >= 0)
+    {
+        result.cell = vcf;
+        result.score = WinScore;
+        result.forcedWin = true;
+        result.nodes = m_nodes;
+        return result;
+    }
+
+    int* candidates = m_candidates[0].data();
+    int numCandidates = getCandidates(board, side, candidates, m_options.maxCandidates);
+
+    int alpha = -WinNow;
+    int beta = WinNow;
+    result.cell = numCandidates ? candidates[0] : -1;
+    result.score = alpha;
+    for (int i = 0; i < numCandidates; ++i)
+    {
+        board.makeMove(candidates[i], side);
+        ++m_nodes;
+        int score = -negamax(board, BoardSnapshot::opponent(side), depth - 1, -beta, -alpha, 1);
+        board.unmakeMove(candidates[i]);
+
+        if (score > result.score)
+        {
+            result.score = score;
+            result.cell = candidates[i];
+        }
+        alpha = std::max(alpha, score);
+    }
+
+    result.nodes = m_nodes;
+    return result;
+}
+
+int ThreatSearch::negamax(LineBoard& board, uint8_t side, int depth, int alpha, int beta, int ply)
+{
+    //the move that got us here won it for them
+    if (board.winner() != BoardSnapshot::Empty)
+        return -(WinScore - ply);
+    if (depth <= 0 || board.isFull())
+        return board.evaluate(side);
+
+    //we win with the next move whatever they've got
+    if (board.getNumFours(side))
+        return WinScore - (ply + 1);
+
+    int* candidates = m_candidates[ply].data();
+    int* gains = m_gains[ply].data();
+    int numCandidates = getCandidates(board, side, candidates, m_options.maxCandidates, gains);
+    if (numCandidates == 0)
+        return board.evaluate(side);
+
+    //the children are leaves, and a leaf is just our evaluation plus what the move gained
+    if (depth == 1)
+    {
+        m_nodes += numCandidates;
+        return board.evaluate(side) + *std::max_element(gains, gains + numCandidates);
+    }
+
+    int best = -WinNow;
+    for (int i = 0; i < numCandidates; ++i)
+    {
+        board.makeMove(candidates[i], side);
+        ++m_nodes;
+        int score = -negamax(board, BoardSnapshot::opponent(side), depth - 1, -beta, -alpha, ply + 1);
+        board.unmakeMove(candidates[i]);
+
+        best = std::max(best, score);
+        alpha = std::max(alpha, score);
+        if (alpha >= beta)
+            break;
+    }
+    return best;
+}
+
+int ThreatSearch::getCandidates(const LineBoard& board, uint8_t side, int* out, int maxOut, int* gains)
+{
+    uint8_t other = BoardSnapshot::opponent(side);
+
+    //we can win, nothing else matters.  Failing that, if they can we block.  If there's more
+    //than one of those we've lost, but try them anyway.
+    int forced = 0;
+    if (board.getNumFours(side))
+        forced = collectFourCells(board, side, out, 1);
+    else if (board.getNumFours(other))
+        forced = collectFourCells(board, other, out, maxOut);
+
+    if (forced)
+    {
+        for (int i = 0; gains && i < forced; ++i)
+        {
+            LineBoard::MoveInfo info;
+            board.getMoveInfo(out[i], side, info);
+            gains[i] = info.gain;
+        }
+        return forced;
+    }
+
+    //everything near a stone (anywhere on an empty board), scored by what it does for us plus
+    //what it takes from them.  fours and double threes (ours or the ones we'd stop) go first
+    //whatever they score.
+    bool empty = board.getNumStones() == 0;
+    int numCells = empty ? board.getNumCells() : board.getNumCandidates();
+    if (static_cast<int>(m_scored.size()) < numCells)
+        m_scored.resize(board.getNumCells());
+
+    ScoredCell* scored = m_scored.data();
+    int numScored = 0;
+    for (int i = 0; i < numCells; ++i)
+    {
+        int cell = empty ? i : board.getCandidate(i);
+        LineBoard::MoveInfo info;
+        board.getMoveInfo(cell, side, info);
+
+        int score = info.gain;
+        if (info.fours + info.threes >= 2)
+            score += DoubleThreatBonus;
+        else if (info.fours)
+            score += FourBonus;
+        if (info.theirFours + info.theirThrees >= 2)
+            score += DoubleThreatBonus / 2;
+
+        scored[numScored].cell = cell;
+        scored[numScored].score = score;
+        scored[numScored].gain = info.gain;
+        ++numScored;
+    }
+
+    int count = std::min(numScored, maxOut);
+    //ties go to the lower cell, the candidates come in whatever order the board keeps them
+    std::partial_sort(scored, scored + count, scored + numScored, [](const ScoredCell& a, const ScoredCell& b) {
+        return a.score > b.score || (a.score == b.score && a.cell < b.cell);
+    });
+    for (int i = 0; i < count; ++i)
+    {
+        out[i] = scored[i].cell;
+        if (gains)
+            gains[i] = scored[i].gain;
+    }
+    return count;
+}
+
+int ThreatSearch::findVCF(LineBoard& board, uint8_t attacker, int depth)
+{
+    if (static_cast<int>(m_fourMoves.size()) <= depth)
+        m_fourMoves.resize(depth + 1);
+    for (auto&& moves : m_fourMoves)
+        moves.resize(board.getNumCells());
+    return findFours(board, attacker, depth);
+}
+
+int ThreatSearch::findFours(LineBoard& board, uint8_t attacker, int depth)
+{
+    uint8_t defender = BoardSnapshot::opponent(attacker);
+
+    int winning[1];
+    if (collectFourCells(board, attacker, winning, 1))
+        return winning[0];
+
+    //a four of theirs would have to be blocked, and the block isn't a four of ours (or it would have won)
+    if (depth <= 0 || board.getNumFours(defender))
+        return -1;
+
+    //every move that makes a four is the empty cell of a line we're two short in.  Collected
+    //first since making moves moves lines between lists.
+    std::vector<int>& moves = m_fourMoves[depth];
+    int numMoves = 0;
+    for (int i = 0; i < board.getNumThrees(attacker); ++i)
+    {
+        int line = board.getThreeLine(attacker, i);
+        for (int j = 0; j < board.getInARow(); ++j)
+        {
+            int cell = board.getLineCell(line, j);
+            if (board.at(cell) == BoardSnapshot::Empty && numMoves < static_cast<int>(moves.size()) && std::find(moves.begin(), moves.begin() + numMoves, cell) == moves.begin() + numMoves)
+                moves[numMoves++] = cell;
+        }
+    }
+
+    for (int i = 0; i < numMoves; ++i)
+    {
+        int move = moves[i];
+        board.makeMove(move, attacker);
+        ++m_nodes;
+
+        //two different cells to finish on, they can only block one of them
+        int threats[2];
+        int numThreats = collectFourCells(board, attacker, threats, 2);
+
+        bool won = numThreats >= 2;
+        if (numThreats == 1 && !board.getNumFours(defender))
+        {
+            board.makeMove(threats[0], defender);
+            ++m_nodes;
+            won = findFours(board, attacker, depth - 1) >= 0;
+            board.unmakeMove(threats[0]);
+        }
+
+        board.unmakeMove(move);
+        if (won)
+            return move;
+    }
+    return -1;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "LineBoard.h"
+
+#include <cinttypes>
+#include <vector>
+
+//alpha-beta over a LineBoard, with threats doing most of the pruning.  A side that can win
+//wins; a side facing a four blocks it and tries nothing else; otherwise only the few cells
+//next to stones that do the most for us (or against them) get tried, fours and double threes
+//first.  Before searching it looks for a win by nothing but fours (VCF): every move is a four,
+//so the other side only ever has the one answer and it goes deep for next to nothing.
+//evaluation is LineBoard's, which is kept up to date by make and unmake, so a leaf costs nothing;
+//one ply from the leaves we don't even make the moves, a move's gain is exactly what it would
+//do to the evaluation.
+class ThreatSearch
+{
+public:
+    struct Options
+    {
+        Options() : depth(4), maxCandidates(8), vcfDepth(10) {}
+
+        int depth;          //plies of full width (well, candidate width) search
+        int maxCandidates;  //cells tried at a node with no threats around
+        int vcfDepth;       //how many fours in a row the VCF will play
+    };
+
+    struct Result
+    {
+        Result() : cell(-1), score(0), nodes(0), forcedWin(false) {}
+
+        int cell;           //-1 if the board's full or already won
+        int score;          //side's point of view
+        uint64_t nodes;     //made moves, search and VCF both
+        bool forcedWin;     //the VCF found it, nothing the other side does matters
+    };
+
+    //anything past this is a win, less the plies it takes
+    static const int WinScore = 1 << 28;
+
+    explicit ThreatSearch(const Options& options = Options());
+
+    //best move for side.  The board's left the way it was found.
+    Result search(LineBoard& board, uint8_t side);
+
+    //the cells worth trying for side, best first.  Returns how many went in out.  gains, if
+    //given, gets what each one would add to side's evaluation (LineBoard::MoveInfo::gain).
+    //only looks at the board's candidates, so it's the cells near stones and not the whole board.
+    int getCandidates(const LineBoard& board, uint8_t side, int* out, int maxOut, int* gains = nullptr);
+
+    //the first move of a win by fours for attacker, -1 if there isn't one within depth
+    int findVCF(LineBoard& board, uint8_t attacker, int depth);
+
+protected:
+    struct ScoredCell
+    {
+        int cell;
+        int score;      //gain plus the threat bonuses, for ordering
+        int gain;
+    };
+
+    int negamax(LineBoard& board, uint8_t side, int depth, int alpha, int beta, int ply);
+
+    //findVCF once the buffers are there
+    int findFours(LineBoard& board, uint8_t attacker, int depth);
+
+    Options m_options;
+    uint64_t m_nodes;
+
+    //candidate lists (and their gains) for every ply, and four making moves for every VCF depth,
+    //so searching doesn't allocate
+    std::vector<std::vector<int>> m_candidates;
+    std::vector<std::vector<int>> m_gains;
+    std::vector<std::vector<int>> m_fourMoves;
+
+    //getCandidates' working space, only ever as big as the board
+    std::vector<ScoredCell> m_scored;
+};
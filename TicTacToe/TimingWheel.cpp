@@ -0,0 +1,237 @@
+#include "TimingWheel.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+    //the lowest set bit, bits isn't 0
+    int lowestBit(uint64_t bits)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    const uint64_t NoTick = ~uint64_t(0);
+}
+
+TimingWheel::TimingWheel(std::chrono::microseconds resolution, Clock::time_point start) :
+    m_resolution(resolution.count() > 0 ? resolution : std::chrono::microseconds(1)),
+    m_start(start),
+    m_now(0),
+    m_freeList(NoNode),
+    m_numTimers(0)
+{
+    for (auto&& wheel : m_heads)
+        for (auto&& head : wheel)
+            head = NoNode;
+    for (auto&& occupied : m_occupied)
+        occupied = 0;
+}
+
+uint64_t TimingWheel::toTicks(Clock::time_point when) const
+{
+    //rounded up, so nothing fires before it's due
+    if (when <= m_start)
+        return 0;
+    uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(when - m_start).count());
+    uint64_t resolutionNanos = static_cast<uint64_t>(m_resolution.count()) * 1000;
+    return (nanos + resolutionNanos - 1) / resolutionNanos;
+}
+
+TimingWheel::TimerId TimingWheel::schedule(Clock::time_point when, Callback callback)
+{
+    int index = allocNode();
+    Node& node = m_nodes[index];
+    node.callback = std::move(callback);
+
+    //the tick we're on is done, the soonest anything can go off is the next
+    uint64_t expires = toTicks(when);
+    node.expires = expires > m_now ? expires : m_now + 1;
+    link(index);
+
+    return (static_cast<uint64_t>(node.serial) << 32) | static_cast<uint32_t>(index + 1);
+}
+
+bool TimingWheel::cancel(TimerId id)
+{
+    int index = static_cast<int>(static_cast<uint32_t>(id)) - 1;
+    uint32_t serial = static_cast<uint32_t>(id >> 32);
+    if (index < 0 || index >= static_cast<int>(m_nodes.size()))
+        return false;
+
+    Node& node = m_nodes[index];
+    if (!node.live || node.serial != serial)
+        return false;
+
+    unlink(index);
+    freeNode(index);
+    return true;
+}
+
+size_t TimingWheel::advance(Clock::time_point now, std::vector<Callback>& due)
+{
+    //only ticks that are over, rounded down
+    uint64_t target = 0;
+    if (now > m_start)
+        target = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count()) / (static_cast<uint64_t>(m_resolution.count()) * 1000);
+
+    size_t numDue = 0;
+    while (m_now < target)
+    {
+        //nothing happens in between, skip right to it
+        uint64_t next = getNextTick();
+        if (next > target)
+        {
+            m_now = target;
+            break;
+        }
+        m_now = next;
+
+        //top down, so a timer can drop more than one wheel at once
+        const uint64_t wheelsSpan = uint64_t(1) << (SlotBits * NumWheels);
+        if ((m_now & (wheelsSpan - 1)) == 0)
+            cascade(NumWheels, 0);
+        for (int wheel = NumWheels - 1; wheel > 0; --wheel)
+        {
+            int shift = SlotBits * wheel;
+            if ((m_now & ((uint64_t(1) << shift) - 1)) == 0)
+                cascade(wheel, static_cast<int>((m_now >> shift) & (NumSlots - 1)));
+        }
+
+        int slot = static_cast<int>(m_now & (NumSlots - 1));
+        while (m_heads[0][slot] != NoNode)
+        {
+            int index = m_heads[0][slot];
+            unlink(index);
+            due.push_back(std::move(m_nodes[index].callback));
+            freeNode(index);
+            ++numDue;
+        }
+    }
+    return numDue;
+}
+
+uint64_t TimingWheel::getNextTick() const
+{
+    //everything in a wheel is inside the slot of the wheel above that now is in, so the lowest
+    //wheel with anything in it has the soonest
+    for (int wheel = 0; wheel < NumWheels; ++wheel)
+    {
+        if (!m_occupied[wheel])
+            continue;
+
+        int shift = SlotBits * wheel;
+        int position = static_cast<int>((m_now >> shift) & (NumSlots - 1));
+        uint64_t ahead = position == NumSlots - 1 ? 0 : m_occupied[wheel] & (~uint64_t(0) << (position + 1));
+        if (!ahead)
+            continue;
+
+        uint64_t turn = (m_now >> (shift + SlotBits)) << (shift + SlotBits);
+        return turn | (static_cast<uint64_t>(lowestBit(ahead)) << shift);
+    }
+
+    if (m_heads[NumWheels][0] != NoNode)
+        return ((m_now >> (SlotBits * NumWheels)) + 1) << (SlotBits * NumWheels);
+    return NoTick;
+}
+
+TimingWheel::Clock::time_point TimingWheel::getNextExpiry() const
+{
+    uint64_t tick = getNextTick();
+    if (tick == NoTick)
+        return Clock::time_point::max();
+    return m_start + std::chrono::microseconds(static_cast<int64_t>(tick) * m_resolution.count());
+}
+
+int TimingWheel::allocNode()
+{
+    int index = m_freeList;
+    if (index == NoNode)
+    {
+        index = static_cast<int>(m_nodes.size());
+        m_nodes.push_back(Node());
+        m_nodes.back().serial = 1;
+    }
+    else
+    {
+        m_freeList = m_nodes[index].next;
+    }
+
+    m_nodes[index].live = true;
+    ++m_numTimers;
+    return index;
+}
+
+void TimingWheel::freeNode(int index)
+{
+    Node& node = m_nodes[index];
+    node.callback = nullptr;
+    node.live = false;
+    ++node.serial;
+    node.next = m_freeList;
+    m_freeList = index;
+    --m_numTimers;
+}
+
+void TimingWheel::link(int index)
+{
+    Node& node = m_nodes[index];
+
+    //the highest slot the expiry and now don't share picks the wheel.  Due now (a cascade can do
+    //that) is the bottom wheel's current slot, which fires straight after.
+    uint64_t differ = node.expires ^ m_now;
+    int wheel = 0;
+    while (wheel < NumWheels && (differ >> (SlotBits * (wheel + 1))) != 0)
+        ++wheel;
+
+    int slot = wheel < NumWheels ? static_cast<int>((node.expires >> (SlotBits * wheel)) & (NumSlots - 1)) : 0;
+    node.wheel = static_cast<uint8_t>(wheel);
+    node.slot = static_cast<uint8_t>(slot);
+
+    int& head = m_heads[wheel][slot];
+    node.prev = NoNode;
+    node.next = head;
+    if (head != NoNode)
+        m_nodes[head].prev = index;
+    head = index;
+
+    if (wheel < NumWheels)
+        m_occupied[wheel] |= uint64_t(1) << slot;
+}
+
+void TimingWheel::unlink(int index)
+{
+    Node& node = m_nodes[index];
+    int& head = m_heads[node.wheel][node.slot];
+    if (node.prev != NoNode)
+        m_nodes[node.prev].next = node.next;
+    else
+        head = node.next;
+    if (node.next != NoNode)
+        m_nodes[node.next].prev = node.prev;
+
+    if (head == NoNode && node.wheel < NumWheels)
+        m_occupied[node.wheel] &= ~(uint64_t(1) << node.slot);
+}
+
+void TimingWheel::cascade(int wheel, int slot)
+{
+    int index = m_heads[wheel][slot];
+    m_heads[wheel][slot] = NoNode;
+    if (wheel < NumWheels)
+        m_occupied[wheel] &= ~(uint64_t(1) << slot);
+
+    while (index != NoNode)
+    {
+        int next = m_nodes[index].next;
+        link(index);
+        index = next;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <functional>
+#include <vector>
+
+//a hierarchical timing wheel: four wheels of 64 slots, each slot of one a whole turn of the one
+//below.  A timer goes in the lowest wheel where its expiry and now agree on every higher slot, so
+//schedule and cancel are a couple of list links and a bitmap bit, however many timers there are.
+//when now reaches a slot of an upper wheel its timers drop down a wheel (or several), and the
+//ones in the bottom wheel's slot fire.  An occupancy bitmap per wheel means advancing jumps
+//straight to the next slot with anything in it instead of stepping every tick.
+//timers never fire early; they fire up to one resolution late.  With the default millisecond
+//resolution the wheels cover about 4.6 hours, anything further out waits in an overflow list.
+//not thread safe, whoever owns it locks it (see GameScheduler).
+class TimingWheel
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void()> Callback;
+
+    //0 is never a timer.  Ids aren't reused, so cancelling one that already fired does nothing.
+    typedef uint64_t TimerId;
+
+    explicit TimingWheel(std::chrono::microseconds resolution = std::chrono::milliseconds(1), Clock::time_point start = Clock::now());
+
+    TimerId schedule(Clock::time_point when, Callback callback);
+
+    //false if it already fired or was cancelled
+    bool cancel(TimerId id);
+
+    //moves the wheel up to now and appends the callbacks of everything that's due, soonest first.
+    //returns how many.  Doesn't call them, so they can run outside the owner's lock.
+    size_t advance(Clock::time_point now, std::vector<Callback>& due);
+
+    //when advance will next have something to do, max() if there are no timers.  Can be early (a
+    //slot of an upper wheel coming due just moves its timers down), never late.
+    Clock::time_point getNextExpiry() const;
+
+    size_t size() const { return m_numTimers; }
+
+protected:
+    static const int NumWheels = 4;
+    static const int SlotBits = 6;
+    static const int NumSlots = 1 << SlotBits;
+    static const int NoNode = -1;
+
+    //where a node is linked, NumWheels is the overflow list
+    struct Node
+    {
+        Callback callback;
+        uint64_t expires;       //in ticks
+        uint32_t serial;        //bumped every time the node is freed, so stale ids miss
+        int prev;
+        int next;
+        uint8_t wheel;
+        uint8_t slot;
+        bool live;
+    };
+
+    uint64_t toTicks(Clock::time_point when) const;
+
+    //the next tick where a slot of any wheel comes due, ~0 if there are none
+    uint64_t getNextTick() const;
+
+    int allocNode();
+    void freeNode(int index);
+
+    void link(int index);
+    void unlink(int index);
+
+    //every timer in a slot goes back in by its expiry, which puts it lower down
+    void cascade(int wheel, int slot);
+
+    std::chrono::microseconds m_resolution;
+    Clock::time_point m_start;
+    uint64_t m_now;         //ticks since m_start that have been processed
+
+    std::vector<Node> m_nodes;
+    int m_freeList;
+    size_t m_numTimers;
+
+    int m_heads[NumWheels + 1][NumSlots];
+    uint64_t m_occupied[NumWheels];
+};
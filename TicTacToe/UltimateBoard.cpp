@@ -0,0 +1,165 @@
+#include "UltimateBoard.h"
+#include "GameEngine.h"
+
+namespace
+{
+    const uint16_t FullBoard = 0x1ff;
+
+    //everything about a 9 bit mask anybody asks, worked out once for all 512 of them
+    struct MaskTables
+    {
+        MaskTables()
+        {
+            static const uint16_t lines[8] = {
+                0x007, 0x038, 0x1c0,    //rows
+                0x049, 0x092, 0x124,    //columns
+                0x111, 0x054            //diagonals
+            };
+
+            for (int i = 0; i < 8; ++i)
+                hasLine[i] = 0;
+
+            for (int mask = 0; mask < 512; ++mask)
+            {
+                for (auto line : lines)
+                {
+                    if ((mask & line) == line)
+                        hasLine[mask >> 6] |= uint64_t(1) << (mask & 63);
+                }
+
+                int count = 0;
+                for (int bit = 0; bit < 9; ++bit)
+                {
+                    select[mask][bit] = 0;
+                    if ((mask >> bit) & 1)
+                        select[mask][count++] = static_cast<uint8_t>(bit);
+                }
+                popcount[mask] = static_cast<uint8_t>(count);
+            }
+        }
+
+        uint64_t hasLine[8];        //one bit per mask
+        uint8_t popcount[512];
+        uint8_t select[512][9];     //the nth set bit of a mask
+    };
+
+    const MaskTables Tables;
+
+    //a number from 0 to n - 1 out of a random 64 bits, no divide
+    int pick(uint64_t random, int n)
+    {
+        return static_cast<int>(((random & 0xffffffffull) * static_cast<uint64_t>(n)) >> 32);
+    }
+}
+
+UltimateBoard::UltimateBoard() : closed(0), active(AnyBoard), sideToMove(BoardSnapshot::Player), winner(BoardSnapshot::Empty), numMoves(0)
+{
+    for (int board = 0; board < NumBoards; ++board)
+        cells[0][board] = cells[1][board] = 0;
+    won[0] = won[1] = 0;
+}
+
+bool UltimateBoard::hasLine(uint16_t mask)
+{
+    return ((Tables.hasLine[mask >> 6] >> (mask & 63)) & 1) != 0;
+}
+
+uint8_t UltimateBoard::at(int cell) const
+{
+    int board = cell / 9;
+    int bit = cell % 9;
+    if ((cells[0][board] >> bit) & 1)
+        return BoardSnapshot::Player;
+    if ((cells[1][board] >> bit) & 1)
+        return BoardSnapshot::AI;
+    return BoardSnapshot::Empty;
+}
+
+uint8_t UltimateBoard::getBoardWinner(int board) const
+{
+    if ((won[0] >> board) & 1)
+        return BoardSnapshot::Player;
+    if ((won[1] >> board) & 1)
+        return BoardSnapshot::AI;
+    return BoardSnapshot::Empty;
+}
+
+uint16_t UltimateBoard::getLegalMask(int board) const
+{
+    bool inPlay = winner == BoardSnapshot::Empty && (active == AnyBoard || active == board) && !isClosed(board);
+    return inPlay ? static_cast<uint16_t>(~(cells[0][board] | cells[1][board]) & FullBoard) : 0;
+}
+
+int UltimateBoard::getLegalMoves(uint8_t* out) const
+{
+    int count = 0;
+    for (int board = 0; board < NumBoards; ++board)
+    {
+        uint16_t mask = getLegalMask(board);
+        for (int i = 0; i < Tables.popcount[mask]; ++i)
+            out[count++] = static_cast<uint8_t>((board * 9) + Tables.select[mask][i]);
+    }
+    return count;
+}
+
+bool UltimateBoard::play(int cell)
+{
+    if (cell < 0 || cell >= NumCells || !isLegal(cell))
+        return false;
+
+    int board = cell / 9;
+    int bit = cell % 9;
+    int side = sideToMove - 1;
+
+    uint16_t mine = static_cast<uint16_t>(cells[side][board] | (1 << bit));
+    cells[side][board] = mine;
+
+    //no branches for the small board being won or filled, just bits
+    uint16_t wonIt = hasLine(mine) ? 1 : 0;
+    uint16_t full = (mine | cells[side ^ 1][board]) == FullBoard ? 1 : 0;
+    won[side] = static_cast<uint16_t>(won[side] | (wonIt << board));
+    closed = static_cast<uint16_t>(closed | ((wonIt | full) << board));
+
+    if (hasLine(won[side]))
+        winner = sideToMove;
+
+    active = isClosed(bit) ? AnyBoard : static_cast<uint8_t>(bit);
+    sideToMove = BoardSnapshot::opponent(sideToMove);
+    ++numMoves;
+    return true;
+}
+
+uint8_t UltimateBoard::playout(uint64_t& rng)
+{
+    while (!isGameOver())
+    {
+        uint64_t random = GameEngine::nextRandom(rng);
+
+        //usually there's one board to play in, otherwise pick a cell out of all the open ones
+        int board = active;
+        uint16_t mask = 0;
+        if (active != AnyBoard)
+        {
+            mask = getLegalMask(board);
+        }
+        else
+        {
+            int total = 0;
+            for (int b = 0; b < NumBoards; ++b)
+                total += Tables.popcount[getLegalMask(b)];
+
+            int n = pick(random, total);
+            for (board = 0; board < NumBoards; ++board)
+            {
+                mask = getLegalMask(board);
+                if (n < Tables.popcount[mask])
+                    break;
+                n -= Tables.popcount[mask];
+            }
+        }
+
+        //the low half picked the board, the high half picks the cell
+        play((board * 9) + Tables.select[mask][pick(random >> 32, Tables.popcount[mask])]);
+    }
+    return winner;
+}
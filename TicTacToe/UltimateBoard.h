@@ -0,0 +1,64 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+
+#include <cinttypes>
+
+//ultimate tic tac toe: a 3x3 board of 3x3 boards.  Where you move inside a small board picks the
+//small board the other side has to move in next; if that one's won or full they can go anywhere.
+//win three small boards in a row to win.
+//all bitboards: a 9 bit mask per side per small board, and the same again one level up for the
+//small boards each side has won.  Win checks are a table lookup on the 9 bits, legal moves are
+//a mask or two, and the whole thing is about 50 bytes, so searches copy it instead of undoing.
+//cells are numbered small board * 9 + cell in it, both in BoardSnapshot order.  The x/y helpers
+//go to and from the 9x9 grid as it's drawn.
+struct UltimateBoard
+{
+    static const int NumCells = 81;
+    static const int NumBoards = 9;
+
+    //active when the next move can go in any open small board
+    static const uint8_t AnyBoard = 0xff;
+
+    UltimateBoard();
+
+    static int cellFromXY(int x, int y) { return (((y / 3) * 3 + (x / 3)) * 9) + ((y % 3) * 3) + (x % 3); }
+    static int xFromCell(int cell) { return ((cell / 9) % 3) * 3 + (cell % 9) % 3; }
+    static int yFromCell(int cell) { return ((cell / 9) / 3) * 3 + (cell % 9) / 3; }
+
+    uint8_t at(int cell) const;
+
+    //Empty, or whoever won that small board (or is still playing it, see isClosed)
+    uint8_t getBoardWinner(int board) const;
+
+    //won or full, nobody can move there anymore
+    bool isClosed(int board) const { return ((closed >> board) & 1) != 0; }
+
+    //the cells side to move can play in a small board, 0 if it's not in play
+    uint16_t getLegalMask(int board) const;
+
+    bool isLegal(int cell) const { return ((getLegalMask(cell / 9) >> (cell % 9)) & 1) != 0; }
+
+    //every legal cell, returns how many
+    int getLegalMoves(uint8_t* cells) const;
+
+    //false (and nothing changes) if it isn't legal
+    bool play(int cell);
+
+    bool isGameOver() const { return winner != BoardSnapshot::Empty || closed == 0x1ff; }
+
+    //plays random legal moves to the end, returns the winner (Empty for a draw).  rng is a
+    //GameEngine::nextRandom state.
+    uint8_t playout(uint64_t& rng);
+
+    //true if a 9 bit mask has three in a row in it
+    static bool hasLine(uint16_t mask);
+
+    uint16_t cells[2][NumBoards];   //[side - 1][board]
+    uint16_t won[2];                //small boards each side has won
+    uint16_t closed;                //small boards that are won or full
+    uint8_t active;                 //small board the next move has to go in, or AnyBoard
+    uint8_t sideToMove;             //Player or AI
+    uint8_t winner;                 //Empty until somebody wins the big board
+    uint8_t numMoves;
+};
@@ -0,0 +1,209 @@
+#include "UltimateBoardView.h"
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Group>
+#include <osg/Image>
+#include <osg/Texture2D>
+
+namespace
+{
+    //the small boards' borders are this much wider than the lines inside them
+    const double MajorLineScale = 3.0;
+
+    //behind the lines, so the borders still show through
+    const double HighlightDepth = -0.2;
+    const double LineDepth = -0.1;
+    const double PieceDepth = 0.0;
+    const double WonBoardDepth = 0.1;
+
+    osg::Geometry* createQuads(int numQuads, const osg::Vec4f& color)
+    {
+        osg::Geometry* geometry = new osg::Geometry;
+
+        //the corners get rewritten when the window resizes
+        geometry->setDataVariance(osg::Object::DYNAMIC);
+        geometry->setUseDisplayList(false);
+        geometry->setUseVertexBufferObjects(true);
+
+        geometry->setVertexArray(new osg::Vec3Array(numQuads * 4));
+
+        osg::Vec4Array* colors = new osg::Vec4Array;
+        colors->push_back(color);
+        geometry->setColorArray(colors, osg::Array::BIND_OVERALL);
+
+        geometry->addPrimitiveSet(new osg::DrawArrays(GL_QUADS, 0, numQuads * 4));
+
+        osg::StateSet* stateset = geometry->getOrCreateStateSet();
+        stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+        stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+        return geometry;
+    }
+
+    void setQuad(osg::Geometry* geometry, int quad, const BoardLayout::Rect& rect, double z)
+    {
+        //clockwise, starting at top left, same as the main board
+        osg::Vec3Array* vertices = static_cast<osg::Vec3Array*>(geometry->getVertexArray());
+        (*vertices)[quad * 4 + 0].set(rect.xMin, rect.yMax, z);
+        (*vertices)[quad * 4 + 1].set(rect.xMax, rect.yMax, z);
+        (*vertices)[quad * 4 + 2].set(rect.xMax, rect.yMin, z);
+        (*vertices)[quad * 4 + 3].set(rect.xMin, rect.yMin, z);
+        vertices->dirty();
+        geometry->dirtyBound();
+    }
+
+    osg::StateSet* createPieceState(osg::Image* image)
+    {
+        osg::Texture2D* texture = new osg::Texture2D;
+        texture->setImage(image);
+
+        osg::StateSet* stateset = new osg::StateSet;
+        stateset->setTextureAttributeAndModes(0, texture, osg::StateAttribute::ON);
+        stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+        stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+        return stateset;
+    }
+
+    //the cells of small board b, from its top left cell to its bottom right
+    BoardLayout::Rect getSmallBoardRect(const BoardLayout& layout, int board, double padding)
+    {
+        int x = (board % 3) * 3;
+        int y = (board / 3) * 3;
+        BoardLayout::Rect rect = layout.getCellRect(x, y);
+        BoardLayout::Rect last = layout.getCellRect(x + 2, y + 2);
+        rect.xMax = last.xMax - padding;
+        rect.yMin = last.yMin + padding;
+        rect.xMin += padding;
+        rect.yMax -= padding;
+        return rect;
+    }
+}
+
+UltimateBoardView::UltimateBoardView(osg::Image* xImage, osg::Image* oImage) : m_placedWidth(-1.0),
+    m_placedHeight(-1.0)
+{
+    m_root = new osg::Group;
+
+    //every line in one geometry, it only moves when the window does
+    m_lines = createQuads(BoardLayout(9).getNumLines(), osg::Vec4f(1.0f, 0.0f, 0.0f, 0.8f));
+    osg::Geode* lines = new osg::Geode;
+    lines->addDrawable(m_lines);
+    m_root->addChild(lines);
+
+    m_xState = createPieceState(xImage);
+    m_oState = createPieceState(oImage);
+
+    osg::Vec2Array* texcoords = new osg::Vec2Array;
+    texcoords->push_back(osg::Vec2f(0.0f, 1.0f));
+    texcoords->push_back(osg::Vec2f(0.0f, 0.0f));
+    texcoords->push_back(osg::Vec2f(1.0f, 0.0f));
+    texcoords->push_back(osg::Vec2f(1.0f, 1.0f));
+
+    auto addQuads = [this, texcoords](std::vector<Quad>& quads, int count, const osg::Vec4f& color, bool textured) {
+        for (int i = 0; i < count; ++i)
+        {
+            Quad quad;
+            quad.geometry = createQuads(1, color);
+            if (textured)
+                quad.geometry->setTexCoordArray(0, texcoords);
+
+            quad.geode = new osg::Geode;
+            quad.geode->setDataVariance(osg::Object::DYNAMIC);
+            quad.geode->addDrawable(quad.geometry);
+            quad.geode->setNodeMask(0);
+            quad.shown = 0;
+
+            m_root->addChild(quad.geode);
+            quads.push_back(quad);
+        }
+    };
+
+    addQuads(m_highlights, UltimateBoard::NumBoards, osg::Vec4f(1.0f, 1.0f, 0.0f, 0.15f), false);
+    addQuads(m_pieces, UltimateBoard::NumCells, osg::Vec4f(1.0f, 1.0f, 1.0f, 1.0f), true);
+
+    //see through a bit, the small board under it still matters for where moves send you
+    addQuads(m_wonBoards, UltimateBoard::NumBoards, osg::Vec4f(1.0f, 1.0f, 1.0f, 0.7f), true);
+}
+
+UltimateBoardView::~UltimateBoardView()
+{
+}
+
+osg::Group* UltimateBoardView::getNode() const
+{
+    return m_root.get();
+}
+
+void UltimateBoardView::placeGrid(const BoardLayout& layout)
+{
+    for (int line = 0; line < layout.getNumLines(); ++line)
+    {
+        BoardLayout::Rect rect = layout.getLineRect(line);
+
+        //every third line is a small board's border
+        int index = line % (layout.getSize() - 1);
+        if (index % 3 == 2)
+        {
+            bool horizontal = line < layout.getSize() - 1;
+            double& lo = horizontal ? rect.yMin : rect.xMin;
+            double& hi = horizontal ? rect.yMax : rect.xMax;
+            double grow = (hi - lo) * (MajorLineScale - 1.0) / 2.0;
+            lo -= grow;
+            hi += grow;
+        }
+        setQuad(m_lines, line, rect, LineDepth);
+    }
+
+    for (int board = 0; board < UltimateBoard::NumBoards; ++board)
+    {
+        setQuad(m_highlights[board].geometry, 0, getSmallBoardRect(layout, board, 0.0), HighlightDepth);
+
+        //the big piece gets the same padding a small one does, relative to its size
+        BoardLayout::Rect cell = layout.getCellRect(0, 0);
+        BoardLayout::Rect piece = layout.getPieceRect(0, 0);
+        setQuad(m_wonBoards[board].geometry, 0, getSmallBoardRect(layout, board, (piece.xMin - cell.xMin) * 3.0), WonBoardDepth);
+    }
+
+    for (int cell = 0; cell < UltimateBoard::NumCells; ++cell)
+        setQuad(m_pieces[cell].geometry, 0, layout.getPieceRect(UltimateBoard::xFromCell(cell), UltimateBoard::yFromCell(cell)), PieceDepth);
+}
+
+void UltimateBoardView::update(const UltimateBoard& board, const BoardLayout& layout)
+{
+    if (layout.getViewportWidth() != m_placedWidth || layout.getViewportHeight() != m_placedHeight)
+    {
+        m_placedWidth = layout.getViewportWidth();
+        m_placedHeight = layout.getViewportHeight();
+        placeGrid(layout);
+    }
+
+    //only the node masks and the looks change from move to move, the corners stay put
+    auto show = [this](Quad& quad, uint8_t side) {
+        if (side == quad.shown)
+            return;
+        quad.shown = side;
+        if (side == BoardSnapshot::Empty)
+        {
+            quad.geode->setNodeMask(0);
+            return;
+        }
+        quad.geode->setStateSet(side == BoardSnapshot::Player ? m_oState.get() : m_xState.get());
+        quad.geode->setNodeMask(~0u);
+    };
+
+    for (int cell = 0; cell < UltimateBoard::NumCells; ++cell)
+        show(m_pieces[cell], board.at(cell));
+
+    for (int b = 0; b < UltimateBoard::NumBoards; ++b)
+    {
+        show(m_wonBoards[b], board.getBoardWinner(b));
+
+        Quad& highlight = m_highlights[b];
+        uint8_t inPlay = board.getLegalMask(b) ? 1 : 0;
+        if (inPlay != highlight.shown)
+        {
+            highlight.shown = inPlay;
+            highlight.geode->setNodeMask(inPlay ? ~0u : 0u);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "BoardLayout.h"
+#include "UltimateBoard.h"
+
+#include <osg/ref_ptr>
+
+#include <cinttypes>
+#include <vector>
+
+namespace osg
+{
+    class Geode;
+    class Geometry;
+    class Group;
+    class Image;
+    class StateSet;
+}
+
+//draws an ultimate board: the 9x9 grid with the small boards' borders drawn heavier, a piece for
+//each of the 81 cells, a big X or O over each small board that's been won, and a highlight on
+//the small boards the next move can go in.
+//same idea as the main board's pieces: every node is made once up front and masked off when
+//there's nothing to show, the X and O looks are shared, and update only touches what changed
+//since the last frame (or everything, if the layout moved).
+class UltimateBoardView
+{
+public:
+    //the images are the ones the main board already decoded.  Player is O, the AI is X, same as there.
+    UltimateBoardView(osg::Image* xImage, osg::Image* oImage);
+    ~UltimateBoardView();
+
+    osg::Group* getNode() const;
+
+    //the layout has to be a 9x9 one, already set to the viewport.  It's the one clicks go through.
+    void update(const UltimateBoard& board, const BoardLayout& layout);
+
+protected:
+    struct Quad
+    {
+        osg::ref_ptr<osg::Geode> geode;
+        osg::ref_ptr<osg::Geometry> geometry;
+        uint8_t shown;      //a BoardSnapshot cell for pieces and won boards, 1 or 0 for highlights
+    };
+
+    void placeGrid(const BoardLayout& layout);
+
+    //the layout the grid and the pieces were last placed for
+    double m_placedWidth;
+    double m_placedHeight;
+
+    osg::ref_ptr<osg::Group> m_root;
+
+    //minor lines then the four major ones, all in one geometry
+    osg::ref_ptr<osg::Geometry> m_lines;
+
+    std::vector<Quad> m_highlights;     //one per small board
+    std::vector<Quad> m_pieces;         //one per cell, UltimateBoard numbering
+    std::vector<Quad> m_wonBoards;      //one per small board
+
+    osg::ref_ptr<osg::StateSet> m_xState;
+    osg::ref_ptr<osg::StateSet> m_oState;
+};
@@ -0,0 +1,143 @@
+#include "UltimateSearch.h"
+#include "GameEngine.h"
+
+#include <cmath>
+
+namespace
+{
+    //the usual UCB1 constant, sqrt(2)
+    const float Exploration = 1.41421356f;
+
+    //nodes in the pool, 4MB.  Once it's full the tree stops growing and we just keep playing out.
+    const int MaxNodes = 1 << 18;
+
+    //a game can't go deeper than every cell, plus the root
+    const int MaxDepth = UltimateBoard::NumCells + 1;
+
+    //looking at the clock every playout would cost more than the playout
+    const uint64_t CheckEvery = 64;
+}
+
+UltimateSearch::UltimateSearch(int maxPlayouts) : m_maxPlayouts(maxPlayouts), m_nodes(MaxNodes), m_numNodes(0)
+{
+}
+
+int UltimateSearch::expand(int node, const UltimateBoard& board)
+{
+    uint8_t moves[UltimateBoard::NumCells];
+    int numMoves = board.getLegalMoves(moves);
+    if (numMoves == 0 || m_numNodes + numMoves > MaxNodes)
+        return 0;
+
+    m_nodes[node].firstChild = m_numNodes;
+    m_nodes[node].numChildren = static_cast<uint8_t>(numMoves);
+    for (int i = 0; i < numMoves; ++i)
+    {
+        Node& child = m_nodes[m_numNodes++];
+        child.firstChild = -1;
+        child.numChildren = 0;
+        child.cell = moves[i];
+        child.visits = 0;
+        child.wins = 0.0f;
+    }
+    return numMoves;
+}
+
+UltimateSearch::Result UltimateSearch::decideMove(const UltimateBoard& board, const AISearchLimits& limits)
+{
+    Result result;
+    if (board.isGameOver())
+        return result;
+
+    m_numNodes = 1;
+    Node& root = m_nodes[0];
+    root.firstChild = -1;
+    root.numChildren = 0;
+    root.cell = 0;
+    root.visits = 0;
+    root.wins = 0.0f;
+    if (!expand(0, board))
+        return result;
+
+    uint64_t rng = limits.seed;
+    uint8_t rootSide = board.sideToMove;
+    int path[MaxDepth];
+
+    uint64_t playouts = 0;
+    for (; playouts < static_cast<uint64_t>(m_maxPlayouts); ++playouts)
+    {
+        if (playouts % CheckEvery == 0 && playouts && limits.shouldStop())
+            break;
+
+        //down the tree by UCB1, trying every child once before picking favourites
+        UltimateBoard position = board;
+        int node = 0;
+        int depth = 0;
+        path[depth++] = 0;
+        while (m_nodes[node].numChildren)
+        {
+            const Node& parent = m_nodes[node];
+            float logVisits = std::log(static_cast<float>(parent.visits + 1));
+            int best = parent.firstChild;
+            float bestScore = -1.0f;
+            for (int child = parent.firstChild; child < parent.firstChild + parent.numChildren; ++child)
+            {
+                const Node& candidate = m_nodes[child];
+                if (candidate.visits == 0)
+                {
+                    best = child;
+                    break;
+                }
+
+                float score = (candidate.wins / candidate.visits) + (Exploration * std::sqrt(logVisits / candidate.visits));
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = child;
+                }
+            }
+
+            node = best;
+            position.play(m_nodes[node].cell);
+            path[depth++] = node;
+            if (m_nodes[node].visits == 0)
+                break;
+        }
+
+        //a leaf we've been to before grows its children, and we go on into the first of them
+        if (m_nodes[node].visits > 0 && !position.isGameOver() && expand(node, position))
+        {
+            node = m_nodes[node].firstChild;
+            position.play(m_nodes[node].cell);
+            path[depth++] = node;
+        }
+
+        uint8_t winner = position.playout(rng);
+
+        //each node scores the game for whoever moved into it: the root's side at odd depths
+        for (int i = 0; i < depth; ++i)
+        {
+            Node& visited = m_nodes[path[i]];
+            ++visited.visits;
+            uint8_t mover = (i & 1) ? rootSide : BoardSnapshot::opponent(rootSide);
+            if (winner == mover)
+                visited.wins += 1.0f;
+            else if (winner == BoardSnapshot::Empty)
+                visited.wins += 0.5f;
+        }
+    }
+
+    //the most visited move is the one the search trusts most
+    const Node& top = m_nodes[0];
+    const Node* best = nullptr;
+    for (int child = top.firstChild; child < top.firstChild + top.numChildren; ++child)
+    {
+        if (!best || m_nodes[child].visits > best->visits)
+            best = &m_nodes[child];
+    }
+
+    result.cell = best->cell;
+    result.playouts = playouts;
+    result.winRate = best->visits ? best->wins / best->visits : 0.0;
+    return result;
+}
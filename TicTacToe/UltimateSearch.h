@@ -0,0 +1,44 @@
+#pragma once
+
+#include "AIStrategy.h"
+#include "UltimateBoard.h"
+
+#include <cinttypes>
+#include <vector>
+
+//monte carlo tree search (UCT) for ultimate tic tac toe.  Every node stores only the move that
+//got there; the board is replayed down from the root on the way in, which on bitboards is
+//cheaper than keeping a copy per node.  Nodes come out of a pool made once, so a search doesn't
+//allocate.  Plays out until the deadline, the token or maxPlayouts, whichever comes first.
+class UltimateSearch
+{
+public:
+    struct Result
+    {
+        Result() : cell(-1), playouts(0), winRate(0.0) {}
+
+        int cell;
+        uint64_t playouts;
+        double winRate;     //of the move picked, for the side that picked it
+    };
+
+    explicit UltimateSearch(int maxPlayouts = 200000);
+
+    Result decideMove(const UltimateBoard& board, const AISearchLimits& limits);
+
+protected:
+    struct Node
+    {
+        int firstChild;     //-1 until expanded
+        uint8_t numChildren;
+        uint8_t cell;
+        uint32_t visits;
+        float wins;         //for the side that made the move into this node, draws are half
+    };
+
+    int expand(int node, const UltimateBoard& board);
+
+    int m_maxPlayouts;
+    std::vector<Node> m_nodes;
+    int m_numNodes;
+};
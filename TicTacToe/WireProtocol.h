@@ -0,0 +1,246 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+
+#include <cinttypes>
+#include <cstring>
+#include <vector>
+
+//binary protocol spoken by GameServer.
+//every message is a one byte type followed by a fixed size payload, little endian, no padding.
+//no length prefix, the type tells you how big the rest is, so the reader can parse straight
+//out of its receive buffer and the writer can append straight into a reserved send buffer.
+
+enum WireMessageType : uint8_t
+{
+    //client -> server
+    WireJoinGame = 1,       //gameId u32, seat u8
+    WireLeaveGame = 2,      //gameId u32
+    WireMakeMove = 3,       //gameId u32, cell u8
+
+    //server -> client
+    WireMoveDelta = 16,     //gameId u32, generation u32, cell u8, owner u8
+    WireGameOver = 17,      //gameId u32, generation u32, winner u8 (board is empty after this)
+    WireScore = 18,         //gameId u32, playerWins u32, aiWins u32, catWins u32
+    WireMoveRejected = 19,  //gameId u32, cell u8, reason u8
+    WireSnapshot = 20       //gameId u32, generation u32, cells 3 bytes (2 bits each), usersTurn u8
+};
+
+//which side a connection sits on.  Player and Opponent line up with BoardSnapshot::Player/AI,
+//if nobody takes the Opponent seat the server's AI plays it.
+enum WireSeat : uint8_t
+{
+    WireSeatSpectator = 0,
+    WireSeatPlayer = 1,
+    WireSeatOpponent = 2
+};
+
+enum WireRejectReason : uint8_t
+{
+    WireRejectNotYourTurn = 1,
+    WireRejectBadCell = 2,
+    WireRejectSquareTaken = 3,
+    WireRejectNotSeated = 4
+};
+
+//total size on the wire including the type byte, 0 for junk
+inline size_t wireMessageSize(uint8_t type)
+{
+    switch (type)
+    {
+    case WireJoinGame:      return 1 + 4 + 1;
+    case WireLeaveGame:     return 1 + 4;
+    case WireMakeMove:      return 1 + 4 + 1;
+    case WireMoveDelta:     return 1 + 4 + 4 + 1 + 1;
+    case WireGameOver:      return 1 + 4 + 4 + 1;
+    case WireScore:         return 1 + 4 + 4 + 4 + 4;
+    case WireMoveRejected:  return 1 + 4 + 1 + 1;
+    case WireSnapshot:      return 1 + 4 + 4 + 3 + 1;
+    default:                return 0;
+    }
+}
+
+const size_t WireMaxMessageSize = 17;
+
+//decoded message.  Only the fields for the given type mean anything.
+struct WireMessage
+{
+    uint8_t type;
+    uint32_t gameId;
+    uint32_t generation;
+    uint8_t seat;
+    uint8_t cell;
+    uint8_t owner;
+    uint8_t reason;
+    uint32_t scores[3];
+    uint8_t cells[9];
+    bool usersTurn;
+};
+
+inline void wirePutU32(uint8_t* out, uint32_t value)
+{
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+inline uint32_t wireGetU32(const uint8_t* in)
+{
+    return uint32_t(in[0]) | (uint32_t(in[1]) << 8) | (uint32_t(in[2]) << 16) | (uint32_t(in[3]) << 24);
+}
+
+//grows out by size bytes and returns where to write.  Callers reserve up front so this doesn't allocate.
+inline uint8_t* wireAppend(std::vector<uint8_t>& out, size_t size)
+{
+    size_t offset = out.size();
+    out.resize(offset + size);
+    return &out[offset];
+}
+
+inline void writeJoinGame(std::vector<uint8_t>& out, uint32_t gameId, uint8_t seat)
+{
+    uint8_t* data = wireAppend(out, wireMessageSize(WireJoinGame));
+    data[0] = WireJoinGame;
+    wirePutU32(data + 1, gameId);
+    data[5] = seat;
+}
+
+inline void writeLeaveGame(std::vector<uint8_t>& out, uint32_t gameId)
+{
+    uint8_t* data = wireAppend(out, wireMessageSize(WireLeaveGame));
+    data[0] = WireLeaveGame;
+    wirePutU32(data + 1, gameId);
+}
+
+inline void writeMakeMove(std::vector<uint8_t>& out, uint32_t gameId, uint8_t cell)
+{
+    uint8_t* data = wireAppend(out, wireMessageSize(WireMakeMove));
+    data[0] = WireMakeMove;
+    wirePutU32(data + 1, gameId);
+    data[5] = cell;
+}
+
+inline void writeMoveDelta(std::vector<uint8_t>& out, uint32_t gameId, uint32_t generation, uint8_t cell, uint8_t owner)
+{
+    uint8_t* data = wireAppend(out, wireMessageSize(WireMoveDelta));
+    data[0] = WireMoveDelta;
+    wirePutU32(data + 1, gameId);
+    wirePutU32(data + 5, generation);
+    data[9] = cell;
+    data[10] = owner;
+}
+
+inline void writeGameOver(std::vector<uint8_t>& out, uint32_t gameId, uint32_t generation, uint8_t winner)
+{
+    uint8_t* data = wireAppend(out, wireMessageSize(WireGameOver));
+    data[0] = WireGameOver;
+    wirePutU32(data + 1, gameId);
+    wirePutU32(data + 5, generation);
+    data[9] = winner;
+}
+
+inline void writeScore(std::vector<uint8_t>& out, uint32_t gameId, uint32_t playerWins, uint32_t aiWins, uint32_t catWins)
+{
+    uint8_t* data = wireAppend(out, wireMessageSize(WireScore));
+    data[0] = WireScore;
+    wirePutU32(data + 1, gameId);
+    wirePutU32(data + 5, playerWins);
+    wirePutU32(data + 9, aiWins);
+    wirePutU32(data + 13, catWins);
+}
+
+inline void writeMoveRejected(std::vector<uint8_t>& out, uint32_t gameId, uint8_t cell, uint8_t reason)
+{
+    uint8_t* data = wireAppend(out, wireMessageSize(WireMoveRejected));
+    data[0] = WireMoveRejected;
+    wirePutU32(data + 1, gameId);
+    data[5] = cell;
+    data[6] = reason;
+}
+
+inline void writeSnapshot(std::vector<uint8_t>& out, uint32_t gameId, const BoardSnapshot& board)
+{
+    uint8_t* data = wireAppend(out, wireMessageSize(WireSnapshot));
+    data[0] = WireSnapshot;
+    wirePutU32(data + 1, gameId);
+    wirePutU32(data + 5, static_cast<uint32_t>(board.generation));
+
+    //2 bits a cell, 4 cells a byte
+    uint32_t packed = 0;
+    for (int i = 0; i < 9; ++i)
+        packed |= uint32_t(board.cells[i] & 0x3) << (i * 2);
+    data[9] = static_cast<uint8_t>(packed);
+    data[10] = static_cast<uint8_t>(packed >> 8);
+    data[11] = static_cast<uint8_t>(packed >> 16);
+
+    data[12] = board.usersTurn ? 1 : 0;
+}
+
+//parses one message off the front of data.  Returns the number of bytes used,
+//0 if there isn't a whole message yet, and -1 if the stream is garbage.
+//cells and owners the server sends are range checked here, clients index boards with them.
+//a MakeMove's cell isn't: the server answers a bad one with WireRejectBadCell.
+inline int readWireMessage(const uint8_t* data, size_t size, WireMessage& msg)
+{
+    if (!size)
+        return 0;
+
+    size_t messageSize = wireMessageSize(data[0]);
+    if (!messageSize)
+        return -1;
+    if (size < messageSize)
+        return 0;
+
+    msg.type = data[0];
+    msg.gameId = wireGetU32(data + 1);
+
+    switch (msg.type)
+    {
+    case WireJoinGame:
+        msg.seat = data[5];
+        break;
+    case WireLeaveGame:
+        break;
+    case WireMakeMove:
+        msg.cell = data[5];
+        break;
+    case WireMoveDelta:
+        msg.generation = wireGetU32(data + 5);
+        msg.cell = data[9];
+        msg.owner = data[10];
+        if (msg.cell >= 9 || msg.owner > BoardSnapshot::AI)
+            return -1;
+        break;
+    case WireGameOver:
+        msg.generation = wireGetU32(data + 5);
+        msg.owner = data[9];
+        if (msg.owner > BoardSnapshot::AI)
+            return -1;
+        break;
+    case WireScore:
+        msg.scores[0] = wireGetU32(data + 5);
+        msg.scores[1] = wireGetU32(data + 9);
+        msg.scores[2] = wireGetU32(data + 13);
+        break;
+    case WireMoveRejected:
+        msg.cell = data[5];
+        msg.reason = data[6];
+        break;
+    case WireSnapshot:
+    {
+        msg.generation = wireGetU32(data + 5);
+        uint32_t packed = uint32_t(data[9]) | (uint32_t(data[10]) << 8) | (uint32_t(data[11]) << 16);
+        for (int i = 0; i < 9; ++i)
+        {
+            msg.cells[i] = static_cast<uint8_t>((packed >> (i * 2)) & 0x3);
+            if (msg.cells[i] > BoardSnapshot::AI)
+                return -1;
+        }
+        msg.usersTurn = data[12] != 0;
+    }
+        break;
+    }
+
+    return static_cast<int>(messageSize);
+}
@@ -0,0 +1,23 @@
+#include "ZobristHash.h"
+#include "GameEngine.h"
+
+ZobristHash::ZobristHash(int numCells, uint64_t seed) : m_keys(numCells * 2)
+{
+    uint64_t state = seed;
+    for (auto&& key : m_keys)
+        key = GameEngine::nextRandom(state);
+}
+
+uint64_t ZobristHash::hashBoard(const uint8_t* cells) const
+{
+    uint64_t hash = 0;
+    for (int cell = 0; cell < getNumCells(); ++cell)
+        hash ^= getKey(cell, cells[cell]);
+    return hash;
+}
+
+const ZobristHash& ZobristHash::standard()
+{
+    static const ZobristHash keys(9);
+    return keys;
+}
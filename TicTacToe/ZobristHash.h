@@ -0,0 +1,38 @@
+#pragma once
+
+#include "BoardSnapshot.h"
+
+#include <cinttypes>
+#include <vector>
+
+//zobrist keys for a board of any size: a random 64 bit key for every cell and side.  A position's
+//hash is the XOR of the keys of whatever's on it, so placing a piece or taking one back is one
+//XOR and nobody ever has to walk the whole board to hash it.  The empty board hashes to 0.
+//the keys come from a fixed seed, so a position hashes the same in every run and every process.
+class ZobristHash
+{
+public:
+    static const uint64_t DefaultSeed = 0x7a6f627269737421ull;
+
+    explicit ZobristHash(int numCells, uint64_t seed = DefaultSeed);
+
+    int getNumCells() const { return static_cast<int>(m_keys.size() / 2); }
+
+    //side is a BoardSnapshot cell, Empty has no key
+    uint64_t getKey(int cell, uint8_t side) const
+    {
+        return side == BoardSnapshot::Empty ? 0 : m_keys[(cell * 2) + (side - 1)];
+    }
+
+    //puts the piece on or takes it off, it's the same thing
+    uint64_t toggle(uint64_t hash, int cell, uint8_t side) const { return hash ^ getKey(cell, side); }
+
+    //the whole board the slow way, for starting from scratch or checking the fast way
+    uint64_t hashBoard(const uint8_t* cells) const;
+
+    //the keys for the usual 3x3 board, what GameState and BoardSnapshot are hashed with
+    static const ZobristHash& standard();
+
+protected:
+    std::vector<uint64_t> m_keys;   //cell * 2 + side - 1
+};
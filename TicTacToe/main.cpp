@@ -1,17 +1,91 @@
+//network headers pull in winsock2.h, which has to beat windows.h in
+#include "GameServer.h"
+#include "LoadGenerator.h"
+#include "GameSimulation.h"
+
 #include <QtWidgets/QApplication>
 
+#include "AppBenchmarks.h"
 #include "TMainWindow.h"
 #include "TApp.h"
+#include "GraphicsThread.h"
+#include "StartupTrace.h"
+
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
 
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::start();
+
+    //headless modes, no window or GL context
+    if (argc > 1 && std::string(argv[1]) == "--server")
+        return GameServer::runFromCommandLine(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--loadgen")
+        return LoadGenerator::runFromCommandLine(argc, argv);
+    if (argc > 1 && std::string(argv[1]) == "--sim")
+        return GameSimulation::runFromCommandLine(argc, argv);
+
+    //benchmarks play games too, they get scratch data folders so the real score stays out of it
+    bool runBenchmarks = argc > 1 && std::string(argv[1]) == "--bench";
+    if (runBenchmarks)
+        QStandardPaths::setTestModeEnabled(true);
+
     //create the qapp
     TApp a(argc, argv);
+    StartupTrace::mark("app created");
 
     //create the main window
     TMainWindow w;
     w.show();
+    StartupTrace::mark("window shown");
+
+    //--startup-bench prints how long it took to get to the first frame you can click on, then quits
+    if (argc > 1 && std::string(argv[1]) == "--startup-bench")
+    {
+        QTimer* poll = new QTimer(&a);
+        QObject::connect(poll, &QTimer::timeout, [poll]() {
+            if (!StartupTrace::isFinished())
+                return;
+            poll->stop();
+
+            //let the background jobs check in too, they're part of the picture
+            QThreadPool::globalInstance()->waitForDone();
+            printf("%s", StartupTrace::toString().c_str());
+            fflush(stdout);
+            tApp->quit();
+        });
+        poll->start(1);
+    }
+
+    //--render-bench [seconds per model] times each of the viewer's threading models, then quits
+    if (argc > 1 && std::string(argv[1]) == "--render-bench")
+        a.getGraphicsThread()->startThreadingBenchmark(argc > 2 ? std::atoi(argv[2]) : 5, true);
+
+    //--bench [--filter regex] [--json path] [--min-time seconds] runs the microbenchmarks once the
+    //first frame is up, prints them (and writes Google Benchmark style JSON with --json), then quits
+    if (runBenchmarks)
+    {
+        AppBenchmarks* benchmarks = new AppBenchmarks(MicroBenchmark::parseCommandLine(argc, argv, 2), argv[0]);
+        QTimer* poll = new QTimer(&a);
+        QObject::connect(poll, &QTimer::timeout, [poll, benchmarks]() {
+            if (!StartupTrace::isFinished())
+                return;
+            poll->stop();
+            benchmarks->start();
+        });
+        QObject::connect(&a, &QApplication::aboutToQuit, [benchmarks]() {
+            benchmarks->wait();
+            delete benchmarks;
+        });
+        poll->start(1);
+    }
 
     //go go go!
     return a.exec();